@@ -3,6 +3,7 @@
 #include "OpenGL.h"
 
 #include "GCVD/image_interpolate.h"
+#include "GCVD/GLBatch.h"
 
 #include <GL/gl.h>
 #include <GL/glut.h>
@@ -11,7 +12,7 @@
 using namespace std;
 
 
-cv::Mat_<float> CalibCornerPatch::mimSharedSourceTemplate;
+const cv::Mat_<float> CalibCornerPatch::mimSharedSourceTemplate = CalibCornerPatch::MakeSharedTemplate();
 
 // This is a constructor for a (calibration) corner object.
 /// @nSideSize is the side size of the patch (by default, 20 pixels)
@@ -23,10 +24,7 @@ CalibCornerPatch::CalibCornerPatch(int nSideSize)
   mimTemplate.create(nSideSize, nSideSize);
   mimGradients.create(nSideSize, nSideSize);
   mimAngleJacs.create(nSideSize, nSideSize);
-  //if(mimSharedSourceTemplate.cols == 0)  {
-  // construct the putative corner and store in mimSharedSourceTemplate   
-  MakeSharedTemplate();
-  // }
+  // (the putative corner in mimSharedSourceTemplate is made once, see MakeSharedTemplate)
 }
 
 
@@ -154,11 +152,11 @@ bool CalibCornerPatch::IterateOnImageWithDrawing(CalibCornerPatch::Params &param
   // if G-N gave acceptable results. then draw the new corner position as a thick(5) red dot.
   if(!bReturn)
     {
-      glPointSize(5);
-      glColor3f(0,0,1);
-      glBegin(GL_POINTS);
-      glVertex2f(params.v2Pos[0], params.v2Pos[1]);
-      glEnd();
+      GLXInterface::GLBatch &batch = GLXInterface::glBatch();
+      batch.PointSize(5);
+      batch.Color(0,0,1);
+      batch.Smooth(true);
+      batch.Point(params.v2Pos[0], params.v2Pos[1]);
     }
   return bReturn;
 }
@@ -309,23 +307,24 @@ float CalibCornerPatch::Iterate(cv::Mat_<uchar> &im)
 
 
 // The following function constructs a 100 x100 PUTATIVE corner
-// and stores it in mimSharedSourceTemplate ( a float image with elements taking values 1.0 or -1.0 )
-void CalibCornerPatch::MakeSharedTemplate()
+// for mimSharedSourceTemplate ( a float image with elements taking values 1.0 or -1.0 )
+cv::Mat_<float> CalibCornerPatch::MakeSharedTemplate()
 {
   const int nSideSize = 100;
   const int nHalf = nSideSize / 2;
   
-  mimSharedSourceTemplate.create(nSideSize, nSideSize);
+  cv::Mat_<float> imTemplate(nSideSize, nSideSize);
   
   int r, c;
-  for (r = 0; r < mimSharedSourceTemplate.rows; r++)
-    for (c = 0; c < mimSharedSourceTemplate.cols; c++)
+  for (r = 0; r < imTemplate.rows; r++)
+    for (c = 0; c < imTemplate.cols; c++)
     {
       float fX = (c < nHalf) ? 1.0 : -1.0;
       float fY = (r < nHalf) ? 1.0 : -1.0;
-      mimSharedSourceTemplate(r, c) = fX * fY;
+      imTemplate(r, c) = fX * fY;
     }
   
+  return imTemplate;
 }
 
 CalibCornerPatch::Params::Params()
@@ -41,8 +41,10 @@ public:
   cv::Mat_<cv::Vec2f > mimGradients;
   cv::Mat_<cv::Vec2f > mimAngleJacs;
   
-  void MakeSharedTemplate();
-  static cv::Mat_<float> mimSharedSourceTemplate;
+  // The putative corner that all the templates are warped from. It is made once (at static initialization), and only read
+  // after that, so the patches of several detecting threads can share it.
+  static cv::Mat_<float> MakeSharedTemplate();
+  static const cv::Mat_<float> mimSharedSourceTemplate;
 
   float mdLastError;
 };
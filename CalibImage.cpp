@@ -2,9 +2,14 @@
 #include "OpenGL.h"
 #include "CalibImage.h"
 #include <stdlib.h>
+#include <mutex>
 
 #include "FAST/fast_corner.h"
+#include "FAST/fast_corner_simd.h"
+#include "FAST/nonmax_suppression.h"
 #include "GCVD/image_interpolate.h"
+#include "GCVD/GLBatch.h"
+#include "Profiling.h"
 
 #include "Persistence/instances.h"
 
@@ -14,6 +19,7 @@ using namespace std;
 using namespace FAST;
 using namespace CvUtils;
 using namespace RigidTransforms;
+using namespace GLXInterface;
 
 
 inline bool IsCorner(cv::Mat_<uchar> &im, int row, int col, int nGate)
@@ -24,7 +30,7 @@ inline bool IsCorner(cv::Mat_<uchar> &im, int row, int col, int nGate)
 
   // Find the mean intensity of the pixel ring...
   int nSum = 0;
-  static int abPixels[16];
+  int abPixels[16];
   for(int i=0; i<16; i++)
     {
       abPixels[i] = im(row + fast_pixel_ring[i].y, col + fast_pixel_ring[i].x) ;
@@ -64,6 +70,16 @@ inline bool IsCorner(cv::Mat_<uchar> &im, int row, int col, int nGate)
 
 
 
+// The original (full-frame) candidate scan: cherry-picks the pixels that pass IsCorner, in raster order,
+// keeping 5 pixels away from the borders (the ring has a radius of 3)
+void ScanCornerCandidates(cv::Mat_<uchar> &imBlurred, int nGate, std::vector<cv::Point2i> &vCorners)
+{
+  for (int r = 5; r < imBlurred.rows - 5; r++)
+    for (int c = 5; c < imBlurred.cols - 5; c++) 
+      if(IsCorner(imBlurred, r, c, nGate)) vCorners.push_back( cv::Point2i(c, r) );
+}
+
+
 // This function does the following hack (which may/may not work):
 // It rotates a thin "strip" of size 6 x 0.2 (i.e. -3 to 3 on the horizontal and -0.1 to 0.1 on the vertical)
 // about the patch point and tries to find where pixel differences from one quadrant to the mirrored quadrant (about the horizontal)
@@ -87,6 +103,7 @@ cv::Vec2f GuessInitialAngles(cv::Mat_<uchar> &im, cv::Point2i irCenter)
   double dBestGradMag = 0;
   double dGradAtBest = 0;
   cv::Vec2d irCenterv(irCenter.x, irCenter.y);
+  const double dSinConeAngle = sin(M_PI * 10.0 / 180.0);
   for(double dAngle = 0.0; dAngle < M_PI; dAngle += 0.001) {
     
       
@@ -94,15 +111,17 @@ cv::Vec2f GuessInitialAngles(cv::Mat_<uchar> &im, cv::Point2i irCenter)
       cv::Vec2d v2Perp( v2Dirn[1]       ,      -v2Dirn[0]  ); // vertical principal axis
       
       // computing a resposne for a rotated narrow strip. This might help.......
+      // (The sums are lazy expressions (see GCVD/Operators.h): each sample position is computed in one go,
+      // and only the first channel of the four interpolations is ever combined.)
       double response = 0;
       for (int k = 0; k < 10; k++) {
+      const cv::Vec2d v2Along = lazy(v2Dirn) * (k + 1.0);
+      const cv::Vec2d v2Across = lazy(v2Perp) * (k * dSinConeAngle);
       // first criterion
-      cv::Vec4d dG4 =    imInterp[irCenterv + (k + 1.0) * v2Dirn + k * sin(M_PI * 10.0 / 180.0)  * v2Perp] - 
-			 imInterp[irCenterv + (k + 1.0) * v2Dirn - k * sin(M_PI * 10.0 / 180.0)  * v2Perp] +
-			 imInterp[irCenterv - (k + 1.0) * v2Dirn - k * sin(M_PI * 10.0 / 180.0)  * v2Perp] - 
-			 imInterp[irCenterv - (k + 1.0) * v2Dirn + k * sin(M_PI * 10.0 / 180.0)  * v2Perp];
-      
-      response += dG4[0];
+      response += ( lazy(imInterp[(lazy(irCenterv) + v2Along + v2Across).eval()]) - 
+		    lazy(imInterp[(lazy(irCenterv) + v2Along - v2Across).eval()]) +
+		    lazy(imInterp[(lazy(irCenterv) - v2Along - v2Across).eval()]) - 
+		    lazy(imInterp[(lazy(irCenterv) - v2Along + v2Across).eval()]) )[0];
       }
       
       if(fabs(response) > dBestGradMag)
@@ -123,9 +142,45 @@ cv::Vec2f GuessInitialAngles(cv::Mat_<uchar> &im, cv::Point2i irCenter)
 }
 
 
+// FAST-N candidate detection for the given (run-time) N; the engine is a template on N.
+// Goes into a caller-owned arena, so nothing is allocated per frame. False if the arena overflowed.
+static bool DetectFastCandidates(const cv::Mat_<uchar> &im, fast_corner_arena &aCorners, int nN, int nBarrier)
+{
+  // There are engines for N = 4..12 only; anything else is clamped (and said once, rather than on every frame)
+  if(nN < 4 || nN > 12) {
+    static std::once_flag gRangeReported;
+    std::call_once(gRangeReported, [nN]() {
+      cout << "CalibImage: CameraCalibrator.FastN = " << nN << " is out of range; using " << (nN < 4 ? 4 : 12)
+	   << " (it should be 4..12)." << endl;
+    });
+    nN = nN < 4 ? 4 : 12;
+  }
+  
+  switch(nN) {
+    case 4: return fast_corner_detect_simd<4>(im, aCorners, nBarrier);
+    case 5: return fast_corner_detect_simd<5>(im, aCorners, nBarrier);
+    case 6: return fast_corner_detect_simd<6>(im, aCorners, nBarrier);
+    case 7: return fast_corner_detect_simd<7>(im, aCorners, nBarrier);
+    case 8: return fast_corner_detect_simd<8>(im, aCorners, nBarrier);
+    case 9: return fast_corner_detect_simd<9>(im, aCorners, nBarrier);
+    case 10: return fast_corner_detect_simd<10>(im, aCorners, nBarrier);
+    case 11: return fast_corner_detect_simd<11>(im, aCorners, nBarrier);
+    default: return fast_corner_detect_simd<12>(im, aCorners, nBarrier);
+  }
+}
+
+
 bool CalibImage::MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim)
 {
   static Persistence::pvar3<int> gvnCornerPatchSize("CameraCalibrator.CornerPatchPixelSize", 20, Persistence::SILENT);
+  
+  // The stages of the detection, timed one after the other (see Profiling.h)
+  static Profiling::Stage gStageBlur("MakeFromImage.Blur"), gStageScan("MakeFromImage.Scan"), 
+			  gStageSeed("MakeFromImage.Seed"), gStageExpand("MakeFromImage.Expand");
+  static Profiling::Stage gStageCandidates("MakeFromImage.Candidates", Profiling::COUNTER);
+  static Profiling::Stage gStageGridCorners("MakeFromImage.GridCorners", Profiling::COUNTER);
+  Profiling::ScopedTimer timer(gStageBlur); // (the copy and the blur)
+  
   mvCorners.clear();
   mvGridCorners.clear();
   
@@ -140,42 +195,95 @@ bool CalibImage::MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim)
   {
     cv::Mat_<uchar> imBlurred;
     
-    double dBlurSigma = Persistence::PV3::get<double>("CameraCalibrator.BlurSigma", 2.0, Persistence::SILENT);
-   
-    int gkerSize = (int)ceil(dBlurSigma*3.0); // where 3.0 is the default "sigmas" parameter in libCVD
-    gkerSize += (gkerSize % 2 == 0) ? 1 : 0;
+    // The per-frame parameters are read through cached handles (no map lookups), 
+    // and the Gaussian kernel is rebuilt only when the sigma changes.
+    // The handles and the kernel are per thread, since the detection may run on several workers (see FramePipeline.h).
+    static thread_local Persistence::pvar3_cached<double> gvdBlurSigma("CameraCalibrator.BlurSigma", 2.0, Persistence::SILENT);
+    static thread_local cv::Mat gBlurKernel;
+    
+    if(gvdBlurSigma.Changed()) {
+      double dBlurSigma = *gvdBlurSigma;
+      int gkerSize = (int)ceil(dBlurSigma*3.0); // where 3.0 is the default "sigmas" parameter in libCVD
+      gkerSize += (gkerSize % 2 == 0) ? 1 : 0;
+      gBlurKernel = cv::getGaussianKernel(gkerSize, dBlurSigma, CV_32F);
+    }
+    // (the same blur as cv::GaussianBlur up to rounding, minus making the kernel every time: on 8-bit images GaussianBlur
+    // has its own fixed-point path, so a pixel may come out one gray level apart)
+    cv::sepFilter2D(mim, imBlurred, -1, gBlurKernel, gBlurKernel);
     
-    cv::GaussianBlur(mim, imBlurred, cv::Size(gkerSize, gkerSize), dBlurSigma );
+    timer.Next(gStageScan);
     
     cv::Point2i irTopLeft(5,5);
     cv::Point2i irBotRight(mim.cols - irTopLeft.x, mim.rows - irTopLeft.y);
-    // Ok, now drawing points
-    glPointSize(4);
-    glColor3f(1,0,0);
-    glBegin(GL_POINTS);
+    // Ok, now drawing points (appended to the frame's batch, which is drawn all at once at the end of the frame)
+    GLBatch &batch = glBatch();
+    batch.PointSize(4);
+    batch.Color(1,0,0);
+    batch.Smooth(false);
     
     // So, this "nGate" is a threshold parameter. The larger it is, the fewer corners are to be expected
     // In effect, it is an acceptance boundary for the corner patch mean intensity in terms of its own center intensity
     // (if within the boundary, then it gets discarded, thus larger values suggest a tighter criterion)
-    int nGate = Persistence::PV3.get<int>("CameraCalibrator.MeanGate", 20, Persistence::SILENT); // 10 is a good value for some cameras, 
+    static thread_local Persistence::pvar3_cached<int> gvnMeanGate("CameraCalibrator.MeanGate", 20, Persistence::SILENT);
+    int nGate = *gvnMeanGate; // 10 is a good value for some cameras, 
 								     // but 20 may work bertter for others
     
-    // Now cherry-picking the corners and drawing them as red points in the image
-    for (int r = irTopLeft.y; r < irBotRight.y; r++)
-      for (int c = irTopLeft.x; c < irBotRight.x; c++) {
+    // The candidate front end: 
+    // 0 - The original full-frame scan with IsCorner
+    // 1 - A FAST-N pass with non-maximal suppression to shortlist pixels, and then IsCorner on the survivors only.
+    //     Checkerboard corners are saddle points with four short arcs on the ring, so N should be small (4 or 5);
+    //     the point is to get rid of the flat areas, and IsCorner takes care of the edges.
+    static thread_local Persistence::pvar3_cached<int> gvnFrontEnd("CameraCalibrator.CornerFrontEnd", 0, Persistence::SILENT);
+    static thread_local Persistence::pvar3_cached<int> gvnFastN("CameraCalibrator.FastN", 4, Persistence::SILENT);
+    static thread_local Persistence::pvar3_cached<int> gvnFastBarrier("CameraCalibrator.FastBarrier", 10, Persistence::SILENT);
+    
+    if(*gvnFrontEnd == 1) {
+      
+      // The arenas live across frames (one set per detecting thread): sized once (CameraCalibrator.FastCapacity corners),
+      // they are only reused after that.
+      // If a frame has more candidates than that, we go on with the ones found so far (the top of the image) and say so.
+      static thread_local Persistence::pvar3_cached<int> gvnFastCapacity("CameraCalibrator.FastCapacity", 20000, Persistence::SILENT);
+      static thread_local fast_corner_arena aFastCorners, aSurvivors;
+      static thread_local fast_nonmax_workspace wsNonmax;
+      aFastCorners.reserve(*gvnFastCapacity);
+      aSurvivors.reserve(*gvnFastCapacity);
+      
+      // (overflowing frames are counted in MakeFromImage.FastOverflow, and said once; it would be every frame otherwise,
+      // and from every detection worker)
+      static Profiling::Stage gStageFastOverflow("MakeFromImage.FastOverflow", Profiling::COUNTER);
+      static std::once_flag gOverflowReported;
+      bool bOverflow = !DetectFastCandidates(imBlurred, aFastCorners, *gvnFastN, *gvnFastBarrier);
+      gStageFastOverflow.Add(bOverflow ? 1 : 0);
+      if(bOverflow) {
+	int nCapacity = aFastCorners.capacity();
+	std::call_once(gOverflowReported, [nCapacity]() {
+	  cout << "CalibImage: more than " << nCapacity << " FAST candidates; raise CameraCalibrator.FastCapacity or FastBarrier." << endl;
+	});
+      }
+      // ranked by the old style score, just as fast_nonmax_with_scores does, so the same corners survive
+      compute_fast_score_old(imBlurred, aFastCorners, *gvnFastBarrier);
+      nonmax_suppression(aFastCorners, aSurvivors, wsNonmax);
+      
+      // the survivors come in raster order, so mvCorners is ordered just as with the full scan
+      for(int i=0; i<aSurvivors.size; i++) {
 	
-	if(IsCorner(imBlurred, r, c, nGate)) {
+	int r = aSurvivors.y[i];
+	int c = aSurvivors.x[i];
+	if(r < irTopLeft.y || r >= irBotRight.y || c < irTopLeft.x || c >= irBotRight.x) continue;
 	
-	    mvCorners.push_back( cv::Point2i(c, r) );
-	    
-	    baryCenter[0] += c; baryCenter[1] += r; 
-	    
-	    glVertex2i(c, r);
-	 
-	  }
+	if(IsCorner(imBlurred, r, c, nGate)) mvCorners.push_back( cv::Point2i(c, r) );
       }
+    }
+    else 
+      ScanCornerCandidates(imBlurred, nGate, mvCorners);
+    
+    // Now drawing the corners as red points in the image
+    for(unsigned int i=0; i<mvCorners.size(); i++) {
       
-    glEnd();
+      baryCenter[0] += mvCorners[i].x; baryCenter[1] += mvCorners[i].y; 
+      
+      batch.Point(mvCorners[i].x, mvCorners[i].y);
+    }
   }
   // NOTE: The above appears to be working ok... Portential corners are drawn on the image with thik red dots
   
@@ -185,7 +293,11 @@ bool CalibImage::MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim)
   //return false;
  
 
-  if((int) mvCorners.size() < Persistence::PV3.get<int>("CameraCalibrator.MinCornersForGrabbedImage", 20, Persistence::SILENT)) return false;
+  gStageCandidates.Add(mvCorners.size());
+  timer.Next(gStageSeed);
+  
+  static thread_local Persistence::pvar3_cached<int> gvnMinCorners("CameraCalibrator.MinCornersForGrabbedImage", 20, Persistence::SILENT);
+  if((int) mvCorners.size() < *gvnMinCorners) return false;
   
   // normalizing the baryCenter
   baryCenter[0] /= mvCorners.size(); baryCenter[1] /= mvCorners.size();
@@ -253,6 +365,7 @@ bool CalibImage::MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim)
   mvGridCorners[1].mInheritedSteps = mvGridCorners[2].mInheritedSteps = mvGridCorners[0].GetSteps(mvGridCorners);
    
   // The three initial grid elements are enough to find the rest of the grid 
+  timer.Next(gStageExpand);
   int nNext;
   int nSanityCounter = 0; // Stop it getting stuck in an infinite loop...
   const int nSanityCounterLimit = 500;
@@ -261,19 +374,76 @@ bool CalibImage::MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim)
       ExpandByStep(nNext);
       nSanityCounter++;
     }
+  gStageGridCorners.Add(mvGridCorners.size());
   if(nSanityCounter == nSanityCounterLimit)
     return false;
   
   DrawImageGrid();
   
   // need more than 8 grid corners to make a decent optimization of grid pose!!!! 
-  unsigned int minGridCorners = Persistence::PV3::get<int>("CameraCalibrator.MinimumGridCorners4Pose", 8, Persistence::SILENT);
+  static thread_local Persistence::pvar3_cached<int> gvnMinGridCorners("CameraCalibrator.MinimumGridCorners4Pose", 8, Persistence::SILENT);
+  unsigned int minGridCorners = *gvnMinGridCorners;
   cout << " minimum allowable corners per calibration image, " <<minGridCorners<<" and only " <<mvGridCorners.size() << " found ... "<<endl;
   if (mvGridCorners.size() < minGridCorners) return false;
   
+  BuildGridBuffers();
+  
   return true;
 }
 
+// Copies the grid and image positions of the grid corners into the SoA buffers used by the batch projection.
+// The grid does not change after MakeFromImage, so this is done once per grabbed image.
+void CalibImage::BuildGridBuffers()
+{
+  int nPoints = mvGridCorners.size();
+  mvfGridX.resize(nPoints); mvfGridY.resize(nPoints);
+  mvfMeasU.resize(nPoints); mvfMeasV.resize(nPoints);
+  for(int n=0; n<nPoints; n++) {
+    mvfGridX[n] = mvGridCorners[n].irGridPos.x;
+    mvfGridY[n] = mvGridCorners[n].irGridPos.y;
+    mvfMeasU[n] = mvGridCorners[n].Params.v2Pos[0];
+    mvfMeasV[n] = mvGridCorners[n].Params.v2Pos[1];
+  }
+  mvfCamX.resize(nPoints); mvfCamY.resize(nPoints); mvfInvZ.resize(nPoints);
+  mvfU.resize(nPoints); mvfV.resize(nPoints);
+  mvbValid.resize(nPoints);
+}
+
+// The first half of the fused kernel of Project: the rigid transformation of the grid into the camera frame and 
+// the perspective divide in one branch-free pass over the SoA buffers (so the compiler can vectorize it), 
+// followed by the batch projection of the camera. Points too close to (or behind) the camera get a zero 
+// inverse depth (rather than an inf or NaN) and are flagged invalid.
+template<class CameraModel>
+void CalibImage::ProjectGrid(GenericCamera<CameraModel> &Camera)
+{
+  if(mvfGridX.size() != mvGridCorners.size()) BuildGridBuffers();
+  const int nPoints = mvGridCorners.size();
+  if(nPoints == 0) return;
+  
+  // The world points are [x y 0]', so only the first two columns of the rotation are needed
+  const cv::Matx33f &R = mse3CamFromWorld.get_rotation().get_matrix();
+  const cv::Vec3f &t = mse3CamFromWorld.get_translation();
+  const float r00 = R(0, 0), r01 = R(0, 1), r10 = R(1, 0), r11 = R(1, 1), r20 = R(2, 0), r21 = R(2, 1);
+  const float t0 = t[0], t1 = t[1], t2 = t[2];
+  
+  const float *pfX = &mvfGridX[0], *pfY = &mvfGridY[0];
+  float *pfCamX = &mvfCamX[0], *pfCamY = &mvfCamY[0], *pfInvZ = &mvfInvZ[0];
+  unsigned char *pbValid = &mvbValid[0];
+  for(int n=0; n<nPoints; n++) {
+    const float x = r00 * pfX[n] + r01 * pfY[n] + t0;
+    const float y = r10 * pfX[n] + r11 * pfY[n] + t1;
+    const float z = r20 * pfX[n] + r21 * pfY[n] + t2;
+    const bool bInFront = z > 0.001f;
+    const float fInvZ = bInFront ? 1.0f / z : 0.0f;
+    pfCamX[n] = x * fInvZ;
+    pfCamY[n] = y * fInvZ;
+    pfInvZ[n] = fInvZ;
+    pbValid[n] = bInFront;
+  }
+  
+  Camera.ProjectBatch(pfCamX, pfCamY, nPoints, &mvfU[0], &mvfV[0], pbValid);
+}
+
 /// @nSrc The index of the current corner in the GRID corner list
 /// @nDirn The INDEX of the direction to search for a corner (0 - horizontal, 1 - vertical).
 /// CAUTION - CAUTION!!! Values of nDirn ABOVE/EQUAL to 2 are perceived as NEGATIVE DIRECTIONS
@@ -315,8 +485,11 @@ bool CalibImage::ExpandByAngle(int nSrc, int nDirn)
       cv::Vec2f v2Dirn = cv::normalize(v2Diff);
       // Now, if the angle of the recovered direction in v2Dirn with the nDirn-th direction in v2TargetDirn is above 30 degrees,
       // then skip to the next corner
-      double angularMargin = Persistence::PV3::get("CameraCalibrator.CornerSearchAngMargin", 30.0, Persistence::SILENT);
-      if( v2Dirn[0] * v2TargetDirn[0] + v2Dirn[1] * v2TargetDirn[1]   < cos(M_PI * angularMargin/ 180.0) ) continue;
+      // (this runs for every free corner, so the cosine is only recomputed when the margin changes)
+      static thread_local Persistence::pvar3_cached<double> gvdAngularMargin("CameraCalibrator.CornerSearchAngMargin", 30.0, Persistence::SILENT);
+      static thread_local double dCosAngularMargin;
+      if(gvdAngularMargin.Changed()) dCosAngularMargin = cos(M_PI * (*gvdAngularMargin) / 180.0);
+      if( v2Dirn[0] * v2TargetDirn[0] + v2Dirn[1] * v2TargetDirn[1]   < dCosAngularMargin ) continue;
       
       // Hurrah! We found a free corner in the direction of v2TargetDirn!!!!!
       // Save its distance as "best distance". The next corner in that direction should be closer. Otherwise, its just this or bust!
@@ -387,13 +560,10 @@ bool CalibImage::ExpandByAngle(int nSrc, int nDirn)
 // This function draws a 15-pixel long GREEN cross dot in the image to indicate a GRID corner 
 void CalibGridCorner::Draw()
 {
-  glLineWidth(4);
-  glColor3f(0,1,0); 
-  glEnable(GL_LINE_SMOOTH);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  
-  glBegin(GL_LINES);
+  GLBatch &batch = glBatch();
+  batch.LineWidth(4);
+  batch.Color(0,1,0); 
+  batch.Smooth(true);
   
   // right vertex
   cv::Vec2d vertex1( Params.v2Pos[0] + Params.m2Warp()(0, 0) * 15 + Params.m2Warp()(0, 1) * 0.0, 
@@ -410,13 +580,9 @@ void CalibGridCorner::Draw()
   
   
   // 'horizontal' line 
-  glVertex2d(vertex1[0], vertex1[1]);
-  glVertex2d(vertex2[0], vertex2[1]);
+  batch.Line(vertex1[0], vertex1[1], vertex2[0], vertex2[1]);
   // 'vertical' line
-  glVertex2d(vertex3[0], vertex3[1]);
-  glVertex2d(vertex4[0], vertex4[1]);
-  
-  glEnd();
+  batch.Line(vertex3[0], vertex3[1], vertex4[0], vertex4[1]);
 }
 
 // For a change, original comments give the idea (see below)...
@@ -516,6 +682,8 @@ void CalibImage::ExpandByStep(int n)
 {
   static Persistence::pvar3<double> gvdMaxStepDistFraction("CameraCalibrator.ExpandByStepMaxDistFrac", 0.4, Persistence::SILENT);
   static Persistence::pvar3<int> gvnCornerPatchSize("CameraCalibrator.CornerPatchPixelSize", 20, Persistence::SILENT);
+  static Profiling::Stage gStageExpandByStep("ExpandByStep"), gStageRefine("ExpandByStep.Refine");
+  Profiling::ScopedTimer timer(gStageExpandByStep);
   
   CalibGridCorner &gSrc = mvGridCorners[n];
   
@@ -586,7 +754,12 @@ void CalibImage::ExpandByStep(int n)
   // Now create a [patch object in order to refine its parameters with iterate
   CalibCornerPatch Patch(*gvnCornerPatchSize);
   // Run iteration for position and parameters
-  if(!Patch.IterateOnImageWithDrawing(gTarget.Params, mim)) return;
+  bool bRefined;
+  {
+    Profiling::ScopedTimer refineTimer(gStageRefine);
+    bRefined = Patch.IterateOnImageWithDrawing(gTarget.Params, mim);
+  }
+  if(!bRefined) return;
   
   // So now, having passed the iterative refinement stage, we have a brand new GRID corner and we need:
   // a) Add it to the list of Grid Corners,
@@ -616,116 +789,68 @@ void CalibImage::ExpandByStep(int n)
 // just draw the detected grid on the image (blue color)
 void CalibImage::DrawImageGrid() 
 {
-  glLineWidth(4);
-  glColor3f(0,0,1);
-  glEnable(GL_LINE_SMOOTH);
-  glEnable(GL_BLEND);
-  glBegin(GL_LINES);
+  GLBatch &batch = glBatch();
+  batch.LineWidth(4);
+  batch.Color(0,0,1);
+  batch.Smooth(true);
   // specify linear segments from each grid corner to its neighbors...
   for(int i=0; i< (int) mvGridCorners.size(); i++)
     {
       for(int dirn=0; dirn<4; dirn++)
 	if(mvGridCorners[i].aNeighborStates[dirn].val > i)
-	  {
-	    glVertex2f(mvGridCorners[i].Params.v2Pos[0], mvGridCorners[i].Params.v2Pos[1]);
-	    
-	    glVertex2f(mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].Params.v2Pos[0], 
-		       mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].Params.v2Pos[1]);
-	  }
+	  batch.Line(mvGridCorners[i].Params.v2Pos[0], mvGridCorners[i].Params.v2Pos[1],
+		     mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].Params.v2Pos[0], 
+		     mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].Params.v2Pos[1]);
     }
-  glEnd();
   
-  glPointSize(5);
-  glEnable(GL_POINT_SMOOTH);
-  glColor3f(1,1,0);
+  batch.PointSize(5);
+  batch.Color(1,1,0);
   
   // and draw points for each grid corner...
-  glBegin(GL_POINTS);
-  
   for(unsigned int i=0; i<mvGridCorners.size(); i++)
-    glVertex2f(mvGridCorners[i].Params.v2Pos[0], mvGridCorners[i].Params.v2Pos[1]);
-  
-  glEnd();
+    batch.Point(mvGridCorners[i].Params.v2Pos[0], mvGridCorners[i].Params.v2Pos[1]);
 };
 
 
 // This method draws a cool 3D projection grid from the detected grid corner locations
-void CalibImage::Draw3DGrid(ATANCamera &Camera, bool bDrawErrors)
+template<class CameraModel>
+void CalibImage::Draw3DGrid(GenericCamera<CameraModel> &Camera, bool bDrawErrors)
 {
-  glLineWidth(3);
-  glColor3f(1,0,0); // red
-  glEnable(GL_LINE_SMOOTH);
-  glEnable(GL_BLEND);
-  glBegin(GL_LINES);
+  GLBatch &batch = glBatch();
+  batch.LineWidth(3);
+  batch.Color(1,0,0); // red
+  batch.Smooth(true);
+  
+  // project all the grid corners in one go
+  ProjectGrid(Camera);
   
   // go through the registered grid corners
   for(int i=0; i< (int) mvGridCorners.size(); i++)
     {
-      // now, foreach or the four grid directions , 
+      // now, foreach or the four grid directions, draw the segment between the projections of 
+      // the corner and its neighbor (in the direction "dirn")
       for(int dirn=0; dirn<4; dirn++)
 	if(mvGridCorners[i].aNeighborStates[dirn].val > i)
 	  {
-	    // store the grid coordinates in a 3D vector 
-	    cv::Vec3f v3( mvGridCorners[i].irGridPos.x,
-			  mvGridCorners[i].irGridPos.y,
-			  0.0 );
-	    // Now, transform these coordinates into the 3D world
-	    cv::Vec3f cvec = mse3CamFromWorld * v3;// Hopefully this overload works well (havent yet tested SE3, SO3, SO2, and SE2 for bugs)...
-	    // Acquiring the 2D Euclidean projection of cvec into cvec_proj
-	    cv::Vec2f cvec_proj = cv::Vec2f(cvec[0] / cvec[2], cvec[1] / cvec[2]);;
-	    // Now turn the Euclidean projection into image projection (funny, we don't have the camera intrinsics!)
-	    cv::Vec2f m = Camera.Project(cvec_proj);
-	    // set the vertex
-	    glVertex2d(m[0], m[1]);
-	    
-	    // Now taking the grid position of the neighbor of the current current grid corner (in the direction "dirn")
-	    // and we do the same!
-	    v3[0] = mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].irGridPos.x;
-	    v3[1] = mvGridCorners[mvGridCorners[i].aNeighborStates[dirn].val].irGridPos.y;
-	    // World location
-	    cvec = mse3CamFromWorld * v3; // Hope the overload is done without mistakes...
-	    // Euclidean projection
-	    cvec_proj = cv::Vec2f(cvec[0] / cvec[2], cvec[1] / cvec[2]);
-	    // image projection
-	    m = Camera.Project(cvec_proj);
-	    // set the vertex
-	    glVertex2d(m[0], m[1]);
+	    int j = mvGridCorners[i].aNeighborStates[dirn].val;
+	    batch.Line(mvfU[i], mvfV[i], mvfU[j], mvfV[j]);
 	  }
     }
-    
-  glEnd();
 
   // draw errors
   if(bDrawErrors) {
     
-      glColor3f(1,1,0);
-      glLineWidth(1);
-      glBegin(GL_LINES);
+      batch.Color(1,1,0);
+      batch.LineWidth(1);
       // go over the grid corners again
       for(int i=0; i< (int) mvGridCorners.size(); i++)
 	{
-	  // again, transform the grid location into the 3D world and then back-project it on the image (with made-up/default intrinsics)
-	  cv::Vec3f v3( mvGridCorners[i].irGridPos.x, 
-			mvGridCorners[i].irGridPos.y,
-			0.0 );
-	  
-	  cv::Vec3f cvec = mse3CamFromWorld * v3;// Once again, SE3, SO3, SE2, SO2 classes and operators have not been fully tested for bugs.
-						 // The same goes for arithmetic operators (including ^ for cross product), so handle with care...
-	
-	  cv::Vec2f cvec_proj(cvec[0] / cvec[2], cvec[1] / cvec[2]);
-	  cv::Vec2f m = Camera.Project(cvec_proj);
-	 
-	  
-	  cv::Vec2f v2pixBackProjection = Camera.Project(m);
-	  // now the error vector is simply the difference between the v2Pos measured in the image and back-projection (aka "v2PixelsBackProjection")
-	  cv::Vec2f v2Error = mvGridCorners[i].Params.v2Pos - v2pixBackProjection;
-	  // set vertex at the backProjection point
-	  glVertex2f(v2pixBackProjection[0], v2pixBackProjection[1]);
-	  // set second vertex 10 pixels at the direction of the error away from the back-projection.
-	  glVertex2f(v2pixBackProjection[0] + 10.0 * v2Error[0], v2pixBackProjection[1] + 10.0 * v2Error[1]);
+	  // the error vector is simply the difference between the v2Pos measured in the image and the projection
+	  cv::Vec2f v2Error(mvfMeasU[i] - mvfU[i], mvfMeasV[i] - mvfV[i]);
+	  // a segment from the projection to 10 times the error away from it (in the direction of the error)
+	  batch.Line(mvfU[i], mvfV[i], 
+		     mvfU[i] + 10.0 * v2Error[0], mvfV[i] + 10.0 * v2Error[1]);
 	}
-	
-      glEnd();
     }
 };
 
@@ -741,64 +866,106 @@ cv::Point2i CalibImage::IR_from_dirn(int nDirn)
 }
 
 
+// Normalized DLT (Hartley): Estimates the homography H such that vDst ~ H * vSrc.
+// Both point sets are first translated to their centroid and scaled to an average distance of sqrt(2) from it,
+// so that the coefficients of the system are of similar magnitude. Instead of the SVD of the (2*N)x9 matrix D of the 
+// overdetermined homogeneous system D * h = 0, we accumulate the 9x9 D' * D directly (two rows per point) 
+// and take its eigenvector with the smallest eigenvalue (which is the right singular vector we were after).
+cv::Matx33d CalibImage::HomographyDLT(const vector<cv::Vec2d> &vSrc, const vector<cv::Vec2d> &vDst)
+{
+  int nPoints = vSrc.size();
+  
+  // The normalizing similarities
+  cv::Matx33d T[2];
+  const vector<cv::Vec2d> *pvPoints[2] = { &vSrc, &vDst };
+  for(int k=0; k<2; k++) {
+    
+    cv::Vec2d v2Mean(0, 0);
+    for(int n=0; n<nPoints; n++) v2Mean += (*pvPoints[k])[n];
+    v2Mean *= 1.0 / nPoints;
+    
+    double dMeanDist = 0;
+    for(int n=0; n<nPoints; n++) dMeanDist += cv::norm((*pvPoints[k])[n] - v2Mean);
+    dMeanDist /= nPoints;
+    double dScale = dMeanDist > 1e-12 ? sqrt(2.0) / dMeanDist : 1.0;
+    
+    T[k] = cv::Matx33d(dScale, 0,      -dScale * v2Mean[0],
+		       0,      dScale, -dScale * v2Mean[1],
+		       0,      0,      1);
+  }
+  
+  // Accumulate D' * D 
+  cv::Matx<double, 9, 9> m9DtD = cv::Matx<double, 9, 9>::zeros();
+  for(int n=0; n<nPoints; n++) {
+    
+      double x = T[0](0, 0) * vSrc[n][0] + T[0](0, 2);
+      double y = T[0](1, 1) * vSrc[n][1] + T[0](1, 2);
+      double u = T[1](0, 0) * vDst[n][0] + T[1](0, 2);
+      double v = T[1](1, 1) * vDst[n][1] + T[1](1, 2);
+      
+      cv::Matx<double, 1, 9> r1(x, y, 1, 0, 0, 0, -x*u, -y*u, -u);
+      cv::Matx<double, 1, 9> r2(0, 0, 0, x, y, 1, -x*v, -y*v, -v);
+      
+      m9DtD += r1.t() * r1 + r2.t() * r2;
+  }
+  
+  // The null-space (should only be one-dimenionsal) of D gives the homography; 
+  // cv::eigen sorts eigenvalues in descending order, so it is the last eigenvector.
+  cv::Mat_<double> vEigenValues, mEigenVectors;
+  cv::eigen(cv::Mat(m9DtD), vEigenValues, mEigenVectors);
+  
+  cv::Matx33d m3HNormalized(mEigenVectors(8, 0), mEigenVectors(8, 1), mEigenVectors(8, 2),
+			    mEigenVectors(8, 3), mEigenVectors(8, 4), mEigenVectors(8, 5),
+			    mEigenVectors(8, 6), mEigenVectors(8, 7), mEigenVectors(8, 8));
+  
+  // Undo the normalization: H = inv(Tdst) * Hn * Tsrc
+  return T[1].inv() * m3HNormalized * T[0];
+}
+
+
+// The homography that maps grid coordinates straight to pixel coordinates (i.e., ignoring lens distortion).
+// This is what the closed-form (Zhang) intrinsics initialization needs.
+cv::Matx33d CalibImage::GridToImageHomography()
+{
+  int nPoints = mvGridCorners.size();
+  vector<cv::Vec2d> vGrid(nPoints), vImage(nPoints);
+  for(int n=0; n<nPoints; n++) {
+    
+    vGrid[n] = cv::Vec2d(mvGridCorners[n].irGridPos.x, mvGridCorners[n].irGridPos.y);
+    vImage[n] = cv::Vec2d(mvGridCorners[n].Params.v2Pos[0], mvGridCorners[n].Params.v2Pos[1]);
+  }
+  
+  return HomographyDLT(vGrid, vImage);
+}
+
+
 // Extracts camera pose from the homography that maps the detected grid from its plane in space 
 // on to the screen/image plane 
-void CalibImage::GuessInitialPose(ATANCamera &Camera)
+template<class CameraModel>
+void CalibImage::GuessInitialPose(GenericCamera<CameraModel> &Camera)
 {
   
   // number of registered grid points
   int nPoints = mvGridCorners.size();
-  // This is the (2*N)x9 data matrix D of coefficients for the unknown 9-homography vector
-  // in the overdetermined homogeneous system: D * h = 0
   
   // ***** Just to give a little bit of intuition here... The homography maps GRID coorindates (therefore we have arbitrary scale) 
   // ***** to Euclidean cooedinates on the screen (and NOT euclidean coordinates on the grid plane as one would normally expect).
   // ***** I suppose this is so for flexibility, since scale can always be injected at any stage...
-  
-  cv::Mat_<double> m2Nx9(2*nPoints, 9); // using doubles for internal storage in LS
-  // filling m2Nx9...
+  vector<cv::Vec2d> vGrid(nPoints), vEuclidean(nPoints);
   for(int n=0; n<nPoints; n++) {
     
       // First, beck-project the image locations of the recovered grid corners onto the normalized Euclidean plane (z = 1)
       cv::Vec2f v2UnProj = Camera.UnProject(mvGridCorners[n].Params.v2Pos);
-      double u = v2UnProj[0];
-      double v = v2UnProj[1];
-      // So, now u and v are 2D Euclidean coordinates on the projection ray for z = 1.
-      
-      // Then fill in the matrix..
-      double x = mvGridCorners[n].irGridPos.x; // corner x-location in the grid! (assuming unit length in the grid!)
-      double y = mvGridCorners[n].irGridPos.y; // corner y-locatin in the grid!
-      
-      
-      
-      m2Nx9(n*2+0, 0) = x;
-      m2Nx9(n*2+0, 1) = y;
-      m2Nx9(n*2+0, 2) = 1;
-      m2Nx9(n*2+0, 3) = 0;
-      m2Nx9(n*2+0, 4) = 0;
-      m2Nx9(n*2+0, 5) = 0;
-      m2Nx9(n*2+0, 6) = -x*u;
-      m2Nx9(n*2+0, 7) = -y*u;
-      m2Nx9(n*2+0, 8) = -u;
-
-      m2Nx9(n*2+1, 0) = 0;
-      m2Nx9(n*2+1, 1) = 0;
-      m2Nx9(n*2+1, 2) = 0;
-      m2Nx9(n*2+1, 3) = x;
-      m2Nx9(n*2+1, 4) = y;
-      m2Nx9(n*2+1, 5) = 1;
-      m2Nx9(n*2+1, 6) = -x*v;
-      m2Nx9(n*2+1, 7) = -y*v;
-      m2Nx9(n*2+1, 8) = -v;
-    }
-
-  // The right null-space (should only be one-dimenionsal) of the matrix gives the homography...
-  cv::Mat_<double> U, S, Vt;
-  cv::SVD::compute(m2Nx9, S, U, Vt);
+      vEuclidean[n] = cv::Vec2d(v2UnProj[0], v2UnProj[1]);
+      // corner location in the grid! (assuming unit length in the grid!)
+      vGrid[n] = cv::Vec2d(mvGridCorners[n].irGridPos.x, mvGridCorners[n].irGridPos.y);
+  }
+  
+  cv::Matx33d m3H = HomographyDLT(vGrid, vEuclidean);
   cv::Mat_<double> m3Homography(3, 3); // the 3x3 homography
-  m3Homography(0, 0) = Vt(8, 0); m3Homography(0, 1) = Vt(8, 1); m3Homography(0, 2) = Vt(8, 2);
-  m3Homography(1, 0) = Vt(8, 3); m3Homography(1, 1) = Vt(8, 4); m3Homography(1, 2) = Vt(8, 5);
-  m3Homography(2, 0) = Vt(8, 6); m3Homography(2, 1) = Vt(8, 7); m3Homography(2, 2) = Vt(8, 8);
+  for(int r=0; r<3; r++) 
+    for(int c=0; c<3; c++) 
+      m3Homography(r, c) = m3H(r, c);
   
   
   // Fix up possibly poorly conditioned bits of the homography
@@ -830,8 +997,8 @@ void CalibImage::GuessInitialPose(ATANCamera &Camera)
 		   sqrt( 1.0 - (dLambda2 * dLambda2)) ); 
     
     //Vector<2> v2aprime = v2b * svdTopLeftBit.get_VT();
-    cv::Vec2d v2aprime(v2b[0] * Vt(0,0) + v2b[1] * Vt(1, 0), 
-		       v2b[0] * Vt(0,1) + v2b[1] * Vt(1, 1) );
+    cv::Vec2d v2aprime(v2b[0] * v2Vt(0,0) + v2b[1] * v2Vt(1, 0), 
+		       v2b[0] * v2Vt(0,1) + v2b[1] * v2Vt(1, 1) );
     
     
     //Vector<2> v2a = m3Homography[2].slice<0,2>();
@@ -854,7 +1021,7 @@ void CalibImage::GuessInitialPose(ATANCamera &Camera)
   // OK, now turn homography into something 3D ...simple gram-schmidt ortho-norm
   // Take 3x3 matrix H with column: abt
   // And add a new 3rd column: abct
-  cv::Mat_<float> mRotation(3, 3);
+  cv::Matx33f mRotation;
   cv::Vec3f vTranslation;
   //double dMag1 = sqrt(m3Homography.T()[0] * m3Homography.T()[0]);
   double dMag1 = sqrt( m3Homography(0, 0) * m3Homography(0, 0)  + 
@@ -911,61 +1078,101 @@ void CalibImage::GuessInitialPose(ATANCamera &Camera)
 
 
 
-// This function essentially fills-in the derivatives per calibration image
-vector<CalibImage::ErrorAndJacobians> CalibImage::Project(ATANCamera &Camera)
+// This function essentially fills-in the derivatives per calibration image.
+// All the grid corners go through ProjectGrid (transform, divide and projection) and the numerical camera Jacobian
+// is computed for the whole view at once. The pose Jacobian is in closed form: For a camera-frame point [x y z]',
+// with [u v] = [x/z y/z], the image motion caused by the six SE3 generators 
+// (see SE3<>::generator_field) is
+//
+//    d[u v]/dmu = [ 1/z   0   -u/z   -u*v    1+u^2  -v ]
+//                 [  0   1/z  -v/z  -1-v^2   u*v     u ]
+//
+// which is then chained with the 2x2 derivatives of the camera projection.
+template<class CameraModel>
+vector<CalibImage::ErrorAndJacobians<CameraModel::NumParams> > CalibImage::Project(GenericCamera<CameraModel> &Camera)
 {
-  vector<CalibImage::ErrorAndJacobians> vResult;
-  for(unsigned int n=0; n < mvGridCorners.size(); n++) {
-      
-      ErrorAndJacobians EAJ; 
-      
-      // First, project into image...
-      cv::Vec3f v3World(mvGridCorners[n].irGridPos.x,  mvGridCorners[n].irGridPos.y, 0.0);
-      
-      
-      cv::Vec3f v3Cam = mse3CamFromWorld * v3World;
-      
-      if(v3Cam[2] <= 0.001) continue;
-      
-      cv::Vec2f pv3Cam(v3Cam[0] / v3Cam[2], v3Cam[1] / v3Cam[2] );
-      
-      cv::Vec2f v2Image = Camera.Project(pv3Cam);
+  const int N = CameraModel::NumParams;
+  const int nPoints = mvGridCorners.size();
+  vector<ErrorAndJacobians<N> > vResult;
+  if(nPoints == 0) return vResult;
+  
+  ProjectGrid(Camera);
+  
+  // the camera Jacobian of every point, parameter-major
+  vector<float> vfDU(N * nPoints), vfDV(N * nPoints);
+  Camera.GetCameraParameterDerivs(&mvfCamX[0], &mvfCamY[0], &mvfU[0], &mvfV[0], nPoints, &vfDU[0], &vfDV[0]);
+  
+  vResult.reserve(nPoints);
+  for(int n=0; n < nPoints; n++) {
       
-      if(Camera.Invalid()) continue;
+      if(!mvbValid[n]) continue;
       
-      EAJ.v2Error = mvGridCorners[n].Params.v2Pos - v2Image;
+      ErrorAndJacobians<N> EAJ; 
+      EAJ.v2Error = cv::Vec2f(mvfMeasU[n] - mvfU[n], mvfMeasV[n] - mvfV[n]);
       
       // Now find motion jacobian..
-      double dOneOverCameraZ = 1.0 / v3Cam[2];
-      cv::Mat_<float> m2CamDerivs = Camera.GetProjectionDerivs();
-      
-      cv::Vec4f v3Cam_hom(v3Cam[0], v3Cam[1], v3Cam[2] , 1.0); // just the homogeneous version of v3Cam (aka "unproject" )
+      const double u = mvfCamX[n], v = mvfCamY[n], dOneOverCameraZ = mvfInvZ[n];
+      const cv::Matx22f m2CamDerivs = Camera.GetProjectionDerivs(cv::Vec2f(mvfCamX[n], mvfCamY[n]));
+      const double adMotion[2][6] = { { dOneOverCameraZ, 0, -u * dOneOverCameraZ, -u * v, 1 + u * u, -v },
+				      { 0, dOneOverCameraZ, -v * dOneOverCameraZ, -1 - v * v, u * v, u } };
       for(int dof=0; dof<6; dof++) {
-	  //const Vector<4> v4Motion = SE3<>::generator_field(dof, unproject(v3Cam));
-	  const cv::Vec4f v4Motion = SE3<>::generator_field(dof, v3Cam_hom);
-	  
-	  cv::Vec2f v2CamFrameMotion( (v4Motion[0] - v3Cam[0] * v4Motion[2] * dOneOverCameraZ) * dOneOverCameraZ, 
-				      (v4Motion[1] - v3Cam[1] * v4Motion[2] * dOneOverCameraZ) * dOneOverCameraZ );
-	  
-	  //EAJ.m26PoseJac.T()[dof] = m2CamDerivs * v2CamFrameMotion;
-	  EAJ.m26PoseJac(0, dof) = m2CamDerivs(0, 0) * v2CamFrameMotion[0] + m2CamDerivs(0, 1) * v2CamFrameMotion[1]; 
-	  EAJ.m26PoseJac(1, dof) = m2CamDerivs(1, 0) * v2CamFrameMotion[0] + m2CamDerivs(1, 1) * v2CamFrameMotion[1]; 
-	  
-	};
-
-      // Finally, the camera provids its own jacobian
-      EAJ.m2NCameraJac = Camera.GetCameraParameterDerivs();
+	EAJ.m26PoseJac(0, dof) = m2CamDerivs(0, 0) * adMotion[0][dof] + m2CamDerivs(0, 1) * adMotion[1][dof]; 
+	EAJ.m26PoseJac(1, dof) = m2CamDerivs(1, 0) * adMotion[0][dof] + m2CamDerivs(1, 1) * adMotion[1][dof]; 
+      }
+      
+      // Finally, the camera Jacobian of this point
+      for(int i=0; i<N; i++) {
+	EAJ.m2NCameraJac(0, i) = vfDU[i * nPoints + n];
+	EAJ.m2NCameraJac(1, i) = vfDV[i * nPoints + n];
+      }
       vResult.push_back(EAJ);
-      // just printing out the EAJ data
-      //cout <<"EAJ m26Pose Jacobian :" <<EAJ.m26PoseJac << endl;
-      //cout <<"EAJ m2Cam Jacobian : " <<EAJ.m2NCameraJac <<endl;
     }
   return vResult;
 };
 
 
+// The information on the camera parameters that this view provides once its pose is marginalized out:
+//
+//        [ A   B ]     A = sum(Jp' * Jp) (6x6), B = sum(Jp' * Jc) (6xN), C = sum(Jc' * Jc) (NxN)
+//   J'J =[       ]
+//        [ B'  C ]     S = C - B' * inv(A) * B
+//
+// S is what the view contributes to the reduced (camera-only) normal equations.
+template<class CameraModel>
+cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams> CalibImage::CameraInformation(GenericCamera<CameraModel> &Camera)
+{
+  const int N = CameraModel::NumParams;
+  vector<ErrorAndJacobians<N> > vEAJ = Project(Camera);
+  
+  cv::Matx<double, 6, 6> A = cv::Matx<double, 6, 6>::eye() * 1e-9; // a tiny bit of damping in case the pose is ill-conditioned
+  cv::Matx<double, 6, N> B = cv::Matx<double, 6, N>::zeros();
+  cv::Matx<double, N, N> C = cv::Matx<double, N, N>::zeros();
+  
+  for(unsigned int i=0; i<vEAJ.size(); i++) {
+    
+    A += vEAJ[i].m26PoseJac.t() * vEAJ[i].m26PoseJac;
+    B += vEAJ[i].m26PoseJac.t() * vEAJ[i].m2NCameraJac;
+    C += vEAJ[i].m2NCameraJac.t() * vEAJ[i].m2NCameraJac;
+  }
+  if(vEAJ.size() == 0) return C;
+  
+  return C - B.t() * A.inv(cv::DECOMP_CHOLESKY) * B;
+}
 
 
+// Explicit instantiations for the camera models we calibrate for (see CameraModels.h)
+template void CalibImage::Draw3DGrid<ATANModel>(ATANCamera &Camera, bool bDrawErrors);
+template void CalibImage::Draw3DGrid<RadTanModel>(RadTanCamera &Camera, bool bDrawErrors);
+template void CalibImage::Draw3DGrid<FisheyeModel>(FisheyeCamera &Camera, bool bDrawErrors);
 
+template void CalibImage::GuessInitialPose<ATANModel>(ATANCamera &Camera);
+template void CalibImage::GuessInitialPose<RadTanModel>(RadTanCamera &Camera);
+template void CalibImage::GuessInitialPose<FisheyeModel>(FisheyeCamera &Camera);
 
+template vector<CalibImage::ErrorAndJacobians<ATANModel::NumParams> > CalibImage::Project<ATANModel>(ATANCamera &Camera);
+template vector<CalibImage::ErrorAndJacobians<RadTanModel::NumParams> > CalibImage::Project<RadTanModel>(RadTanCamera &Camera);
+template vector<CalibImage::ErrorAndJacobians<FisheyeModel::NumParams> > CalibImage::Project<FisheyeModel>(FisheyeCamera &Camera);
 
+template cv::Matx<double, ATANModel::NumParams, ATANModel::NumParams> CalibImage::CameraInformation<ATANModel>(ATANCamera &Camera);
+template cv::Matx<double, RadTanModel::NumParams, RadTanModel::NumParams> CalibImage::CameraInformation<RadTanModel>(RadTanCamera &Camera);
+template cv::Matx<double, FisheyeModel::NumParams, FisheyeModel::NumParams> CalibImage::CameraInformation<FisheyeModel>(FisheyeCamera &Camera);
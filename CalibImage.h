@@ -3,7 +3,7 @@
 
 #ifndef __CALIB_IMAGE_H
 #define __CALIB_IMAGE_H
-#include "ATANCamera.h"
+#include "GenericCamera.h"
 #include "CalibCornerPatch.h"
 #include <vector>
 #include "GCVD/SE3.h"
@@ -41,20 +41,31 @@ public:
   bool MakeFromImage(cv::Mat_<uchar> &im, cv::Mat &cim);
   RigidTransforms::SE3<> mse3CamFromWorld;
   void DrawImageGrid();
-  void Draw3DGrid(ATANCamera &Camera, bool bDrawErrors);
-  void GuessInitialPose(ATANCamera &Camera);
+  template<class CameraModel> void Draw3DGrid(GenericCamera<CameraModel> &Camera, bool bDrawErrors);
+  template<class CameraModel> void GuessInitialPose(GenericCamera<CameraModel> &Camera);
 
-  struct ErrorAndJacobians
+  // The error and the Jacobians of a single grid corner projection.
+  // The camera Jacobian size is fixed at compile time by the camera model.
+  template<int NumCamParams> struct ErrorAndJacobians
   {
     cv::Vec2f v2Error;
-    cv::Mat_<double> m26PoseJac; // 2x6 Jacobian!
-    cv::Mat_<double> m2NCameraJac; // 2 x NUMTRACKERCAMPARAMETERS !
-    
-    // EAJ definitely needs a constructor now...
-    ErrorAndJacobians() : m26PoseJac( cv::Mat_<double>(2, 6) ), m2NCameraJac( cv::Mat_<double>(2, NUMTRACKERCAMPARAMETERS) ){}
+    cv::Matx<double, 2, 6> m26PoseJac; // 2x6 Jacobian!
+    cv::Matx<double, 2, NumCamParams> m2NCameraJac; // 2 x NumCamParams !
   };
 
-  std::vector<ErrorAndJacobians> Project(ATANCamera &Camera);
+  template<class CameraModel> std::vector<ErrorAndJacobians<CameraModel::NumParams> > Project(GenericCamera<CameraModel> &Camera);
+
+  // The information (J'J) this view carries on the camera parameters with its own pose marginalized out,
+  // i.e., the Schur complement of the pose block in the view's information matrix.
+  template<class CameraModel> cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams> CameraInformation(GenericCamera<CameraModel> &Camera);
+
+  const std::vector<CalibGridCorner>& GetGridCorners() const { return mvGridCorners; }
+
+  // The homography from the grid plane to the image (in pixels, distortion ignored)
+  cv::Matx33d GridToImageHomography();
+  
+  // Normalized DLT estimate of the homography that maps vSrc to vDst
+  static cv::Matx33d HomographyDLT(const std::vector<cv::Vec2d> &vSrc, const std::vector<cv::Vec2d> &vDst);
 
   cv::Mat_<uchar> mim;  // grayscale
   cv::Mat rgbmim;       // BGR
@@ -63,14 +74,36 @@ protected:
   std::vector<cv::Point2i> mvCorners;
   std::vector<CalibGridCorner> mvGridCorners;
   
+  // The grid corners in SoA form (one contiguous array per coordinate), filled once by MakeFromImage.
+  // The world points all lie on the z = 0 grid plane, so there is no z array.
+  std::vector<float> mvfGridX, mvfGridY; // world (grid) coordinates
+  std::vector<float> mvfMeasU, mvfMeasV; // measured image positions
+  void BuildGridBuffers();
+  
+  // Scratch buffers of the batch projection (see ProjectGrid), one entry per grid corner
+  std::vector<float> mvfCamX, mvfCamY;     // z=1 plane coordinates
+  std::vector<float> mvfInvZ;              // one over camera-frame depth
+  std::vector<float> mvfU, mvfV;           // projections in pixels
+  std::vector<unsigned char> mvbValid;     // in front of the camera and within the valid radius of the camera model
+  
+  // Transforms, divides and projects all the grid corners with the current pose and camera into the buffers above.
+  template<class CameraModel> void ProjectGrid(GenericCamera<CameraModel> &Camera);
+  
   
   bool ExpandByAngle(int nSrc, int nDirn);
   int NextToExpand();
   void ExpandByStep(int n);
   cv::Point2i IR_from_dirn(int nDirn);
  
+  friend class CalibSessionFile; // fills in the corners of views loaded from a session file
 };
 
+// The detection steps of MakeFromImage on their own (see CalibImage.cpp; the benchmarks use them):
+// The full-frame corner candidate scan of a blurred image (appends to vCorners) 
+void ScanCornerCandidates(cv::Mat_<uchar> &imBlurred, int nGate, std::vector<cv::Point2i> &vCorners);
+// The initial angles of the principal axes of the corner at irCenter
+cv::Vec2f GuessInitialAngles(cv::Mat_<uchar> &im, cv::Point2i irCenter);
+
 
 
 
@@ -0,0 +1,308 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+//
+// The optimization of the camera parameters and the view poses over a list of CalibImages:
+// the (full) Gauss-Newton step and the closed-form initialization of the intrinsics.
+// These used to be members of CameraCalibrator. They only need the views and a camera, so they live here,
+// where the offline re-optimization tool (bench/reopt.cpp) can run exactly the same code without a window,
+// a video source or a GUI.
+
+#ifndef __CALIB_OPTIMIZER_H
+#define __CALIB_OPTIMIZER_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cmath>
+
+#include "CalibImage.h"
+#include "GenericCamera.h"
+#include "GCVD/SE3.h"
+#include "Profiling.h"
+
+#include "OpenCV.h"
+
+
+// Robust kernels for the reprojection errors (iteratively reweighted least squares: each corner is weighted
+// by the kernel at its current error). The width is in pixels.
+enum RobustKernel { ROBUST_NONE = 0, ROBUST_HUBER = 1, ROBUST_CAUCHY = 2 };
+
+inline double RobustWeight(RobustKernel eKernel, double dError, double dWidth)
+{
+  switch(eKernel) {
+    case ROBUST_HUBER:  return dError <= dWidth ? 1.0 : dWidth / dError;
+    case ROBUST_CAUCHY: return 1.0 / (1.0 + (dError * dError) / (dWidth * dWidth));
+    default:            return 1.0;
+  }
+}
+
+inline const char* RobustKernelName(RobustKernel eKernel)
+{
+  switch(eKernel) {
+    case ROBUST_HUBER:  return "huber";
+    case ROBUST_CAUCHY: return "cauchy";
+    default:            return "none";
+  }
+}
+
+
+template<class CameraModel>
+class CalibOptimizer
+{
+public:
+
+  // One damped Gauss-Newton step on all the poses and the camera parameters together.
+  // dMeanPixelError is set to the RMS reprojection error (unweighted) before the step.
+  // Returns false (and changes nothing) if not a single corner projects validly.
+  static bool OptimizeOneStep(std::vector<CalibImage> &vCalibImgs, GenericCamera<CameraModel> &Camera, bool bDisableDistortion,
+			      RobustKernel eKernel, double dKernelWidth, double &dMeanPixelError);
+
+  // Closed-form (Zhang) estimate of the focal lengths and the principal point from the grid-to-image
+  // homographies of the views. Distortion is ignored (and its parameters left as they are).
+  static bool InitializeIntrinsics(std::vector<CalibImage> &vCalibImgs, GenericCamera<CameraModel> &Camera);
+};
+
+
+template<class CameraModel>
+bool CalibOptimizer<CameraModel>::OptimizeOneStep(std::vector<CalibImage> &vCalibImgs, GenericCamera<CameraModel> &Camera, bool bDisableDistortion,
+						  RobustKernel eKernel, double dKernelWidth, double &dMeanPixelError)
+{
+  // (one set of stages per camera model)
+  static Profiling::Stage gStageAccumulate("OptimizeOneStep.Accumulate"), gStageSolve("OptimizeOneStep.Solve"), 
+			  gStageUpdate("OptimizeOneStep.Update");
+  Profiling::ScopedTimer timer(gStageAccumulate);
+  
+  int nViews = vCalibImgs.size();
+  int nDim = 6 * nViews + CameraModel::NumParams;
+  int nCamParamBase = nDim - CameraModel::NumParams;
+
+  // preparing LS
+  // The information matrix
+  cv::Mat_<double> mJTJ = cv::Mat_<double>::eye(nDim, nDim);
+  // information vector
+  cv::Mat_<double> vJTe = cv::Mat_<double>::zeros(nDim, 1); // a matrix vector... Smells like Least Squares....
+
+  if(bDisableDistortion) Camera.DisableRadialDistortion();
+
+  // sum of squared errors
+  double dSumSquaredError = 0.0;
+  int nTotalMeas = 0;
+
+  // For consistency and potential error checking, I am retaining old PTAM code
+  for(int n=0; n<nViews; n++) {
+
+      int nMotionBase = n*6;
+      std::vector<CalibImage::ErrorAndJacobians<CameraModel::NumParams> > vEAJ = vCalibImgs[n].Project(Camera);
+
+      if (vEAJ.size() == 0 ) {
+	std::cout << "All point projections are invalid with current parameters. Leaving image out of the optimization..."<<std::endl;
+
+	continue;
+
+      }
+
+      // The blocks of the information matrix and vector that this view contributes to
+      cv::Mat_<double> mJTJblock6x6 = mJTJ( cv::Range(nMotionBase, nMotionBase + 6), cv::Range(nMotionBase, nMotionBase + 6) );
+      cv::Mat_<double> mJTJBlocknxn = mJTJ( cv::Range(nCamParamBase, nCamParamBase + CameraModel::NumParams),
+					    cv::Range(nCamParamBase, nCamParamBase + CameraModel::NumParams) );
+      cv::Mat_<double> mJTJBlock6xn = mJTJ( cv::Range(nMotionBase, nMotionBase + 6),
+					    cv::Range(nCamParamBase, nCamParamBase + CameraModel::NumParams) );
+      cv::Mat_<double> mJTJBlocknx6 = mJTJ( cv::Range(nCamParamBase, nCamParamBase + CameraModel::NumParams),
+					    cv::Range(nMotionBase, nMotionBase + 6) );
+      cv::Mat_<double> vJTe6 = vJTe(cv::Range(nMotionBase, nMotionBase + 6), cv::Range::all() );
+      cv::Mat_<double> vJTen = vJTe(cv::Range(nCamParamBase, nCamParamBase + CameraModel::NumParams), cv::Range::all() );
+
+      // George: Accumulating into fixed size matrices first (the size of the camera block is known at compile time)
+      // and only then dumping the sums into the big information matrix.
+      cv::Matx<double, 6, 6> m66PosePose = cv::Matx<double, 6, 6>::zeros();
+      cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams> mNNCamCam = cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams>::zeros();
+      cv::Matx<double, 6, CameraModel::NumParams> m6NPoseCam = cv::Matx<double, 6, CameraModel::NumParams>::zeros();
+      cv::Vec<double, 6> v6Pose = cv::Vec<double, 6>::all(0);
+      cv::Vec<double, CameraModel::NumParams> vNCam = cv::Vec<double, CameraModel::NumParams>::all(0);
+
+      for(unsigned int i=0; i<vEAJ.size(); i++) {
+
+	  CalibImage::ErrorAndJacobians<CameraModel::NumParams> &EAJ = vEAJ[i];
+
+	  cv::Vec2d v2Error(EAJ.v2Error[0], EAJ.v2Error[1]);
+	  double dSquaredError = EAJ.v2Error[0] * EAJ.v2Error[0] + EAJ.v2Error[1] * EAJ.v2Error[1];
+	  // (1 without a robust kernel)
+	  double dWeight = RobustWeight(eKernel, sqrt(dSquaredError), dKernelWidth);
+
+	  m66PosePose += dWeight * (EAJ.m26PoseJac.t() * EAJ.m26PoseJac);
+	  mNNCamCam += dWeight * (EAJ.m2NCameraJac.t() * EAJ.m2NCameraJac);
+	  m6NPoseCam += dWeight * (EAJ.m26PoseJac.t() * EAJ.m2NCameraJac);
+
+	  v6Pose += dWeight * (EAJ.m26PoseJac.t() * v2Error);
+	  vNCam += dWeight * (EAJ.m2NCameraJac.t() * v2Error);
+
+	  dSumSquaredError += dSquaredError;
+
+
+
+	  ++nTotalMeas;
+	}
+
+      // Now the sums go into the information matrix and vector (the off-diagonal pose/camera block appears twice: symmetric)
+      mJTJblock6x6 += cv::Mat(m66PosePose);
+      mJTJBlocknxn += cv::Mat(mNNCamCam);
+      mJTJBlock6xn += cv::Mat(m6NPoseCam);
+      mJTJBlocknx6 += cv::Mat(m6NPoseCam.t());
+      vJTe6 += cv::Mat(v6Pose);
+      vJTen += cv::Mat(vNCam);
+    };
+
+  if (nTotalMeas == 0) {
+    std::cout << "Did not manage to include a single grid corner in the optimization ! Skipping updates !" <<std::endl;
+    return false;
+  }
+
+  dMeanPixelError = sqrt(dSumSquaredError / nTotalMeas);
+
+
+  timer.Next(gStageSolve);
+  cv::Mat_<double> vUpdate(nDim, 1);
+  cv::solve(mJTJ, vJTe, vUpdate, cv::DECOMP_CHOLESKY);
+  vUpdate *= 0.1; // Slow down because highly nonlinear...
+  timer.Next(gStageUpdate);
+  for(int n=0; n<nViews; n++) {
+    cv::Mat_<double> vUslice = vUpdate(cv::Range(n*6, n*6 + 6), cv::Range::all() );
+    //vCalibImgs[n].mse3CamFromWorld = SE3<>::exp(vUpdate.slice(n * 6, 6)) * vCalibImgs[n].mse3CamFromWorld;
+    RigidTransforms::SE3<> Dse3 = RigidTransforms::SE3<>::exp( cv::Vec<float, 6>( vUslice(0, 0),
+										vUslice(1, 0),
+										vUslice(2, 0),
+										vUslice(3, 0),
+										vUslice(4, 0),
+										vUslice(5, 0) )
+							     );
+    vCalibImgs[n].mse3CamFromWorld = Dse3 * vCalibImgs[n].mse3CamFromWorld;
+
+
+  }
+  //Camera.UpdateParams(vUpdate.slice(nCamParamBase, CameraModel::NumParams));
+  cv::Vec<float, CameraModel::NumParams> Dparams;
+  for (int k = 0; k<CameraModel::NumParams; k++) Dparams[k] = vUpdate(nCamParamBase+k, 0);
+
+  Camera.UpdateParams(Dparams);
+
+  return true;
+}
+
+
+// Zhang's closed-form initialization ("A flexible new technique for camera calibration", 2000).
+// Each grid-to-image homography H = [h1 h2 h3] ~ K * [r1 r2 t] gives two linear constraints on the 
+// symmetric B = inv(K)' * inv(K) :
+//
+//      h1' * B * h2 = 0   and   h1' * B * h1 - h2' * B * h2 = 0
+//
+// With 3 or more views we solve for all of B (b = [B11 B12 B22 B13 B23 B33]) as the eigenvector of V' * V 
+// with the smallest eigenvalue. With fewer views (or if the result is not a valid K) we assume the principal point 
+// lies in the center of the image, in which case B is diagonal and there are only 2 unknowns (1 / fx^2, 1 / fy^2).
+// Pixel coordinates are first mapped to [-1, 1] around the image center (N * H) to keep the system well conditioned.
+template<class CameraModel>
+bool CalibOptimizer<CameraModel>::InitializeIntrinsics(std::vector<CalibImage> &vCalibImgs, GenericCamera<CameraModel> &Camera)
+{
+  int nViews = vCalibImgs.size();
+  if(nViews < 1) return false;
+
+  cv::Vec2f v2ImageSize = Camera.GetImageSize();
+  double dScale = 0.5 * std::max(v2ImageSize[0], v2ImageSize[1]);
+  cv::Vec2d v2Center(0.5 * v2ImageSize[0], 0.5 * v2ImageSize[1]);
+  cv::Matx33d m3N(1.0 / dScale, 0,            -v2Center[0] / dScale,
+		  0,            1.0 / dScale, -v2Center[1] / dScale,
+		  0,            0,            1);
+
+  std::vector<cv::Matx33d> vH(nViews);
+  for(int i=0; i<nViews; i++) vH[i] = m3N * vCalibImgs[i].GridToImageHomography();
+
+  double fx = 0, fy = 0, u0 = 0, v0 = 0; // in the normalized frame
+  bool bSolved = false;
+
+  if(nViews >= 3) {
+
+    // v_ij (Zhang's notation) with h_i the i-th column of H
+    cv::Matx<double, 6, 6> m6VtV = cv::Matx<double, 6, 6>::zeros();
+    for(int k=0; k<nViews; k++) {
+
+      const cv::Matx33d &H = vH[k];
+      cv::Matx<double, 1, 6> v12(H(0,0)*H(0,1), H(0,0)*H(1,1) + H(1,0)*H(0,1), H(1,0)*H(1,1),
+				 H(2,0)*H(0,1) + H(0,0)*H(2,1), H(2,0)*H(1,1) + H(1,0)*H(2,1), H(2,0)*H(2,1));
+      cv::Matx<double, 1, 6> v11(H(0,0)*H(0,0), 2*H(0,0)*H(1,0), H(1,0)*H(1,0),
+				 2*H(2,0)*H(0,0), 2*H(2,0)*H(1,0), H(2,0)*H(2,0));
+      cv::Matx<double, 1, 6> v22(H(0,1)*H(0,1), 2*H(0,1)*H(1,1), H(1,1)*H(1,1),
+				 2*H(2,1)*H(0,1), 2*H(2,1)*H(1,1), H(2,1)*H(2,1));
+      cv::Matx<double, 1, 6> vDiff = v11 - v22;
+
+      m6VtV += v12.t() * v12 + vDiff.t() * vDiff;
+    }
+
+    cv::Mat_<double> vEigenValues, mEigenVectors;
+    cv::eigen(cv::Mat(m6VtV), vEigenValues, mEigenVectors);
+    double B11 = mEigenVectors(5, 0), B12 = mEigenVectors(5, 1), B22 = mEigenVectors(5, 2),
+	   B13 = mEigenVectors(5, 3), B23 = mEigenVectors(5, 4), B33 = mEigenVectors(5, 5);
+
+    // Zhang's appendix B (the skew is dropped; our model has none)
+    double dDenom = B11 * B22 - B12 * B12;
+    if(fabs(B11) > 1e-12 && fabs(dDenom) > 1e-12) {
+
+      v0 = (B12 * B13 - B11 * B23) / dDenom;
+      double dLambda = B33 - (B13 * B13 + v0 * (B12 * B13 - B11 * B23)) / B11;
+      double dAlpha2 = dLambda / B11;
+      double dBeta2 = dLambda * B11 / dDenom;
+
+      if(dAlpha2 > 0 && dBeta2 > 0) {
+
+	fx = sqrt(dAlpha2);
+	fy = sqrt(dBeta2);
+	u0 = -B13 * dAlpha2 / dLambda;
+	// the principal point should at least be inside the image
+	bSolved = fabs(u0) < 1.0 && fabs(v0) < 1.0;
+      }
+    }
+  }
+
+  if(!bSolved) {
+
+    // Principal point in the center: solve  a * H00 * H01 + b * H10 * H11 = - H20 * H21
+    //                                       a * (H00^2 - H01^2) + b * (H10^2 - H11^2) = - (H20^2 - H21^2)
+    // in the least squares sense for a = 1 / fx^2, b = 1 / fy^2
+    cv::Matx22d m2AtA = cv::Matx22d::zeros();
+    cv::Vec2d v2Atb(0, 0);
+    for(int k=0; k<nViews; k++) {
+
+      const cv::Matx33d &H = vH[k];
+      cv::Vec2d r1(H(0,0) * H(0,1), H(1,0) * H(1,1));
+      cv::Vec2d r2(H(0,0) * H(0,0) - H(0,1) * H(0,1), H(1,0) * H(1,0) - H(1,1) * H(1,1));
+      double b1 = -H(2,0) * H(2,1);
+      double b2 = -(H(2,0) * H(2,0) - H(2,1) * H(2,1));
+
+      m2AtA += r1 * r1.t() + r2 * r2.t();
+      v2Atb += r1 * b1 + r2 * b2;
+    }
+
+    cv::Vec2d v2ab;
+    if(!cv::solve(m2AtA, v2Atb, v2ab, cv::DECOMP_SVD) || v2ab[0] <= 0 || v2ab[1] <= 0) {
+
+      std::cout << "Closed-form initialization of the intrinsics failed; starting from the current parameters." << std::endl;
+      return false;
+    }
+    fx = 1.0 / sqrt(v2ab[0]);
+    fy = 1.0 / sqrt(v2ab[1]);
+    u0 = v0 = 0;
+  }
+
+  // Back to pixels and then to the normalized parameters (see GenericCamera::RefreshParams)
+  typename GenericCamera<CameraModel>::ParamVector vParams = Camera.GetParams();
+  vParams[0] = dScale * fx / v2ImageSize[0];
+  vParams[1] = dScale * fy / v2ImageSize[1];
+  vParams[2] = (dScale * u0 + v2Center[0] + 0.5) / v2ImageSize[0];
+  vParams[3] = (dScale * v0 + v2Center[1] + 0.5) / v2ImageSize[1];
+
+  Camera.SetParams(vParams);
+  std::cout << "Closed-form initial camera parameters : " << vParams << std::endl;
+
+  return true;
+}
+
+#endif
@@ -0,0 +1,255 @@
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+
+#include "CalibSession.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace CalibSession;
+
+
+// sections start at multiples of 16 bytes
+static uint64_t Align16(uint64_t n) { return (n + 15) & ~((uint64_t) 15); }
+
+// Does a section of nCount records of nRecordSize bytes at nOffset fit in a file of nSize bytes (and start where
+// sections do)? Written so that nothing can wrap around, whatever a corrupt file says.
+static bool SectionInBounds(uint64_t nOffset, uint64_t nCount, uint64_t nRecordSize, uint64_t nSize)
+{
+  return nOffset % 16 == 0 && nOffset <= nSize && nCount <= (nSize - nOffset) / nRecordSize;
+}
+
+
+CalibSessionFile::CalibSessionFile() : mpData(NULL), mnSize(0) {}
+
+CalibSessionFile::~CalibSessionFile()
+{
+  Close();
+}
+
+void CalibSessionFile::Close()
+{
+  if(mpData != NULL) munmap(mpData, mnSize);
+  mpData = NULL;
+  mnSize = 0;
+  mimBlank.release();
+}
+
+
+bool CalibSessionFile::Open(const string &sFileName)
+{
+  Close();
+
+  int fd = open(sFileName.c_str(), O_RDONLY);
+  if(fd < 0) {
+    cout << "! Could not open session file " << sFileName << endl;
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SessionHeader)) {
+    cout << "! " << sFileName << " is too short to be a session file." << endl;
+    close(fd);
+    return false;
+  }
+  // A private mapping: pages are read in on demand, and writing to them (which nobody should do anyway)
+  // makes private copies instead of changing the file.
+  void *pData = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file alive
+  if(pData == MAP_FAILED) {
+    cout << "! Could not map session file " << sFileName << endl;
+    return false;
+  }
+  mpData = pData;
+  mnSize = st.st_size;
+
+  // Now check that we can trust the contents
+  const SessionHeader &H = Header();
+  const char *szError = NULL;
+  if(memcmp(H.acMagic, MAGIC, sizeof(MAGIC)) != 0) szError = "not a session file";
+  else if(H.nByteOrder != BYTE_ORDER_MARK) szError = "saved on a machine of different byte order";
+  else if(H.nVersion != VERSION) szError = "unsupported version";
+  else if(H.nHeaderSize < sizeof(SessionHeader) || H.nViewSize < sizeof(SessionView) || H.nCornerSize < sizeof(SessionCorner))
+    szError = "records are smaller than expected";
+  else if(H.nFileSize != mnSize) szError = "truncated (or trailing garbage)";
+  else if(H.nCameraParams > (uint32_t) MAX_CAMERA_PARAMS) szError = "too many camera parameters";
+  else if(H.nImageWidth == 0 || H.nImageHeight == 0) szError = "no image size";
+  else if(!SectionInBounds(H.nViewsOffset, H.nViews, H.nViewSize, mnSize)) szError = "the view table is out of bounds (or misaligned)";
+  else
+    for(int n=0; n<NumViews() && szError == NULL; n++) {
+      const SessionView &V = View(n);
+      if(!SectionInBounds(V.nCornersOffset, V.nCorners, H.nCornerSize, mnSize)) szError = "corners out of bounds (or misaligned)";
+      else if(V.nImageOffset != 0 && (V.nImageWidth == 0 || V.nImageHeight == 0)) szError = "empty image";
+      else if(V.nImageOffset != 0 && !SectionInBounds(V.nImageOffset, (uint64_t) V.nImageWidth * V.nImageHeight, 1, mnSize))
+	szError = "image out of bounds (or misaligned)";
+      else
+	for(unsigned int i=0; i<V.nCorners; i++)
+	  for(int dirn=0; dirn<4; dirn++) {
+	    int nNeighbor = Corner(n, i).anNeighbors[dirn];
+	    if(nNeighbor >= (int) V.nCorners || (nNeighbor < 0 && nNeighbor != N_NOT_TRIED && nNeighbor != N_FAILED))
+	      szError = "bad neighbor index";
+	  }
+    }
+  if(szError != NULL) {
+    cout << "! " << sFileName << ": " << szError << "." << endl;
+    Close();
+    return false;
+  }
+
+  if(!(H.nFlags & HAS_IMAGES)) mimBlank = cv::Mat_<uchar>(H.nImageHeight, H.nImageWidth, (uchar) 128);
+
+  return true;
+}
+
+
+const SessionView& CalibSessionFile::View(int n) const
+{
+  const char *pBase = (const char*) mpData;
+  return *(const SessionView*) (pBase + Header().nViewsOffset + (uint64_t) n * Header().nViewSize);
+}
+
+const SessionCorner& CalibSessionFile::Corner(int nView, int i) const
+{
+  const char *pBase = (const char*) mpData;
+  return *(const SessionCorner*) (pBase + View(nView).nCornersOffset + (uint64_t) i * Header().nCornerSize);
+}
+
+
+void CalibSessionFile::MakeCalibImage(int n, CalibImage &ci) const
+{
+  const SessionView &V = View(n);
+
+  ci.mvCorners.clear();
+  ci.mvGridCorners.resize(V.nCorners);
+  for(unsigned int i=0; i<V.nCorners; i++) {
+    const SessionCorner &C = Corner(n, i);
+    CalibGridCorner &gc = ci.mvGridCorners[i];
+    gc.Params.v2Pos = cv::Vec2f(C.afPos[0], C.afPos[1]);
+    gc.Params.v2Angles = cv::Vec2f(C.afAngles[0], C.afAngles[1]);
+    gc.Params.dMean = C.fMean;
+    gc.Params.dGain = C.fGain;
+    gc.irGridPos = cv::Point2i(C.anGridPos[0], C.anGridPos[1]);
+    for(int dirn=0; dirn<4; dirn++) gc.aNeighborStates[dirn].val = C.anNeighbors[dirn];
+  }
+  ci.BuildGridBuffers();
+
+  cv::Matx33f R;
+  for(int i=0; i<9; i++) R.val[i] = V.afRotation[i];
+  ci.mse3CamFromWorld.get_rotation() = RigidTransforms::SO3<>(R);
+  ci.mse3CamFromWorld.get_translation() = cv::Vec3f(V.afTranslation[0], V.afTranslation[1], V.afTranslation[2]);
+
+  // the image stays in the mapping
+  if(V.nImageOffset != 0)
+    ci.mim = cv::Mat_<uchar>(V.nImageHeight, V.nImageWidth, (uchar*) mpData + V.nImageOffset);
+  else
+    ci.mim = mimBlank;
+  ci.rgbmim.release();
+}
+
+
+bool CalibSessionFile::Save(const string &sFileName, const vector<CalibImage> &vCalibImgs,
+			    const string &sCameraModel, const vector<float> &vCameraParams,
+			    const cv::Size2i &imSize, bool bSaveImages)
+{
+  const int nViews = vCalibImgs.size();
+
+  // Work out where everything goes first
+  SessionHeader H;
+  memset(&H, 0, sizeof(H));
+  memcpy(H.acMagic, MAGIC, sizeof(MAGIC));
+  H.nVersion = VERSION;
+  H.nByteOrder = BYTE_ORDER_MARK;
+  H.nHeaderSize = sizeof(SessionHeader);
+  H.nViewSize = sizeof(SessionView);
+  H.nCornerSize = sizeof(SessionCorner);
+  H.nViews = nViews;
+  H.nImageWidth = imSize.width;
+  H.nImageHeight = imSize.height;
+  H.nFlags = bSaveImages ? HAS_IMAGES : 0;
+  H.nCameraParams = std::min((int) vCameraParams.size(), MAX_CAMERA_PARAMS);
+  strncpy(H.acCameraModel, sCameraModel.c_str(), sizeof(H.acCameraModel) - 1);
+  for(unsigned int i=0; i<H.nCameraParams; i++) H.afCameraParams[i] = vCameraParams[i];
+  H.nViewsOffset = Align16(sizeof(SessionHeader));
+
+  vector<SessionView> vViews(nViews);
+  uint64_t nOffset = Align16(H.nViewsOffset + (uint64_t) nViews * sizeof(SessionView));
+  for(int n=0; n<nViews; n++) {
+    SessionView &V = vViews[n];
+    memset(&V, 0, sizeof(V));
+    V.nCorners = vCalibImgs[n].GetGridCorners().size();
+    V.nCornersOffset = nOffset;
+    nOffset = Align16(nOffset + (uint64_t) V.nCorners * sizeof(SessionCorner));
+
+    const RigidTransforms::SE3<> &se3 = vCalibImgs[n].mse3CamFromWorld;
+    for(int i=0; i<9; i++) V.afRotation[i] = se3.get_rotation().get_matrix().val[i];
+    for(int i=0; i<3; i++) V.afTranslation[i] = se3.get_translation()[i];
+  }
+  for(int n=0; n<nViews && bSaveImages; n++) {
+    SessionView &V = vViews[n];
+    V.nImageWidth = vCalibImgs[n].mim.cols;
+    V.nImageHeight = vCalibImgs[n].mim.rows;
+    V.nImageOffset = nOffset;
+    nOffset = Align16(nOffset + (uint64_t) V.nImageWidth * V.nImageHeight);
+  }
+  H.nFileSize = nOffset;
+
+  // Now write it all in order (padding with zeros up to each offset)
+  string sTempName = sFileName + ".tmp";
+  ofstream ofs(sTempName.c_str(), ios::binary | ios::trunc);
+  if(!ofs.good()) {
+    cout << "! Could not open " << sTempName << " for writing." << endl;
+    return false;
+  }
+  static const char acZeros[16] = {0};
+  uint64_t nWritten = 0;
+  // (writes n bytes and keeps count)
+  #define SESSION_WRITE(p, n) { ofs.write((const char*) (p), (n)); nWritten += (n); }
+  #define SESSION_PAD_TO(off) { while(nWritten < (off)) SESSION_WRITE(acZeros, std::min((uint64_t) 16, (off) - nWritten)); }
+
+  SESSION_WRITE(&H, sizeof(H));
+  SESSION_PAD_TO(H.nViewsOffset);
+  if(nViews > 0) SESSION_WRITE(&vViews[0], nViews * sizeof(SessionView));
+  for(int n=0; n<nViews; n++) {
+    SESSION_PAD_TO(vViews[n].nCornersOffset);
+    const vector<CalibGridCorner> &vgc = vCalibImgs[n].GetGridCorners();
+    for(unsigned int i=0; i<vgc.size(); i++) {
+      SessionCorner C;
+      C.afPos[0] = vgc[i].Params.v2Pos[0]; C.afPos[1] = vgc[i].Params.v2Pos[1];
+      C.afAngles[0] = vgc[i].Params.v2Angles[0]; C.afAngles[1] = vgc[i].Params.v2Angles[1];
+      C.fMean = vgc[i].Params.dMean;
+      C.fGain = vgc[i].Params.dGain;
+      C.anGridPos[0] = vgc[i].irGridPos.x; C.anGridPos[1] = vgc[i].irGridPos.y;
+      for(int dirn=0; dirn<4; dirn++) C.anNeighbors[dirn] = vgc[i].aNeighborStates[dirn].val;
+      SESSION_WRITE(&C, sizeof(C));
+    }
+  }
+  for(int n=0; n<nViews && bSaveImages; n++) {
+    SESSION_PAD_TO(vViews[n].nImageOffset);
+    const cv::Mat_<uchar> &im = vCalibImgs[n].mim;
+    for(int r=0; r<im.rows; r++) SESSION_WRITE(im[r], im.cols); // row by row (the image need not be continuous)
+  }
+  SESSION_PAD_TO(H.nFileSize);
+  #undef SESSION_PAD_TO
+  #undef SESSION_WRITE
+
+  ofs.close();
+  if(ofs.fail()) {
+    cout << "! Failed writing " << sTempName << endl;
+    remove(sTempName.c_str());
+    return false;
+  }
+  // The old file (if it is mapped) stays alive until it is unmapped
+  if(rename(sTempName.c_str(), sFileName.c_str()) != 0) {
+    cout << "! Could not replace " << sFileName << " with " << sTempName << endl;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,132 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+//
+// Binary calibration session files.
+//
+// A session file keeps everything the optimization needs from the grabbed views: the grid corners of every
+// CalibImage (image position, patch angles/mean/gain, grid position and neighbor states), the pose of each view
+// at the time of saving and (optionally) the grayscale images. Loading a session skips corner detection altogether,
+// so a capture can be re-optimized later with different settings.
+//
+// The file is laid out so that it can be used in place once memory-mapped (there is no parsing):
+//
+//   SessionHeader                      at offset 0
+//   SessionView[nViews]                at Header.nViewsOffset
+//   SessionCorner[View.nCorners]       at View.nCornersOffset (the corners of a view are contiguous)
+//   image                              at View.nImageOffset (width x height bytes, no row padding; 0 if not saved)
+//
+// Every section starts at a multiple of 16 bytes and all records are fixed-size PODs (native little-endian;
+// the header carries a byte order mark and files of the other byte order are refused). The version changes
+// whenever the meaning of a record changes. The header also stores the size of each record, so that a reader
+// can still step over records that a later version extended with new fields at the end.
+
+#ifndef __CALIB_SESSION_H
+#define __CALIB_SESSION_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "CalibImage.h"
+
+#include "OpenCV.h"
+
+
+namespace CalibSession {
+
+  const char MAGIC[8] = {'G', 'C', 'A', 'L', 'S', 'E', 'S', 'S'};
+  const uint32_t VERSION = 1;
+  const uint32_t BYTE_ORDER_MARK = 0x01020304;
+  const int MAX_CAMERA_PARAMS = 16;
+  const uint32_t HAS_IMAGES = 1;     // Header flag: the views carry their grayscale images
+
+  struct SessionHeader
+  {
+    char acMagic[8];
+    uint32_t nVersion;
+    uint32_t nByteOrder;
+    uint32_t nHeaderSize;            // sizeof(SessionHeader) of the writer
+    uint32_t nViewSize;              // sizeof(SessionView) of the writer
+    uint32_t nCornerSize;            // sizeof(SessionCorner) of the writer
+    uint32_t nViews;
+    uint32_t nImageWidth;            // The image size of the camera (the corners are in pixels of this size)
+    uint32_t nImageHeight;
+    uint32_t nFlags;
+    uint32_t nCameraParams;
+    char acCameraModel[16];          // CameraModel::Name() of the calibrator that saved the session
+    float afCameraParams[MAX_CAMERA_PARAMS]; // The camera parameters at the time of saving
+    uint64_t nViewsOffset;
+    uint64_t nFileSize;
+  };
+
+  struct SessionView
+  {
+    uint64_t nCornersOffset;
+    uint64_t nImageOffset;           // 0 if the image was not saved
+    uint32_t nCorners;
+    uint32_t nImageWidth;
+    uint32_t nImageHeight;
+    uint32_t nReserved;
+    float afRotation[9];             // mse3CamFromWorld, rotation row by row
+    float afTranslation[3];          // and translation
+  };
+
+  struct SessionCorner
+  {
+    float afPos[2];                  // CalibCornerPatch::Params
+    float afAngles[2];
+    float fMean;
+    float fGain;
+    int32_t anGridPos[2];            // CalibGridCorner::irGridPos
+    int32_t anNeighbors[4];          // CalibGridCorner::aNeighborStates (neighbor index, N_NOT_TRIED or N_FAILED)
+  };
+
+  // The layout is part of the format: these must never change within a version
+  static_assert(sizeof(SessionHeader) == 144, "SessionHeader layout changed; bump CalibSession::VERSION");
+  static_assert(sizeof(SessionView) == 80, "SessionView layout changed; bump CalibSession::VERSION");
+  static_assert(sizeof(SessionCorner) == 48, "SessionCorner layout changed; bump CalibSession::VERSION");
+
+} // namespace CalibSession
+
+
+// A session file, memory-mapped (read only as far as the file is concerned: the mapping is private,
+// so writes into it - e.g., into an image - never reach the disk).
+class CalibSessionFile
+{
+public:
+  CalibSessionFile();
+  ~CalibSessionFile();
+
+  // Maps the file and checks the header and that every section lies within the file.
+  // Prints what is wrong and returns false if the file cannot be used.
+  bool Open(const std::string &sFileName);
+  void Close();
+  bool IsOpen() const { return mpData != NULL; }
+
+  const CalibSession::SessionHeader& Header() const { return *(const CalibSession::SessionHeader*) mpData; }
+  int NumViews() const { return Header().nViews; }
+  const CalibSession::SessionView& View(int n) const;
+  const CalibSession::SessionCorner& Corner(int nView, int i) const;
+
+  // Fills in a CalibImage from the n-th view: the grid corners, the pose and the image.
+  // The image is NOT copied (mim points into the mapping), so the file must be kept open as long as
+  // the CalibImage, or any copy of it, is in use. Views saved without an image share a blank one.
+  void MakeCalibImage(int n, CalibImage &ci) const;
+
+  // Writes a session. It goes to a temporary file which then replaces sFileName, so a session that
+  // is currently mapped can be saved over safely.
+  static bool Save(const std::string &sFileName, const std::vector<CalibImage> &vCalibImgs,
+		   const std::string &sCameraModel, const std::vector<float> &vCameraParams,
+		   const cv::Size2i &imSize, bool bSaveImages);
+
+private:
+  CalibSessionFile(const CalibSessionFile&);            // not copyable (owns the mapping)
+  CalibSessionFile& operator=(const CalibSessionFile&);
+
+  void *mpData;
+  size_t mnSize;
+  cv::Mat_<uchar> mimBlank;  // the image of the views that were saved without one
+};
+
+#endif
@@ -5,12 +5,16 @@
 #include "Persistence/instances.h"
 
 #include "CameraCalibrator.h"
-#include "ATANCamera.h"
+#include "FramePipeline.h"
+#include "GenericCamera.h"
 
 #include <fstream>
+#include <cstring>
 #include <stdlib.h>
 
 #include "GCVD/GLHelpers.h"
+#include "GCVD/GLBatch.h"
+#include "Profiling.h"
 
 
 
@@ -20,6 +24,16 @@ using namespace Persistence;
 
 
 
+// Creates and runs a calibrator for the given camera model
+template<class CameraModel>
+void RunCalibrator(VideoSource &videoSource)
+{
+  CameraCalibrator<CameraModel> c(videoSource);
+  
+  c.Run();
+}
+
+
 int main()
 {
   cout << "  Welcome to the George's CameraCalibrator for Tracking and Mapping" << endl;
@@ -42,11 +56,28 @@ int main()
   atexit(GUI.StopParserThread); // Clean up readline when program quits
   
   
+  // The camera model to calibrate for. "ATAN" (the PTAM FOV model), "RadTan" (k1, k2, p1, p2) or "Fisheye" (Kannala-Brandt, k1...k4)
+  string sCameraModel = PV3::get("Camera.Model", string(ATANModel::Name()), SILENT);
+  cout << "  Camera model is " << sCameraModel << endl;
+  
+  // The frames come from a camera or from a recording (see VideoSource.h)
+  std::unique_ptr<VideoSource> pVideoSource(VideoSource::Create());
+  if(!pVideoSource) {
+    cout << "! No video source. Exiting... " << endl;
+    return 1;
+  }
+  
   try
     {
-      CameraCalibrator c;
-      
-      c.Run();
+      if(sCameraModel == RadTanModel::Name())
+	RunCalibrator<RadTanModel>(*pVideoSource);
+      else if(sCameraModel == FisheyeModel::Name())
+	RunCalibrator<FisheyeModel>(*pVideoSource);
+      else {
+	if(sCameraModel != ATANModel::Name())
+	  cout << "! Unknown camera model " << sCameraModel << ". Using " << ATANModel::Name() << " instead." << endl;
+	RunCalibrator<ATANModel>(*pVideoSource);
+      }
     }
     catch(cv::Exception e)
     {
@@ -64,7 +95,8 @@ int main()
 
 
 
-CameraCalibrator::CameraCalibrator() : mGLWindow(mVideoSource.getSize(), "Camera Calibrator"), mCamera("Camera", mVideoSource.getSize())
+template<class CameraModel>
+CameraCalibrator<CameraModel>::CameraCalibrator(VideoSource &videoSource) : mVideoSource(videoSource), mGLWindow(mVideoSource.getSize(), "Camera Calibrator"), mCamera("Camera", mVideoSource.getSize())
 {
   
   
@@ -75,38 +107,83 @@ CameraCalibrator::CameraCalibrator() : mGLWindow(mVideoSource.getSize(), "Camera
   GUI.RegisterCommand("CameraCalibrator.Reset", GUICommandCallBack, this);
   GUI.RegisterCommand("CameraCalibrator.ShowNext", GUICommandCallBack, this);
   GUI.RegisterCommand("CameraCalibrator.SaveCalib", GUICommandCallBack, this);
+  GUI.RegisterCommand("CameraCalibrator.SaveSession", GUICommandCallBack, this);
+  GUI.RegisterCommand("CameraCalibrator.LoadSession", GUICommandCallBack, this);
+  GUI.RegisterCommand("CameraCalibrator.Stats", GUICommandCallBack, this);
+  GUI.RegisterCommand("CameraCalibrator.TraceStart", GUICommandCallBack, this);
+  GUI.RegisterCommand("CameraCalibrator.TraceDump", GUICommandCallBack, this);
   GUI.RegisterCommand("quit", GUICommandCallBack, this);
   GUI.RegisterCommand("exit", GUICommandCallBack, this);
   
   PV3::Register(mpvnOptimizing, "CameraCalibrator.Optimize", 0, SILENT);
   PV3::Register(mpvnShowImage, "CameraCalibrator.Show", 0, SILENT);
   PV3::Register(mpvnDisableDistortion, "CameraCalibrator.NoDistortion", 0, SILENT);
+  PV3::Register(mpvnAutoGrab, "CameraCalibrator.AutoGrab", 0, SILENT);
+  PV3::Register(mpvnIncremental, "CameraCalibrator.Incremental", 0, SILENT);
+  PV3::Register(mpvdRelinPoseThreshold, "CameraCalibrator.RelinPoseThreshold", 0.01, SILENT);
+  PV3::Register(mpvdRelinCameraThreshold, "CameraCalibrator.RelinCameraThreshold", 0.001, SILENT);
+  PV3::Register(mpvnClosedFormInit, "CameraCalibrator.ClosedFormInit", 1, SILENT);
+  PV3::Register(mpvnRobustKernel, "CameraCalibrator.RobustKernel", 0, SILENT);
+  PV3::Register(mpvdRobustWidth, "CameraCalibrator.RobustWidth", 1.0, SILENT);
+  PV3::Register(mpvdPixelNoise, "CameraCalibrator.PixelNoise", 0.3, SILENT);
+  PV3::Register(mpvdTargetSigmaPixels, "CameraCalibrator.TargetSigmaPixels", 0.0, SILENT);
+  PV3::Register(mpvdTargetSigmaDistortion, "CameraCalibrator.TargetSigmaDistortion", 0.0, SILENT);
+  PV3::Register(mpvsSessionFile, "CameraCalibrator.SessionFile", std::string("calib_session.gcs"), SILENT);
+  PV3::Register(mpvnSessionImages, "CameraCalibrator.SessionImages", 1, SILENT);
+  PV3::Register(mpvnTrace, "CameraCalibrator.Trace", 0, SILENT);
+  PV3::Register(mpvsTraceFile, "CameraCalibrator.TraceFile", std::string("calib_trace.json"), SILENT);
+  PV3::Register(mpvnDetectThreads, "CameraCalibrator.DetectThreads", 0, SILENT);
+  PV3::Register(mpvnPipelineQueueSize, "CameraCalibrator.PipelineQueueSize", 2, SILENT);
+  if(*mpvnTrace) Profiling::StartTrace();
+  mnRelinearized = 0;
     
   GUI.ParseLine("GLWindow.AddMenu CalibMenu");
   GUI.ParseLine("CalibMenu.AddMenuButton Live GrabFrame CameraCalibrator.GrabNextFrame");
   GUI.ParseLine("CalibMenu.AddMenuButton Live Reset CameraCalibrator.Reset");
   GUI.ParseLine("CalibMenu.AddMenuButton Live Optimize \"CameraCalibrator.Optimize=1\"");
   GUI.ParseLine("CalibMenu.AddMenuToggle Live NoDist CameraCalibrator.NoDistortion");
+  GUI.ParseLine("CalibMenu.AddMenuToggle Live AutoGrab CameraCalibrator.AutoGrab");
+  GUI.ParseLine("CalibMenu.AddMenuButton Live \"Load Sess\" CameraCalibrator.LoadSession");
+  GUI.ParseLine("CalibMenu.AddMenuToggle Live Stats GLWindow.ShowStats");
   GUI.ParseLine("CalibMenu.AddMenuSlider Opti \"Show Img\" CameraCalibrator.Show 0 10");
   GUI.ParseLine("CalibMenu.AddMenuButton Opti \"Show Next\" CameraCalibrator.ShowNext");
   GUI.ParseLine("CalibMenu.AddMenuButton Opti \"Grab More\" CameraCalibrator.Optimize=0 ");
   GUI.ParseLine("CalibMenu.AddMenuButton Opti Reset CameraCalibrator.Reset");
   GUI.ParseLine("CalibMenu.AddMenuToggle Opti NoDist CameraCalibrator.NoDistortion");
+  GUI.ParseLine("CalibMenu.AddMenuToggle Opti Incremental CameraCalibrator.Incremental");
   GUI.ParseLine("CalibMenu.AddMenuButton Opti Save CameraCalibrator.SaveCalib");
+  GUI.ParseLine("CalibMenu.AddMenuButton Opti \"Save Sess\" CameraCalibrator.SaveSession");
+  GUI.ParseLine("CalibMenu.AddMenuToggle Opti Stats GLWindow.ShowStats");
+  mcmdShowMenu = GUI.Resolve("CalibMenu.ShowMenu");
   Reset();
   
   
   
   cout << " Initial camera parameters : " << *mCamera.mpvvCameraParams <<endl;						 
-  cout << " Default camera parameters : " << ATANCamera::mvDefaultParams <<endl;					 
+  cout << " Default camera parameters : " << CameraModel::DefaultParams() <<endl;					 
   cout << "Image size as provided by the VideoSource object: " << mCamera.GetImageSize()[0]<<" , "<<mCamera.GetImageSize()[1]<<endl;
  
 }
 
-void CameraCalibrator::Run()
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::Run()
 {
+  static const string sLiveMenu("Live"), sOptiMenu("Opti");
+  // The stages of a frame, timed one after the other (see Profiling.h and the CameraCalibrator.Stats command)
+  static Profiling::Stage gStageGrab("Run.Grab"), gStageVideo("Run.Video"), gStageDetect("Run.Detect"),
+			  gStageOptimize("Run.Optimize"), gStageRender("Run.Render");
+  
+  // With CameraCalibrator.DetectThreads > 0, the frames are captured and the grid is detected on other threads,
+  // and this (GL) thread only draws the latest result and decides on grabbing (see FramePipeline.h).
+  // Otherwise all of it runs here, one frame at a time.
+  std::unique_ptr<FramePipeline> pPipeline;
+  if(*mpvnDetectThreads > 0) pPipeline.reset(new FramePipeline(mVideoSource, *mpvnDetectThreads, *mpvnPipelineQueueSize));
+  std::vector<FramePipeline::FramePtr> vFrames;
+  
   while(!mbDone) {
     
+      Profiling::ScopedTimer timer(gStageGrab);
+      
       // We use two versions of each video frame:
       // One black and white (for processing by the tracker etc)
       // and one RGB, for drawing.
@@ -114,9 +191,17 @@ void CameraCalibrator::Run()
       cv::Mat imFrameRGB;
       cv::Mat_<uchar> imFrameBW;
       
-      // Grab new video frame...
-      mVideoSource.GetAndFillFrameBWandRGB(imFrameBW, imFrameRGB);  
+      // Grab new video frame... (no more frames: the end of a recording, or the camera failed)
+      if(pPipeline) {
+	// (all the frames committed since the last time round, the latest last; no detection while optimizing)
+	pPipeline->SetDetecting(!*mpvnOptimizing || mvCalibImgs.size() < 1);
+	if(!pPipeline->GetFrames(vFrames)) break;
+	imFrameBW = vFrames.back()->imBW;
+	imFrameRGB = vFrames.back()->imRGB;
+      }
+      else if(!mVideoSource.GetAndFillFrameBWandRGB(imFrameBW, imFrameRGB)) break;
       
+      timer.Next(gStageVideo);
       
       // Set up openGL. more comments in the following methods in GLWindow.h ...
       mGLWindow.SetupViewport();
@@ -131,52 +216,68 @@ void CameraCalibrator::Run()
       
       if(!*mpvnOptimizing) {
 	
-	  GUI.ParseLine("CalibMenu.ShowMenu Live");
+	  mcmdShowMenu(sLiveMenu);
+	  mbConverged = false;
 	  
     
-	  // draw the grayscale image on the OpenGL canvas
-	  GLXInterface::glDrawPixelsGRAY(imFrameBW);
+	  // draw the grayscale image on the OpenGL canvas (streamed through a texture)
+	  mGLWindow.DrawVideoFrame(imFrameBW);
 	  //GLXInterface::glDrawPixelsBGR(imFrameRGB); 
 
-	  // create a Calibration image
-	  CalibImage c;
-	  // The method "MakeFromImage" does it all: 
-	  // a) Detect free lying corners and display them as red dots.
-	  // b) Pick a starting free corner and find its pose (parameters).
-	  // c) detect more corners arranged in a rectangular grid using the above starting corner.
-	  // d) Draw the grid.
-	  // If true, "MakeFromImage" has actually found a number of grid corners connected to each other 
-	  // and therefore can be used to optimize camera parameters.
-	  if(c.MakeFromImage(imFrameBW, imFrameRGB) ) {
-	      // if a frame capture was requested (frame grabbing here means, "REGISTER A GOOD CALIBRATION IMAGE" 
-	      // and NOT raw frame capturing as the name of the variable or the menu caption implies)
-	      if(mbGrabNextFrame)
-		{
-		  // keep the calibration image in the list
-		  mvCalibImgs.push_back(c);
-		 // Now work out an initial impression of camera pose from the calibration image
-		  mvCalibImgs.back().GuessInitialPose(mCamera);
-		  
-		  // draw a cool 3D projection grid
-// 		  mvCalibImgs.back().Draw3DGrid(mCamera, false);
-		  // switch back to waiting for the user to request the capture of a good caibration image
-		  mbGrabNextFrame = false;
-		  
-		  
-		};
-	    
-	    cout << "Image was 'made'"<<endl;
-	    
-	   }
+	  timer.Next(gStageDetect);
+	  
+	  if(pPipeline) {
+	    // The workers have done the detection already. Every frame in which they found a grid is a candidate view
+	    // (in frame order, until capture is done), but only the drawing of the latest frame goes on screen.
+	    for(unsigned int i=0; i<vFrames.size() && !*mpvnOptimizing; i++)
+	      if(vFrames[i]->bMade) HandleCalibImage(vFrames[i]->calibImage);
+	    GLXInterface::glBatch().Append(vFrames.back()->batch);
+	  }
+	  else {
+	    // create a Calibration image
+	    CalibImage c;
+	    // The method "MakeFromImage" does it all: 
+	    // a) Detect free lying corners and display them as red dots.
+	    // b) Pick a starting free corner and find its pose (parameters).
+	    // c) detect more corners arranged in a rectangular grid using the above starting corner.
+	    // d) Draw the grid.
+	    // If true, "MakeFromImage" has actually found a number of grid corners connected to each other 
+	    // and therefore can be used to optimize camera parameters.
+	    if(c.MakeFromImage(imFrameBW, imFrameRGB) ) HandleCalibImage(c);
+	  }
+	  
+	  timer.Next(gStageRender);
 	    
       }
       else {
 	  
 	   //cout << "Optimizing..."<<endl;
+	  timer.Next(gStageOptimize);
 	
+	  // Start the optimization from the closed-form estimate of the intrinsics (and re-guess the poses accordingly)
+	  if(!mbIntrinsicsInitialized) {
+	    
+	    if(*mpvnClosedFormInit && CalibOptimizer<CameraModel>::InitializeIntrinsics(mvCalibImgs, mCamera) ) 
+	      for(unsigned int i=0; i<mvCalibImgs.size(); i++) mvCalibImgs[i].GuessInitialPose(mCamera);
+	    
+	    mbIntrinsicsInitialized = true;
+	  }
+	  
 	  OptimizeOneStep();
+	  
+	  // Once the error stops changing, work out how well-determined the camera parameters are
+	  if(!mbConverged && fabs(mdLastMeanPixelError - mdMeanPixelError) < 1e-4 * mdMeanPixelError) {
+	    
+	    mbConverged = true;
+	    ComputeCameraCovariance(true);
+	    cout << "Converged. Camera parameter std. deviations : " << mvCameraSigmas << endl;
+	    if(CovarianceGoodEnough()) cout << "The calibration meets the target uncertainty; press \"save\"." << endl;
+	  }
+	  mdLastMeanPixelError = mdMeanPixelError;
+	  
+	  timer.Next(gStageRender);
       
-	  GUI.ParseLine("CalibMenu.ShowMenu Opti");
+	  mcmdShowMenu(sOptiMenu);
 	  int nToShow = *mpvnShowImage - 1;
 	  
 	  if(nToShow < 0) nToShow = 0;
@@ -184,12 +285,15 @@ void CameraCalibrator::Run()
 	  
 	  *mpvnShowImage = nToShow + 1;
       
-	  GLXInterface::glDrawPixelsGRAY(mvCalibImgs[nToShow].mim);
+	  mGLWindow.DrawVideoFrame(mvCalibImgs[nToShow].mim);
 	  
 	  mvCalibImgs[nToShow].Draw3DGrid(mCamera,true);
 	}
 	
       
+      // Everything the detection and the grid drawing have appended goes to the screen in one go (over the video, under the caption)
+      GLXInterface::glBatch().Flush();
+      
       ostringstream ost;
       ost << "Camera Calibration: Grabbed " << mvCalibImgs.size() << " images." << endl;
       if(!*mpvnOptimizing)
@@ -199,14 +303,28 @@ void CameraCalibrator::Run()
 	  ost << "Take enough shots (4+) at different angles to get points " << endl;
 	  ost << "into all parts of the image (corners too.) The whole grid " << endl;
 	  ost << "doesn't need to be visible so feel free to zoom in." << endl;
+	  if(*mpvnAutoGrab)
+	    ost << "Auto-grab: " << mvCalibImgs.size() << "/" << mViewSelector.Budget() << " views, " 
+		<< (int) (100 * mViewSelector.Coverage()) << "% coverage, last score " << mLastViewScore.dTotal << endl;
+	  if(mbCovarianceValid)
+	    ost << "Predicted focal length std. deviation: " << mvCameraSigmas[0] * mCamera.GetImageSize()[0] << " pixels." << endl;
 	}
       else
 	{
 	  ost << "Current RMS pixel error is " << mdMeanPixelError << endl;
+	  if(*mpvnIncremental)
+	    ost << "Incremental: re-linearized " << mnRelinearized << " of " << mvCalibImgs.size() << " views." << endl;
 	  //ost << "Current camera params are  " << PV3::get_var("Camera.Parameters") << endl;
 	  ost << "Current camera params are  " << *mCamera.mpvvCameraParams << endl;
 	  ost << "(That would be a pixel aspect ratio of " 
 	      <<  mCamera.PixelAspectRatio() << ")" << endl;
+	  if(mbCovarianceValid) {
+	    
+	    cv::Vec2f v2Size = mCamera.GetImageSize();
+	    ost << "Std. deviations (pixels): fx " << mvCameraSigmas[0] * v2Size[0] << ", fy " << mvCameraSigmas[1] * v2Size[1]
+		<< ", cx " << mvCameraSigmas[2] * v2Size[0] << ", cy " << mvCameraSigmas[3] * v2Size[1] 
+		<< (CovarianceGoodEnough() ? "  (good enough)" : "") << endl;
+	  }
 	  ost << "Check fit by looking through the grabbed images." << endl;
 	  ost << "RMS should go below 0.5, typically below 0.3 for a wide lens." << endl;
 	  ost << "Press \"save\" to save calibration to camera.cfg file and exit." << endl;
@@ -217,28 +335,87 @@ void CameraCalibrator::Run()
       mGLWindow.HandlePendingEvents();
       mGLWindow.swap_buffers();
     }
+  
+  // In trace mode, whatever has not been dumped yet goes out now
+  if(Profiling::Tracing()) {
+    Profiling::StopTrace();
+    Profiling::DumpTrace(*mpvsTraceFile);
+  }
 }
 
-void CameraCalibrator::Reset()
+// A frame in which MakeFromImage found a grid: it is kept if a grab was requested, or if auto-grab likes it
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::HandleCalibImage(CalibImage &c)
+{
+  // if a frame capture was requested (frame grabbing here means, "REGISTER A GOOD CALIBRATION IMAGE" 
+  // and NOT raw frame capturing as the name of the variable or the menu caption implies)
+  if(mbGrabNextFrame)
+    {
+      // keep the calibration image in the list
+      mvCalibImgs.push_back(c);
+      // Now work out an initial impression of camera pose from the calibration image
+      mvCalibImgs.back().GuessInitialPose(mCamera);
+      // let the selector know about it, so that auto-grabbed views are scored against it
+      mViewSelector.Add(mvCalibImgs.back(), mCamera);
+      CheckCaptureDone();
+      
+      // draw a cool 3D projection grid
+//       mvCalibImgs.back().Draw3DGrid(mCamera, false);
+      // switch back to waiting for the user to request the capture of a good caibration image
+      mbGrabNextFrame = false;
+    }
+  // Otherwise, in auto-grab mode the view is kept only if it improves coverage, 
+  // pose diversity or the information on the camera parameters enough (and we are within budget).
+  else if(*mpvnAutoGrab && !mViewSelector.BudgetExhausted(mvCalibImgs.size()) ) 
+    {
+      c.GuessInitialPose(mCamera);
+      mLastViewScore = mViewSelector.Score(c, mCamera);
+      if(mViewSelector.Accept(mLastViewScore, mvCalibImgs.size()) ) {
+	
+	mvCalibImgs.push_back(c);
+	mViewSelector.Add(mvCalibImgs.back(), mCamera);
+	cout << "Auto-grabbed view " << mvCalibImgs.size() << " with score " << mLastViewScore.dTotal 
+	     << " (coverage " << mLastViewScore.dCoverage << ", diversity " << mLastViewScore.dDiversity 
+	     << " rad, information gain " << mLastViewScore.dInfoGain << ")" << endl;
+	CheckCaptureDone();
+      }
+    }
+  
+  cout << "Image was 'made'"<<endl;
+}
+
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::Reset()
 {
   
-  PV3::get<cv::Vec<float, NUMTRACKERCAMPARAMETERS> >("Camera.Parameters", ATANCamera::mvDefaultParams, SILENT);
+  PV3::get<cv::Vec<float, CameraModel::NumParams> >(mCamera.ParamsName(), CameraModel::DefaultParams(), SILENT);
   
   
   if(*mpvnDisableDistortion) mCamera.DisableRadialDistortion();
+  else mCamera.EnableRadialDistortion();
   
   mCamera.SetImageSize(mVideoSource.getSize());
   mbGrabNextFrame =false;
   *mpvnOptimizing = false;
   mvCalibImgs.clear();
+  mpSession.reset(); // (only now that no view refers to its images)
+  mViewSelector.Reset();
+  mLastViewScore = ViewScore();
+  mvViewLins.clear();
+  mbIntrinsicsInitialized = false;
+  mbCovarianceValid = false;
+  mbConverged = false;
+  mdLastMeanPixelError = 0;
 }
 
-void CameraCalibrator::GUICommandCallBack(void* ptr, string sCommand, string sParams)
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::GUICommandCallBack(void* ptr, string sCommand, string sParams)
 {
-  ((CameraCalibrator*) ptr)->GUICommandHandler(sCommand, sParams);
+  ((CameraCalibrator<CameraModel>*) ptr)->GUICommandHandler(sCommand, sParams);
 }
 
-void CameraCalibrator::GUICommandHandler(string sCommand, string sParams)  // Called by the callback func..
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::GUICommandHandler(string sCommand, string sParams)  // Called by the callback func..
 {
   if(sCommand=="CameraCalibrator.Reset")
     {
@@ -259,13 +436,20 @@ void CameraCalibrator::GUICommandHandler(string sCommand, string sParams)  // Ca
     }
   if(sCommand=="CameraCalibrator.SaveCalib")
     {
-      cout << "  Camera calib is " << PV3::get_var("Camera.Parameters") << endl;
+      // the standard deviations go along with the parameters
+      if(!mbConverged) ComputeCameraCovariance(true);
+      std::string sSigmaName = mCamera.ParamsName() + "Sigma";
+      PV3::get<typename GenericCamera<CameraModel>::ParamVector>(sSigmaName, CameraModel::DefaultParams(), SILENT) = mvCameraSigmas;
+      
+      cout << "  Camera calib is " << PV3::get_var(mCamera.ParamsName()) << endl;
       cout << "  Saving camera calib to camera.cfg..." << endl;
       ofstream ofs("camera.cfg");
       if(ofs.good())
 	{
 	  
-	  PV3::PrintVar("Camera.Parameters", ofs);
+	  ofs << "Camera.Model=" << CameraModel::Name() << endl;
+	  PV3::PrintVar(mCamera.ParamsName(), ofs);
+	  PV3::PrintVar(sSigmaName, ofs);
 	  
 	  ofs.close();
 	  cout << "  .. saved."<< endl;
@@ -273,11 +457,41 @@ void CameraCalibrator::GUICommandHandler(string sCommand, string sParams)  // Ca
       else
 	{
 	  cout <<"! Could not open camera.cfg for writing." << endl;
-	  PV3.PrintVar("Camera.Parameters", cout);
+	  cout << "Camera.Model=" << CameraModel::Name() << endl;
+	  PV3.PrintVar(mCamera.ParamsName(), cout);
+	  PV3.PrintVar(sSigmaName, cout);
 	  cout <<"  Copy-paste above line to settings.cfg or camera.cfg! " << endl;
 	}
       mbDone = true;
     }
+  if(sCommand=="CameraCalibrator.SaveSession")
+    {
+      SaveSession(sParams.empty() ? *mpvsSessionFile : sParams);
+      return;
+    }
+  if(sCommand=="CameraCalibrator.LoadSession")
+    {
+      LoadSession(sParams.empty() ? *mpvsSessionFile : sParams);
+      return;
+    }
+  if(sCommand=="CameraCalibrator.Stats")
+    {
+      // "CameraCalibrator.Stats reset" starts the statistics over
+      if(sParams == "reset") Profiling::Reset();
+      else cout << Profiling::Report();
+      return;
+    }
+  if(sCommand=="CameraCalibrator.TraceStart")
+    {
+      Profiling::StartTrace();
+      return;
+    }
+  if(sCommand=="CameraCalibrator.TraceDump")
+    {
+      Profiling::StopTrace();
+      Profiling::DumpTrace(sParams.empty() ? *mpvsTraceFile : sParams);
+      return;
+    }
   if(sCommand=="exit" || sCommand=="quit")
     {
       mbDone = true;
@@ -285,148 +499,305 @@ void CameraCalibrator::GUICommandHandler(string sCommand, string sParams)  // Ca
 }
 
 
-// Optimize camera parameters using the list of selected calibratin images
-void CameraCalibrator::OptimizeOneStep()
+template<class CameraModel>
+bool CameraCalibrator<CameraModel>::SaveSession(const std::string &sFileName)
 {
+  if(mvCalibImgs.empty()) {
+    cout << "! No views to save." << endl;
+    return false;
+  }
+  const typename GenericCamera<CameraModel>::ParamVector &vParams = mCamera.GetParams();
+  vector<float> vCameraParams(vParams.val, vParams.val + CameraModel::NumParams);
+  cv::Vec2f v2Size = mCamera.GetImageSize();
   
-  int nViews = mvCalibImgs.size();
-  int nDim = 6 * nViews + NUMTRACKERCAMPARAMETERS;
-  int nCamParamBase = nDim - NUMTRACKERCAMPARAMETERS;
+  cout << "  Saving " << mvCalibImgs.size() << " views to " << sFileName << "..." << endl;
+  if(!CalibSessionFile::Save(sFileName, mvCalibImgs, CameraModel::Name(), vCameraParams,
+			     cv::Size2i((int) v2Size[0], (int) v2Size[1]), *mpvnSessionImages != 0) ) 
+    return false;
+  cout << "  .. saved." << endl;
+  return true;
+}
+
+template<class CameraModel>
+bool CameraCalibrator<CameraModel>::LoadSession(const std::string &sFileName)
+{
+  std::shared_ptr<CalibSessionFile> pSession(new CalibSessionFile);
+  if(!pSession->Open(sFileName)) return false;
+  const CalibSession::SessionHeader &H = pSession->Header();
   
-  // preparing LS
-  // The information matrix
-  cv::Mat_<double> mJTJ = cv::Mat_<double>::eye(nDim, nDim);
-  // information vector
-  cv::Mat_<double> vJTe = cv::Mat_<double>::zeros(nDim, 1); // a matrix vector... Smells like Least Squares....
+  Reset();
+  mpSession = pSession;
   
-  if(*mpvnDisableDistortion) mCamera.DisableRadialDistortion();
+  // The corners are in pixels of the image size they were detected in
+  cv::Size2i imSize(H.nImageWidth, H.nImageHeight);
+  if(imSize != mVideoSource.getSize())
+    cout << "  (The session was captured at " << imSize.width << "x" << imSize.height << ", not at the video size.)" << endl;
+  mCamera.SetImageSize(imSize);
+  
+  // Start from the saved camera parameters if they are for this model
+  std::string sModel(H.acCameraModel, strnlen(H.acCameraModel, sizeof(H.acCameraModel)));
+  if(sModel == CameraModel::Name() && H.nCameraParams == (uint32_t) CameraModel::NumParams) {
+    typename GenericCamera<CameraModel>::ParamVector vParams;
+    for(int i=0; i<CameraModel::NumParams; i++) vParams[i] = H.afCameraParams[i];
+    mCamera.SetParams(vParams);
+    mbIntrinsicsInitialized = true; // (and the poses were saved with them)
+  }
+  else
+    cout << "! The session was saved with the " << sModel << " camera model; starting from the current " 
+	 << CameraModel::Name() << " parameters instead." << endl;
+  
+  mvCalibImgs.resize(pSession->NumViews());
+  for(int n=0; n<pSession->NumViews(); n++) {
+    pSession->MakeCalibImage(n, mvCalibImgs[n]);
+    mViewSelector.Add(mvCalibImgs[n], mCamera);
+  }
+  *mpvnShowImage = 1;
+  
+  cout << "  Loaded " << mvCalibImgs.size() << " views from " << sFileName 
+       << ((H.nFlags & CalibSession::HAS_IMAGES) ? "." : " (without images).") << endl;
+  return true;
+}
 
-  // sum of squared errors
-  double dSumSquaredError = 0.0;
-  int nTotalMeas = 0;
+
+// Optimize camera parameters using the list of selected calibratin images
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::OptimizeOneStep()
+{
   
-  cv::Mat_<double> mv2Error(2, 1); // temporary storage for v2error as a 2x1 matrix (to accommodate multiplications)
+  if(*mpvnIncremental) {
+    OptimizeOneStepIncremental();
+    return;
+  }
+  // The full step moves all poses without keeping track of the drift, so the incremental caches are useless now
+  mvViewLins.clear();
   
-  // For consistency and potential error checking, I am retaining old PTAM code
-  for(int n=0; n<nViews; n++) {
-    
-      int nMotionBase = n*6;
-      vector<CalibImage::ErrorAndJacobians> vEAJ = mvCalibImgs[n].Project(mCamera);
+  CalibOptimizer<CameraModel>::OptimizeOneStep(mvCalibImgs, mCamera, *mpvnDisableDistortion != 0, 
+					       (RobustKernel) *mpvnRobustKernel, *mpvdRobustWidth, mdMeanPixelError);
+};
+
+
+// Linearize view n at the current pose and camera parameters, i.e., cache its blocks of J'J and J'e
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::LinearizeView(int n)
+{
+  const int N = CameraModel::NumParams;
+  ViewLinearization &L = mvViewLins[n];
   
-      if (vEAJ.size() == 0 ) {
-	cout << "All point projections are invalid with current parameters. Leaving image out of the optimization..."<<endl;
-	
-	continue;
-	
-      }
+  vector<CalibImage::ErrorAndJacobians<N> > vEAJ = mvCalibImgs[n].Project(mCamera);
+  
+  L.m66A = cv::Matx<double, 6, 6>::zeros();
+  L.m6NB = cv::Matx<double, 6, N>::zeros();
+  L.mNNC = cv::Matx<double, N, N>::zeros();
+  L.v6bp = cv::Vec<double, 6>::all(0);
+  L.vNbc = cv::Vec<double, N>::all(0);
+  L.dSumSquaredError = 0;
+  
+  for(unsigned int i=0; i<vEAJ.size(); i++) {
+    
+    CalibImage::ErrorAndJacobians<N> &EAJ = vEAJ[i];
+    cv::Vec2d v2Error(EAJ.v2Error[0], EAJ.v2Error[1]);
+    
+    L.m66A += EAJ.m26PoseJac.t() * EAJ.m26PoseJac;
+    L.m6NB += EAJ.m26PoseJac.t() * EAJ.m2NCameraJac;
+    L.mNNC += EAJ.m2NCameraJac.t() * EAJ.m2NCameraJac;
+    L.v6bp += EAJ.m26PoseJac.t() * v2Error;
+    L.vNbc += EAJ.m2NCameraJac.t() * v2Error;
+    L.dSumSquaredError += v2Error[0] * v2Error[0] + v2Error[1] * v2Error[1];
+  }
   
-      for(unsigned int i=0; i<vEAJ.size(); i++) {
+  L.nMeas = vEAJ.size();
+  L.vNLinCamParams = mCamera.GetParams();
+  L.v6PoseDrift = cv::Vec<double, 6>::all(0);
+  L.bValid = true;
+}
 
-	  CalibImage::ErrorAndJacobians &EAJ = vEAJ[i];
-	  // All the below should be +=, but the MSVC compiler doesn't seem to understand that. :( George: We'll have to see about this...
-	  //mJTJ.slice(nMotionBase, nMotionBase, 6, 6) = 
-	  //mJTJ.slice(nMotionBase, nMotionBase, 6, 6) + EAJ.m26PoseJac.T() * EAJ.m26PoseJac; // tricky one...
-	  cv::Mat_<double> mJTJblock6x6 = mJTJ( cv::Range(nMotionBase, nMotionBase + 6), cv::Range(nMotionBase, nMotionBase + 6) );
-	  cv::Mat_<double> tempBlock6x6 = mJTJblock6x6 + EAJ.m26PoseJac.t() * EAJ.m26PoseJac;
-	  tempBlock6x6.copyTo(mJTJblock6x6);
-	  
-	 
-	  
-	  //mJTJ.slice(nCamParamBase, nCamParamBase, NUMTRACKERCAMPARAMETERS, NUMTRACKERCAMPARAMETERS) = 
-	  //mJTJ.slice(nCamParamBase, nCamParamBase, NUMTRACKERCAMPARAMETERS, NUMTRACKERCAMPARAMETERS) + EAJ.m2NCameraJac.T() * EAJ.m2NCameraJac;
-	  cv::Mat_<double> mJTJBlocknxn = mJTJ( cv::Range(nCamParamBase, nCamParamBase + NUMTRACKERCAMPARAMETERS), 
-						cv::Range(nCamParamBase, nCamParamBase + NUMTRACKERCAMPARAMETERS) );
-	  cv::Mat_<double> tempBlocknxn = mJTJBlocknxn + EAJ.m2NCameraJac.t() * EAJ.m2NCameraJac;
-	  tempBlocknxn.copyTo(mJTJBlocknxn);
-	  
-	  //mJTJ.slice(nMotionBase, nCamParamBase, 6, NUMTRACKERCAMPARAMETERS) =
-	  //mJTJ.slice(nMotionBase, nCamParamBase, 6, NUMTRACKERCAMPARAMETERS) + EAJ.m26PoseJac.T() * EAJ.m2NCameraJac;
-	  cv::Mat_<double> mJTJBlock6xn = mJTJ( cv::Range(nMotionBase, nMotionBase + 6), 
-						cv::Range(nCamParamBase, nCamParamBase + NUMTRACKERCAMPARAMETERS) );
-	  cv::Mat_<double> tempBlock6xn = mJTJBlock6xn + EAJ.m26PoseJac.t() * EAJ.m2NCameraJac;
-	  tempBlock6xn.copyTo(mJTJBlock6xn);
-	  
-	  
-	  //mJTJ.T().slice(nMotionBase, nCamParamBase, 6, NUMTRACKERCAMPARAMETERS) = 
-	  //mJTJ.T().slice(nMotionBase, nCamParamBase, 6, NUMTRACKERCAMPARAMETERS) + EAJ.m26PoseJac.T() * EAJ.m2NCameraJac;
-	  cv::Mat_<double> mJTJBlocknx6 = mJTJ( cv::Range(nCamParamBase, nCamParamBase + NUMTRACKERCAMPARAMETERS), 
-						cv::Range(nMotionBase, nMotionBase + 6) );
-	  cv::Mat_<double> tempBlocknx6 = tempBlock6xn.t();
-	  tempBlocknx6.copyTo(mJTJBlocknx6);
-	  
-	  
-	  // Above does twice the work it needs to, but who cares.. (George: Maybe a bit faster; now... But still slow I guess...)
-	  //vJTe.slice(nMotionBase,6) = 
-	  //vJTe.slice(nMotionBase,6) + EAJ.m26PoseJac.T() * EAJ.v2Error;
-	  
-	  mv2Error(0, 0) = EAJ.v2Error[0];
-	  mv2Error(1, 0) = EAJ.v2Error[1];
-	  
-	  cv::Mat_<double> vJTe6 = vJTe(cv::Range(nMotionBase, nMotionBase + 6), cv::Range::all() );
-	  cv::Mat_<double> tempv6 = vJTe6 + EAJ.m26PoseJac.t() * mv2Error;
-	  tempv6.copyTo(vJTe6);
-	  
-	  //vJTe.slice(nCamParamBase,NUMTRACKERCAMPARAMETERS) = 
-	  //vJTe.slice(nCamParamBase,NUMTRACKERCAMPARAMETERS) + EAJ.m2NCameraJac.T() * EAJ.v2Error;
 
-	  cv::Mat_<double> vJTen = vJTe(cv::Range(nCamParamBase, nCamParamBase + NUMTRACKERCAMPARAMETERS), cv::Range::all() );
-	  
-	  cv::Mat_<double> tempvn = vJTen + EAJ.m2NCameraJac.t() * mv2Error;
-	  tempvn.copyTo(vJTen);
-	  
-	  //dSumSquaredError += EAJ.v2Error * EAJ.v2Error;
-	  dSumSquaredError += EAJ.v2Error[0] * EAJ.v2Error[0] + EAJ.v2Error[1] * EAJ.v2Error[1];
-	 
-	  
-	  
-	  ++nTotalMeas;
-	}
-    };
+// The same step as OptimizeOneStep, but solved on the camera parameters only (the poses are eliminated view by view):
+//
+//   ( I + sum(C - B' * inv(A + I) * B) ) * dc = sum( bc - B' * inv(A + I) * bp )
+//   dp = inv(A + I) * (bp - B * dc)
+//
+// where bp, bc are the gradients of each view predicted at the current estimate by its cached linearization.
+// So the cost of a step is a handful of 6x6 operations per view plus the re-linearization of the views that drifted 
+// (typically just the new ones), rather than the Cholesky of the full (6 * nViews + N) system.
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::OptimizeOneStepIncremental()
+{
+  const int N = CameraModel::NumParams;
+  int nViews = mvCalibImgs.size();
+  
+  if(*mpvnDisableDistortion) mCamera.DisableRadialDistortion();
+  
+  // new views come in with an invalid linearization
+  mvViewLins.resize(nViews);
+  
+  cv::Vec<double, N> vNCamParams = mCamera.GetParams();
+  
+  // The reduced system on the camera parameters (starting with the same unit damping as the full version)
+  cv::Matx<double, N, N> mNNReduced = cv::Matx<double, N, N>::eye();
+  cv::Vec<double, N> vNReduced = cv::Vec<double, N>::all(0);
+  
+  // What we need for the back-substitution of the poses
+  vector<cv::Matx<double, 6, 6> > vm66AInv(nViews);
+  vector<cv::Vec<double, 6> > vv6bp(nViews);
+  
+  double dSumSquaredError = 0.0;
+  int nTotalMeas = 0;
+  mnRelinearized = 0;
+  
+  for(int n=0; n<nViews; n++) {
+    
+    ViewLinearization &L = mvViewLins[n];
+    cv::Vec<double, N> vNCamDrift = L.bValid ? vNCamParams - cv::Vec<double, N>(L.vNLinCamParams) : cv::Vec<double, N>::all(0);
+    
+    if(!L.bValid || 
+       cv::norm(L.v6PoseDrift) > *mpvdRelinPoseThreshold || 
+       cv::norm(vNCamDrift, cv::NORM_INF) > *mpvdRelinCameraThreshold) {
+      
+      LinearizeView(n);
+      vNCamDrift = cv::Vec<double, N>::all(0);
+      mnRelinearized++;
+    }
+    
+    if(L.nMeas == 0) continue; // All projections invalid; leaving it out (as in the full version)
+    
+    const cv::Vec<double, 6> &dp = L.v6PoseDrift;
+    const cv::Vec<double, N> &dc = vNCamDrift;
+    
+    // The gradient at the current estimate according to the cached linearization: b - H * drift
+    cv::Vec<double, 6> bp = L.v6bp - L.m66A * dp - L.m6NB * dc;
+    cv::Vec<double, N> bc = L.vNbc - L.m6NB.t() * dp - L.mNNC * dc;
+    
+    // ... and the predicted squared error: |e - J * drift|^2
+    dSumSquaredError += L.dSumSquaredError - 2 * (L.v6bp.dot(dp) + L.vNbc.dot(dc)) 
+			+ dp.dot(L.m66A * dp) + 2 * dp.dot(L.m6NB * dc) + dc.dot(L.mNNC * dc);
+    nTotalMeas += L.nMeas;
+    
+    // Eliminate the pose of the view
+    vm66AInv[n] = (L.m66A + cv::Matx<double, 6, 6>::eye()).inv(cv::DECOMP_CHOLESKY);
+    vv6bp[n] = bp;
+    cv::Matx<double, N, 6> mN6BtAInv = L.m6NB.t() * vm66AInv[n];
+    
+    mNNReduced += L.mNNC - mN6BtAInv * L.m6NB;
+    vNReduced += bc - mN6BtAInv * bp;
+  }
   
   if (nTotalMeas == 0) {
     cout << "Did not manage to include a single grid corner in the optimization ! Skipping updates !" <<endl;
     return;
   }
-    
-  mdMeanPixelError = sqrt(dSumSquaredError / nTotalMeas);
   
+  mdMeanPixelError = sqrt(std::max(dSumSquaredError, 0.0) / nTotalMeas);
+  
+  // Solve for the camera update and back-substitute for the poses
+  cv::Vec<double, N> vNCamUpdate = mNNReduced.solve(vNReduced, cv::DECOMP_CHOLESKY);
   
-	  
-  cv::Mat_<double> vUpdate(nDim, 1);
-  cv::solve(mJTJ, vJTe, vUpdate, cv::DECOMP_CHOLESKY);
-  vUpdate *= 0.1; // Slow down because highly nonlinear...
   for(int n=0; n<nViews; n++) {
-    cv::Mat_<double> vUslice = vUpdate(cv::Range(n*6, n*6 + 6), cv::Range::all() );
-    //mvCalibImgs[n].mse3CamFromWorld = SE3<>::exp(vUpdate.slice(n * 6, 6)) * mvCalibImgs[n].mse3CamFromWorld;
-    SE3<> Dse3 = SE3<>::exp( cv::Vec<float, 6>( vUslice(0, 0), 
-					      vUslice(1, 0), 
-					      vUslice(2, 0), 
-					      vUslice(3, 0), 
-					      vUslice(4, 0), 
-					      vUslice(5, 0) )
-			  );
-    mvCalibImgs[n].mse3CamFromWorld = Dse3 * mvCalibImgs[n].mse3CamFromWorld; 
-						
-   
+    
+    ViewLinearization &L = mvViewLins[n];
+    if(L.nMeas == 0) continue;
+    
+    cv::Vec<double, 6> v6PoseUpdate = vm66AInv[n] * (vv6bp[n] - L.m6NB * vNCamUpdate);
+    v6PoseUpdate *= 0.1; // Slow down because highly nonlinear...
+    
+    SE3<> Dse3 = SE3<>::exp( cv::Vec<float, 6>( v6PoseUpdate[0], 
+					      v6PoseUpdate[1], 
+					      v6PoseUpdate[2], 
+					      v6PoseUpdate[3], 
+					      v6PoseUpdate[4], 
+					      v6PoseUpdate[5] ) );
+    mvCalibImgs[n].mse3CamFromWorld = Dse3 * mvCalibImgs[n].mse3CamFromWorld;
+    L.v6PoseDrift += v6PoseUpdate;
   }
-  //mCamera.UpdateParams(vUpdate.slice(nCamParamBase, NUMTRACKERCAMPARAMETERS));
-  cv::Vec<float, NUMTRACKERCAMPARAMETERS> Dparams;
-  for (int k = 0; k<NUMTRACKERCAMPARAMETERS; k++) Dparams[k] = vUpdate(nCamParamBase+k, 0);
- 
+  
+  cv::Vec<float, N> Dparams;
+  for (int k = 0; k<N; k++) Dparams[k] = 0.1 * vNCamUpdate[k];
+  
   mCamera.UpdateParams(Dparams);
-};
-
-
-
-
-
-
-
-
-
+}
 
 
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::ComputeCameraCovariance(bool bFromResiduals)
+{
+  const int N = CameraModel::NumParams;
+  int nViews = mvCalibImgs.size();
+  
+  cv::Matx<double, N, N> mNNInformation = cv::Matx<double, N, N>::zeros();
+  double dSumSquaredError = 0;
+  int nTotalMeas = 0;
+  
+  for(int n=0; n<nViews; n++) {
+    
+    mNNInformation += mvCalibImgs[n].CameraInformation(mCamera);
+    
+    if(bFromResiduals) {
+      
+      vector<CalibImage::ErrorAndJacobians<N> > vEAJ = mvCalibImgs[n].Project(mCamera);
+      for(unsigned int i=0; i<vEAJ.size(); i++) 
+	dSumSquaredError += vEAJ[i].v2Error[0] * vEAJ[i].v2Error[0] + vEAJ[i].v2Error[1] * vEAJ[i].v2Error[1];
+      nTotalMeas += vEAJ.size();
+    }
+  }
+  
+  // The variance of a corner coordinate: residuals over the degrees of freedom (2 per corner, minus the poses and the camera)
+  double dVariance = *mpvdPixelNoise * *mpvdPixelNoise;
+  int nDof = 2 * nTotalMeas - 6 * nViews - N;
+  if(bFromResiduals && nDof > 0) dVariance = dSumSquaredError / nDof;
+  
+  // Parameters that are not being estimated (i.e., distortion, if disabled) carry no information; 
+  // take them out of the inversion and give them zero variance.
+  bool abFixed[N];
+  for(int i=0; i<N; i++) {
+    
+    abFixed[i] = mNNInformation(i, i) < 1e-12;
+    if(!abFixed[i]) continue;
+    for(int j=0; j<N; j++) mNNInformation(i, j) = mNNInformation(j, i) = 0;
+    mNNInformation(i, i) = 1;
+  }
+  
+  mmCameraCovariance = dVariance * mNNInformation.inv(cv::DECOMP_SVD);
+  
+  for(int i=0; i<N; i++) {
+    
+    if(abFixed[i]) 
+      for(int j=0; j<N; j++) mmCameraCovariance(i, j) = mmCameraCovariance(j, i) = 0;
+    mvCameraSigmas[i] = sqrt(std::max(mmCameraCovariance(i, i), 0.0));
+  }
+  
+  mbCovarianceValid = nViews > 0;
+}
 
 
+template<class CameraModel>
+bool CameraCalibrator<CameraModel>::CovarianceGoodEnough()
+{
+  if(!mbCovarianceValid) return false;
+  if(*mpvdTargetSigmaPixels <= 0 && *mpvdTargetSigmaDistortion <= 0) return false;
+  
+  // fx, cx are in units of image width and fy, cy in units of image height (see GenericCamera::RefreshParams)
+  cv::Vec2f v2Size = mCamera.GetImageSize();
+  for(int i=0; i<4; i++) 
+    if(*mpvdTargetSigmaPixels > 0 && mvCameraSigmas[i] * v2Size[i % 2] > *mpvdTargetSigmaPixels) return false;
+  
+  for(int i=4; i<CameraModel::NumParams; i++) 
+    if(*mpvdTargetSigmaDistortion > 0 && mvCameraSigmas[i] > *mpvdTargetSigmaDistortion) return false;
+  
+  return true;
+}
 
 
+template<class CameraModel>
+void CameraCalibrator<CameraModel>::CheckCaptureDone()
+{
+  // No target, no point in paying for the covariance on every grab
+  if(*mpvdTargetSigmaPixels <= 0 && *mpvdTargetSigmaDistortion <= 0) return;
+  
+  // The poses are just the initial guesses at this stage, so the residuals mean little; use the assumed corner noise.
+  ComputeCameraCovariance(false);
+  if(!CovarianceGoodEnough()) return;
+  
+  cout << "Predicted camera parameter std. deviations " << mvCameraSigmas << " meet the target; starting the optimization." << endl;
+  *mpvnAutoGrab = 0;
+  *mpvnOptimizing = 1;
+}
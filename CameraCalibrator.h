@@ -5,22 +5,31 @@
 #define __CAMERACALIBRATOR_H
 
 #include "CalibImage.h"
+#include "ViewSelector.h"
+#include "CalibSession.h"
+#include "CalibOptimizer.h"
 #include "VideoSource.h"
 
 
 #include <vector>
+#include <memory>
 #include "GLWindow2.h"
+#include "Persistence/GUI.h"
 
 #include "OpenCV.h"
 
-#include "ATANCamera.h"
+#include "GenericCamera.h"
 
 
+// The calibrator is a template on the camera model policy (see CameraModels.h),
+// so that the projection/Jacobian/optimization loops are compiled for each model separately.
+// The model is picked in main() from the "Camera.Model" PVar ("ATAN", "RadTan" or "Fisheye").
+template<class CameraModel>
 class CameraCalibrator
 {
 public:
   
-  CameraCalibrator();
+  CameraCalibrator(VideoSource &videoSource);
   void Run();
   
   
@@ -32,22 +41,93 @@ protected:
   
   
   void HandleFrame(cv::Mat_<uchar> imFrame);
+  void HandleCalibImage(CalibImage &c);   // Grab / auto-grab a frame in which a grid was found
   static void MainLoopCallback(void* pvUserData);
   void MainLoopStep();
-  VideoSource mVideoSource;
+  VideoSource &mVideoSource;
   
   GLWindow2 mGLWindow;
-  ATANCamera mCamera;
+  GenericCamera<CameraModel> mCamera;
   bool mbDone;
 
   std::vector<CalibImage> mvCalibImgs;
   void OptimizeOneStep();
   
+  // Incremental optimization (in the spirit of iSAM): Each view keeps its blocks of the normal equations
+  // from the last time it was linearized, and these are Schur-reduced onto the camera parameters at every step.
+  // A view is re-linearized only if its pose or the camera parameters have drifted beyond a threshold since then;
+  // in between, the cached Jacobians are used to predict its gradient (and error) at the current estimate.
+  struct ViewLinearization
+  {
+    ViewLinearization() : bValid(false), nMeas(0) {}
+    
+    bool bValid;                     // False if the view was never linearized (or the cache was discarded)
+    int nMeas;                       // Number of valid projections at the linearization point
+    double dSumSquaredError;         // Sum of squared errors at the linearization point
+    cv::Matx<double, 6, 6> m66A;                                           // Jp' * Jp
+    cv::Matx<double, 6, CameraModel::NumParams> m6NB;                      // Jp' * Jc
+    cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams> mNNC; // Jc' * Jc
+    cv::Vec<double, 6> v6bp;                                               // Jp' * e
+    cv::Vec<double, CameraModel::NumParams> vNbc;                          // Jc' * e
+    cv::Vec<float, CameraModel::NumParams> vNLinCamParams;                 // Camera parameters at the linearization point
+    cv::Vec<double, 6> v6PoseDrift;                                        // Sum of the pose updates since then
+  };
+  std::vector<ViewLinearization> mvViewLins;
+  int mnRelinearized;              // Views re-linearized in the last incremental step
+  void LinearizeView(int n);
+  void OptimizeOneStepIncremental();
+  
+  // The closed-form initialization of the intrinsics (see CalibOptimizer.h)
+  bool mbIntrinsicsInitialized;    // Done once per calibration, before the first optimization step
+  
+  // Marginal covariance of the camera parameters: the inverse of the sum of the (Schur-reduced) camera information 
+  // of the views (see CalibImage::CameraInformation), scaled by the variance of the corner measurements. 
+  // The latter is either estimated from the residuals (at convergence) or taken from CameraCalibrator.PixelNoise.
+  void ComputeCameraCovariance(bool bFromResiduals);
+  // True if all standard deviations are below the targets (CameraCalibrator.TargetSigmaPixels / TargetSigmaDistortion)
+  bool CovarianceGoodEnough();
+  // Called whenever a view is kept during capture; ends capture and starts the optimization once the predicted 
+  // uncertainty is good enough.
+  void CheckCaptureDone();
+  cv::Matx<double, CameraModel::NumParams, CameraModel::NumParams> mmCameraCovariance;
+  cv::Vec<double, CameraModel::NumParams> mvCameraSigmas; // square roots of the diagonal of the above
+  bool mbCovarianceValid;
+  bool mbConverged;                // The RMS error has stopped changing
+  double mdLastMeanPixelError;
+  
   bool mbGrabNextFrame;
   Persistence::pvar3<int> mpvnOptimizing;
   Persistence::pvar3<int> mpvnShowImage;
   Persistence::pvar3<int> mpvnDisableDistortion;
+  Persistence::pvar3<int> mpvnAutoGrab;       // Keep good views automatically (see ViewSelector.h)
+  Persistence::pvar3<int> mpvnIncremental;    // Use OptimizeOneStepIncremental()
+  Persistence::pvar3<double> mpvdRelinPoseThreshold;   // Pose drift (norm of the accumulated se3 update) that triggers re-linearization
+  Persistence::pvar3<double> mpvdRelinCameraThreshold; // Camera parameter drift (max abs) that triggers re-linearization
+  Persistence::pvar3<int> mpvnClosedFormInit; // Initialize the intrinsics with CalibOptimizer::InitializeIntrinsics() before optimizing
+  Persistence::pvar3<int> mpvnRobustKernel;   // RobustKernel of the full optimization step (0: none, 1: Huber, 2: Cauchy)
+  Persistence::pvar3<double> mpvdRobustWidth; // and its width in pixels
+  Persistence::pvar3<double> mpvdPixelNoise;            // Assumed std. deviation (pixels) of the corners before convergence
+  Persistence::pvar3<double> mpvdTargetSigmaPixels;     // Target std. deviation of fx, fy, cx, cy in pixels (0 : no target)
+  Persistence::pvar3<double> mpvdTargetSigmaDistortion; // Target std. deviation of the distortion parameters (0 : no target)
+  
+  ViewSelector mViewSelector;
+  
+  // Session files (see CalibSession.h): the grabbed views can be saved and loaded back later for optimization
+  // without the camera. The views of a loaded session keep their images in the mapped file, so the file stays
+  // open until the next Reset().
+  bool SaveSession(const std::string &sFileName);
+  bool LoadSession(const std::string &sFileName);
+  std::shared_ptr<CalibSessionFile> mpSession;
+  Persistence::pvar3<std::string> mpvsSessionFile;  // Default file name of the SaveSession/LoadSession commands
+  Persistence::pvar3<int> mpvnSessionImages;        // Store the grayscale images in saved sessions
+  Persistence::pvar3<int> mpvnTrace;                 // Trace the stages from the start (see Profiling.h), and dump the trace on exit
+  Persistence::pvar3<std::string> mpvsTraceFile;     // Default file name of the TraceDump command
+  Persistence::pvar3<int> mpvnDetectThreads;         // Detection workers of the frame pipeline (0: no pipeline; see FramePipeline.h)
+  Persistence::pvar3<int> mpvnPipelineQueueSize;     // Frames in each queue of the pipeline (the oldest are dropped beyond that)
+  ViewScore mLastViewScore;                   // Score of the last candidate view (for the caption)
   double mdMeanPixelError;
+  
+  Persistence::GUICommandHandle mcmdShowMenu; // "CalibMenu.ShowMenu", resolved once (it is called on every frame)
 
   void GUICommandHandler(std::string sCommand, std::string sParams);
   
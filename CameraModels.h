@@ -0,0 +1,289 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+//
+// Camera model policies for GenericCamera (see GenericCamera.h).
+//
+// A policy describes ONLY the lens distortion part of a camera model, i.e. the mapping
+// between undistorted and distorted normalized Euclidean (z=1) coordinates, its Jacobian
+// and its inverse. The linear part (focal lengths and principal point) is common to all models
+// and is taken care of by GenericCamera. Hence, the parameter vector of every model starts with
+//
+//   p[0] - fx / IMG_WIDTH
+//   p[1] - fy / IMG_HEIGHT
+//   p[2] - cx / IMG_WIDTH
+//   p[3] - cy / IMG_HEIGHT
+//
+// and parameters 4 ... NumParams-1 are the model-specific distortion coefficients.
+//
+// Every policy must provide:
+//   - static const int NumParams                    : Total number of parameters (compile-time)
+//   - static const char* Name()                     : The name used in "Camera.Model"
+//   - static const char* ParamsSuffix()             : Suffix of the parameter PVar (appended to the camera name)
+//   - static cv::Vec<float, NumParams> DefaultParams()
+//   - void Refresh(const cv::Vec<float, NumParams>&) : Cache whatever coefficients the model needs
+//   - bool Enabled() const                          : False if distortion is (numerically) switched off
+//   - cv::Vec2f Distort(const cv::Vec2f&) const     : undistorted z=1 -> distorted z=1
+//   - cv::Matx22f DistortDerivs(const cv::Vec2f&) const : Jacobian of Distort wrt the undistorted coordinates
+//   - cv::Vec2f Undistort(const cv::Vec2f&) const   : distorted z=1 -> undistorted z=1
+//   - static void ZeroDistortion(cv::Vec<float, NumParams>&) : Sets the distortion coefficients to "no distortion"
+//
+// Everything is inline, so that the projection loops in CalibImage and the CameraCalibrator
+// get fully specialized for each model.
+
+#ifndef __CAMERA_MODELS_H
+#define __CAMERA_MODELS_H
+
+#include <cmath>
+#include <string>
+
+#include "OpenCV.h"
+
+
+// The FOV model of Devernay and Faugeras (Straight lines have to be straight, 2001).
+// This is the original PTAM model with a single distortion parameter w (the "angle").
+//
+// p[4] - w
+struct ATANModel
+{
+  static const int NumParams = 5;
+
+  static const char* Name() { return "ATAN"; }
+  // Keeping the PTAM name for the parameters, so that old camera.cfg files still work
+  static const char* ParamsSuffix() { return ".Parameters"; }
+
+  // Assuming that at 5 m in the z axis, the frustum section is 10 m x 10m
+  // (which is roughly a standard webcamera field of view). The FOV parameter is 0.07 for fun...
+  static cv::Vec<float, NumParams> DefaultParams() { return cv::Vec<float, NumParams>(0.5, 4.0/5.0, 0.5, 0.5, 0.07); }
+
+  static void ZeroDistortion(cv::Vec<float, NumParams> &vParams) { vParams[4] = 0.0; }
+
+  void Refresh(const cv::Vec<float, NumParams> &vParams)
+  {
+    mdW = vParams[4];  // The Devernay-Faugeras radial distortion FOV model parameter (AKA "angle")
+    if(mdW != 0.0) {
+      md2Tan = 2.0 * tan(mdW / 2.0);  // the denominator in the fraction that yields the UNDISTORTED radius (ru)
+      mdOneOver2Tan = 1.0 / md2Tan;
+      mdWinv = 1.0 / mdW;
+    }
+    else {
+      mdWinv = 0.0;
+      md2Tan = 0.0;
+      mdOneOver2Tan = 0.0;
+    }
+  }
+
+  bool Enabled() const { return mdW != 0.0; }
+
+  // Radial distortion transformation factor: returns ratio of distorted / undistorted radius.
+  // This IS the correction factor in the projection model:
+  // You need to multiply the Euclidean normalized coordinates by this factor BEFORE you project them onto the image
+  inline float rtrans_factor(float r) const
+  {
+    if(r < 0.001 || mdW == 0.0) return 1.0;
+    else
+      return (mdWinv* atan(r * md2Tan) / r); // 1/w * atan(2*ru*tan(w/2)) / ru
+  }
+
+  // Inverse radial distortion: returns un-distorted radius from distorted.
+  inline float invrtrans(float r) const
+  {
+    if(mdW == 0.0) return r;
+    return(tan(r * mdW) * mdOneOver2Tan); // tan(rd * w) / (2 * tan(w/2))
+  }
+
+  inline cv::Vec2f Distort(const cv::Vec2f &v2Cam) const
+  {
+    float dFactor = rtrans_factor( sqrt(v2Cam[0] * v2Cam[0] + v2Cam[1] * v2Cam[1]) );
+    return cv::Vec2f(dFactor * v2Cam[0], dFactor * v2Cam[1]);
+  }
+
+  // The derivative of the fraction f = rd/ru = 1/w*atan(2*ru*tan(w/2)) / ru
+  // in terms of [xe; ye] needs to go inside square->square root -> tangent....
+  inline cv::Matx22f DistortDerivs(const cv::Vec2f &v2Cam) const
+  {
+    const float &x = v2Cam[0];
+    const float &y = v2Cam[1];
+    float ru = sqrt(x*x + y*y);
+    float dFactor = rtrans_factor(ru);
+    float dFracBydx = 0, dFracBydy = 0;
+    // if radius is small, then the correction fraction r'/r has (nearly) zero derivatives in terms of [xe; ye]
+    if(mdW != 0.0 && ru >= 0.01) {
+      const float &k = md2Tan; // k = 2 * tan(w / 2)
+      dFracBydx =  ( mdWinv *  k / (1 + k*k*ru*ru) - dFactor ) * x / (ru*ru);
+      dFracBydy =  ( mdWinv *  k / (1 + k*k*ru*ru) - dFactor ) * y / (ru*ru);
+    }
+    return cv::Matx22f(dFracBydx * x + dFactor, dFracBydy * x,
+		       dFracBydx * y,           dFracBydy * y + dFactor);
+  }
+
+  inline cv::Vec2f Undistort(const cv::Vec2f &v2Dist) const
+  {
+    float rd = sqrt(v2Dist[0] * v2Dist[0] + v2Dist[1] * v2Dist[1]);
+    float dFactor = (rd > 0.01) ? invrtrans(rd) / rd : 1.0; // ru / rd
+    return cv::Vec2f(dFactor * v2Dist[0], dFactor * v2Dist[1]);
+  }
+
+  float mdW;             // distortion model coeff
+  float md2Tan;          // distortion model coeff
+  float mdOneOver2Tan;   // distortion model coeff
+  float mdWinv;          // distortion model coeff
+};
+
+
+// Radial-tangential (Brown - Conrady) model with two radial and two tangential coefficients.
+// This is the OpenCV/ROS "plumb_bob" model without k3:
+//
+//   xd = x * (1 + k1*r^2 + k2*r^4) + 2*p1*x*y + p2*(r^2 + 2*x^2)
+//   yd = y * (1 + k1*r^2 + k2*r^4) + p1*(r^2 + 2*y^2) + 2*p2*x*y
+//
+// p[4] - k1, p[5] - k2, p[6] - p1, p[7] - p2
+struct RadTanModel
+{
+  static const int NumParams = 8;
+
+  static const char* Name() { return "RadTan"; }
+  static const char* ParamsSuffix() { return ".RadTanParameters"; }
+
+  static cv::Vec<float, NumParams> DefaultParams() { return cv::Vec<float, NumParams>(0.5, 4.0/5.0, 0.5, 0.5, 0, 0, 0, 0); }
+
+  static void ZeroDistortion(cv::Vec<float, NumParams> &vParams) { vParams[4] = vParams[5] = vParams[6] = vParams[7] = 0.0; }
+
+  void Refresh(const cv::Vec<float, NumParams> &vParams)
+  {
+    mdK1 = vParams[4]; mdK2 = vParams[5];
+    mdP1 = vParams[6]; mdP2 = vParams[7];
+  }
+
+  // Zero coefficients are a perfectly good starting point for this model, so never "disabled"
+  bool Enabled() const { return true; }
+
+  inline cv::Vec2f Distort(const cv::Vec2f &v2Cam) const
+  {
+    const float &x = v2Cam[0];
+    const float &y = v2Cam[1];
+    float r2 = x*x + y*y;
+    float dRadial = 1 + r2 * (mdK1 + mdK2 * r2);
+    return cv::Vec2f(x * dRadial + 2 * mdP1 * x * y + mdP2 * (r2 + 2 * x * x),
+		     y * dRadial + mdP1 * (r2 + 2 * y * y) + 2 * mdP2 * x * y);
+  }
+
+  inline cv::Matx22f DistortDerivs(const cv::Vec2f &v2Cam) const
+  {
+    const float &x = v2Cam[0];
+    const float &y = v2Cam[1];
+    float r2 = x*x + y*y;
+    float dRadial = 1 + r2 * (mdK1 + mdK2 * r2);
+    float a = 2 * mdK1 + 4 * mdK2 * r2; // d(radial)/dx = a*x, d(radial)/dy = a*y
+    return cv::Matx22f(dRadial + a*x*x + 2*mdP1*y + 6*mdP2*x,  a*x*y + 2*mdP1*x + 2*mdP2*y,
+		       a*x*y + 2*mdP1*x + 2*mdP2*y,            dRadial + a*y*y + 6*mdP1*y + 2*mdP2*x);
+  }
+
+  // No closed form here. A few Gauss-Newton iterations starting from the distorted point
+  // converge very quickly for any sensible set of coefficients.
+  inline cv::Vec2f Undistort(const cv::Vec2f &v2Dist) const
+  {
+    cv::Vec2f v2Cam = v2Dist;
+    for(int i = 0; i < 20; i++) {
+      cv::Vec2f v2Err = Distort(v2Cam) - v2Dist;
+      if(v2Err[0] * v2Err[0] + v2Err[1] * v2Err[1] < 1e-14) break;
+      cv::Matx22f J = DistortDerivs(v2Cam);
+      float det = J(0, 0) * J(1, 1) - J(0, 1) * J(1, 0);
+      if(fabs(det) < 1e-8) break;
+      v2Cam[0] -= ( J(1, 1) * v2Err[0] - J(0, 1) * v2Err[1]) / det;
+      v2Cam[1] -= (-J(1, 0) * v2Err[0] + J(0, 0) * v2Err[1]) / det;
+    }
+    return v2Cam;
+  }
+
+  float mdK1, mdK2; // radial coefficients
+  float mdP1, mdP2; // tangential coefficients
+};
+
+
+// Equidistant fisheye model of Kannala and Brandt (A generic camera model and calibration method
+// for conventional, wide-angle, and fish-eye lenses, 2006), as used by OpenCV's fisheye module:
+//
+//   theta  = atan(r),  r = sqrt(x^2 + y^2)
+//   theta_d = theta * (1 + k1*theta^2 + k2*theta^4 + k3*theta^6 + k4*theta^8)
+//   [xd; yd] = (theta_d / r) * [x; y]
+//
+// p[4] - k1, p[5] - k2, p[6] - k3, p[7] - k4
+struct FisheyeModel
+{
+  static const int NumParams = 8;
+
+  static const char* Name() { return "Fisheye"; }
+  static const char* ParamsSuffix() { return ".FisheyeParameters"; }
+
+  static cv::Vec<float, NumParams> DefaultParams() { return cv::Vec<float, NumParams>(0.5, 4.0/5.0, 0.5, 0.5, 0, 0, 0, 0); }
+
+  static void ZeroDistortion(cv::Vec<float, NumParams> &vParams) { vParams[4] = vParams[5] = vParams[6] = vParams[7] = 0.0; }
+
+  void Refresh(const cv::Vec<float, NumParams> &vParams)
+  {
+    mdK1 = vParams[4]; mdK2 = vParams[5];
+    mdK3 = vParams[6]; mdK4 = vParams[7];
+  }
+
+  bool Enabled() const { return true; }
+
+  // theta_d as a function of theta
+  inline float theta_d(float th) const
+  {
+    float th2 = th * th;
+    return th * (1 + th2 * (mdK1 + th2 * (mdK2 + th2 * (mdK3 + th2 * mdK4))));
+  }
+
+  // d(theta_d) / d(theta)
+  inline float dtheta_d(float th) const
+  {
+    float th2 = th * th;
+    return 1 + th2 * (3 * mdK1 + th2 * (5 * mdK2 + th2 * (7 * mdK3 + th2 * 9 * mdK4)));
+  }
+
+  inline cv::Vec2f Distort(const cv::Vec2f &v2Cam) const
+  {
+    float r = sqrt(v2Cam[0] * v2Cam[0] + v2Cam[1] * v2Cam[1]);
+    float dFactor = (r < 1e-6) ? 1.0 : theta_d(atan(r)) / r;
+    return cv::Vec2f(dFactor * v2Cam[0], dFactor * v2Cam[1]);
+  }
+
+  // J = s * I + (ds/dr / r) * v * v', where s = theta_d / r
+  inline cv::Matx22f DistortDerivs(const cv::Vec2f &v2Cam) const
+  {
+    const float &x = v2Cam[0];
+    const float &y = v2Cam[1];
+    float r = sqrt(x*x + y*y);
+    if(r < 1e-6) return cv::Matx22f(1, 0,
+				    0, 1);
+    float th = atan(r);
+    float s = theta_d(th) / r;
+    float dsdr = ( dtheta_d(th) / (1 + r*r) - s ) / r;
+    float c = dsdr / r;
+    return cv::Matx22f(s + c*x*x,  c*x*y,
+		       c*x*y,      s + c*y*y);
+  }
+
+  // Newton on theta_d(theta) = rd, then r = tan(theta)
+  inline cv::Vec2f Undistort(const cv::Vec2f &v2Dist) const
+  {
+    float rd = sqrt(v2Dist[0] * v2Dist[0] + v2Dist[1] * v2Dist[1]);
+    if(rd < 1e-6) return v2Dist;
+    float th = rd;
+    for(int i = 0; i < 20; i++) {
+      float dErr = theta_d(th) - rd;
+      if(fabs(dErr) < 1e-7) break;
+      th -= dErr / dtheta_d(th);
+    }
+    // beyond 90 degrees there is no point on the z=1 plane. Just clamp (the camera will flag it invalid).
+    if(th > 1.57) th = 1.57;
+    float dFactor = tan(th) / rd;
+    return cv::Vec2f(dFactor * v2Dist[0], dFactor * v2Dist[1]);
+  }
+
+  float mdK1, mdK2, mdK3, mdK4; // The Kannala-Brandt polynomial coefficients
+};
+
+
+#endif
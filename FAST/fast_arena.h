@@ -0,0 +1,62 @@
+#ifndef FAST_ARENA_H
+#define FAST_ARENA_H
+
+#include <vector>
+
+namespace FAST
+{
+	/// A caller-owned, reusable output buffer for the allocation-free FAST functions.
+	///
+	/// Corners are kept as a structure of arrays (x, y and score) of a fixed capacity, which is allocated
+	/// once (constructor or @ref reserve) and never touched by detection: clear() only resets the count,
+	/// so an arena that is kept across frames costs no heap allocations after it has been sized.
+	/// A push into a full arena is refused and raises the overflow flag; the functions which fill the arena
+	/// then stop and return false, leaving the corners found so far (in raster order) in place.
+	struct fast_corner_arena
+	{
+		std::vector<int> x;	///< Corner columns
+		std::vector<int> y;	///< Corner rows
+		std::vector<int> score;	///< Corner scores (0 if the function does not score)
+		int size;		///< Number of corners stored
+		bool overflow;		///< True if a corner did not fit since the last clear()
+
+		fast_corner_arena(int capacity = 0) : size(0), overflow(false) { reserve(capacity); }
+
+		int capacity() const { return (int)x.size(); }
+
+		/// Grow the arrays to (at least) the given capacity; this is the only place where the arena allocates.
+		void reserve(int capacity)
+		{
+			if(capacity <= (int)x.size()) return;
+			x.resize(capacity);
+			y.resize(capacity);
+			score.resize(capacity);
+		}
+
+		void clear() { size = 0; overflow = false; }
+
+		/// Append a corner; false (and overflow) if the arena is full.
+		inline bool push(int cx, int cy, int cscore)
+		{
+			if(size >= (int)x.size())
+			{
+				overflow = true;
+				return false;
+			}
+			x[size] = cx;
+			y[size] = cy;
+			score[size] = cscore;
+			size++;
+			return true;
+		}
+	};
+
+	/// Scratch space of the arena non-maximal suppression (the first corner of each row).
+	/// It grows to the number of image rows on the first call and is reused afterwards.
+	struct fast_nonmax_workspace
+	{
+		std::vector<int> row_start;
+	};
+}
+
+#endif
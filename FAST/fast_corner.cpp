@@ -1,6 +1,7 @@
 #include "fast_corner.h"
 #include "nonmax_suppression.h"
 #include "prototypes.h"
+#include "fast_corner_simd.h"
 //#include "cvd/config.h"
 
 //#include <cvd/byte.h>
@@ -84,6 +85,16 @@ void compute_fast_score_old(const cv::Mat_<uchar> &im, const vector<cv::Point2i>
 		scores[i] = old_style_corner_score(im, corners[i], pointer_dir, barrier);
 }
 
+void compute_fast_score_old(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int barrier)
+{
+	int	pointer_dir[16];
+	for(int i=0; i < 16; i++)
+		pointer_dir[i] = fast_pixel_ring[i].x + fast_pixel_ring[i].y * im.cols;
+
+	for(int i=0; i < corners.size; i++)
+		corners.score[i] = old_style_corner_score(im, cv::Point2i(corners.x[i], corners.y[i]), pointer_dir, barrier);
+}
+
 
 
 void fast_nonmax(const cv::Mat_<uchar> &im, const vector<cv::Point2i> &corners, int barrier, vector<cv::Point2i> &max_corners)
@@ -100,4 +111,46 @@ void fast_nonmax_with_scores(const cv::Mat_<uchar> &im, const vector<cv::Point2i
 	nonmax_suppression_with_scores(corners, scores, max_corners);
 }
 
-}
\ No newline at end of file
+
+// The detectors declared in fast_corner.h all go through the single SIMD segment test engine 
+// (fast_corner_simd.cpp); the generated trees (fast_corner_detect_plain_N) are kept as the reference.
+void fast_corner_detect_7(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<7>(im, corners, barrier);
+}
+
+void fast_corner_detect_8(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<8>(im, corners, barrier);
+}
+
+void fast_corner_detect_9(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<9>(im, corners, barrier);
+}
+
+void fast_corner_detect_10(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<10>(im, corners, barrier);
+}
+
+void fast_corner_detect_11(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<11>(im, corners, barrier);
+}
+
+void fast_corner_detect_12(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int barrier)
+{
+	fast_corner_detect_simd<12>(im, corners, barrier);
+}
+
+void fast_corner_detect_9_nonmax(const cv::Mat_<uchar> &im, vector<cv::Point2i> &max_corners, int barrier)
+{
+	vector<cv::Point2i> corners;
+	vector<int> scores;
+	fast_corner_detect_9(im, corners, barrier);
+	fast_corner_score_9(im, corners, barrier, scores);
+	nonmax_suppression(corners, scores, max_corners);
+}
+
+}
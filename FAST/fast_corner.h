@@ -10,6 +10,8 @@
 #include <cv.hpp>
 #include <highgui.hpp>
 
+#include "fast_arena.h"
+
 namespace FAST
 {
   
@@ -170,6 +172,24 @@ namespace FAST
 
 
 
+	/// Compute the (old style) score used by @ref fast_nonmax and @ref fast_nonmax_with_scores for a std::vector of features:
+	/// The larger of the sums of the differences of the brighter and the darker ring pixels from the barrier.
+	///
+	/// @param im 		The input image
+	/// @param corners	The corner locations
+	/// @param barrier	The barrier used in the detection
+	/// @param scores	The resulting scores
+	void compute_fast_score_old(const cv::Mat_<uchar> &im, const std::vector<cv::Point2i> &corners, int barrier, std::vector<int> &scores);
+
+	/// The same (old style) scores, written into the score array of an arena in place (no allocations), so that
+	/// the arena @ref nonmax_suppression keeps exactly the corners that @ref fast_nonmax_with_scores keeps.
+	///
+	/// @param im 		The input image
+	/// @param corners	The corners (e.g. from @ref fast_corner_detect_simd); their scores are overwritten
+	/// @param barrier	The barrier used in the detection
+	void compute_fast_score_old(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int barrier);
+
+
 	/// The 16 offsets from the centre pixel used in FAST feature detection.
 	///
 	extern const cv::Point2i fast_pixel_ring[16];
@@ -0,0 +1,122 @@
+#include <vector>
+#include <algorithm>
+
+#include "fast_corner.h"
+#include "fast_corner_simd.h"
+#include "fast_corner_bucketed.h"
+
+using namespace std;
+
+namespace FAST
+{
+
+// Higher score first; ties go to the earlier corner in raster order (so the selection is deterministic)
+struct BetterCorner
+{
+	inline bool operator()(const pair<cv::Point2i, int> &a, const pair<cv::Point2i, int> &b) const
+	{
+		if(a.second != b.second) return a.second > b.second;
+		if(a.first.y != b.first.y) return a.first.y < b.first.y;
+		return a.first.x < b.first.x;
+	}
+};
+
+
+template<int N>
+void fast_corner_detect_bucketed(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners)
+{
+	best_corners.clear();
+	if(k <= 0 || grid_cols <= 0 || grid_rows <= 0 || im.rows < 7 || im.cols < 7) return;
+
+	const int stride = (int)im.step[0];
+	int offset[16];
+	for(int i=0; i < 16; i++)
+		offset[i] = fast_pixel_ring[i].x + fast_pixel_ring[i].y * stride;
+
+	// One bounded heap per cell; with BetterCorner as the comparison, the front of each heap is its worst corner
+	vector<vector<pair<cv::Point2i, int> > > heaps(grid_cols * grid_rows);
+	for(unsigned int i=0; i < heaps.size(); i++)
+		heaps[i].reserve(k);
+	BetterCorner better;
+
+	// The rolling window: scores of three consecutive rows (0 where there is no corner) and the corners of each
+	vector<int> window(3 * im.cols, 0);
+	vector<cv::Point2i> row_corners[3];
+
+	// Suppress the corners of row y (whose neighbours above and below are in the window) and offer them to their cells
+	auto finish_row = [&](int y)
+	{
+		const vector<cv::Point2i> &corners = row_corners[y % 3];
+		const int* above = &window[((y + 2) % 3) * im.cols];
+		const int* mid = &window[(y % 3) * im.cols];
+		const int* below = &window[((y + 1) % 3) * im.cols];
+
+		for(unsigned int i=0; i < corners.size(); i++)
+		{
+			int x = corners[i].x;
+			int score = mid[x];
+			// x is in [3, cols - 4], so the 3x3 neighbourhood is inside the window
+			if(above[x-1] > score || above[x] > score || above[x+1] > score ||
+			   mid[x-1] > score || mid[x+1] > score ||
+			   below[x-1] > score || below[x] > score || below[x+1] > score)
+				continue;
+
+			int cell = (y * grid_rows / im.rows) * grid_cols + (x * grid_cols / im.cols);
+			vector<pair<cv::Point2i, int> > &heap = heaps[cell];
+			pair<cv::Point2i, int> candidate(corners[i], score);
+
+			if((int)heap.size() < k)
+			{
+				heap.push_back(candidate);
+				push_heap(heap.begin(), heap.end(), better);
+			}
+			else if(better(candidate, heap.front()))
+			{
+				pop_heap(heap.begin(), heap.end(), better);
+				heap.back() = candidate;
+				push_heap(heap.begin(), heap.end(), better);
+			}
+		}
+	};
+
+	// Rows 2 and rows - 3 have no corners; they are the empty neighbours of the first and the last row
+	for(int y = 3; y <= im.rows - 3; y++)
+	{
+		// recycle the slot of row y (it held row y - 3): clear the scores it left behind
+		int* scores = &window[(y % 3) * im.cols];
+		vector<cv::Point2i> &corners = row_corners[y % 3];
+		for(unsigned int i=0; i < corners.size(); i++)
+			scores[corners[i].x] = 0;
+		corners.clear();
+
+		if(y < im.rows - 3)
+		{
+			fast_corner_detect_simd<N>(im, corners, barrier, y, y + 1);
+			for(unsigned int i=0; i < corners.size(); i++)
+				scores[corners[i].x] = fast_segment_score<N>(im.ptr<uchar>(y, corners[i].x), offset, barrier);
+		}
+
+		if(y > 3)
+			finish_row(y - 1);
+	}
+
+	// Cells in row-major order, best first within each
+	for(unsigned int i=0; i < heaps.size(); i++)
+	{
+		sort_heap(heaps[i].begin(), heaps[i].end(), better);
+		best_corners.insert(best_corners.end(), heaps[i].begin(), heaps[i].end());
+	}
+}
+
+
+template void fast_corner_detect_bucketed<4>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<5>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<6>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<7>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<8>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<9>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<10>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<11>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+template void fast_corner_detect_bucketed<12>(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, vector<pair<cv::Point2i, int> > &best_corners);
+
+}
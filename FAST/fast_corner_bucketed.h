@@ -0,0 +1,30 @@
+#ifndef FAST_CORNER_BUCKETED_H
+#define FAST_CORNER_BUCKETED_H
+
+#include <vector>
+#include <utility>
+
+#include <opencv2/core.hpp>
+
+namespace FAST
+{
+	/// FAST-N detection for uniform coverage: The best k locally maximal corners in each cell of a grid_cols x grid_rows grid.
+	///
+	/// Detection, scoring and non-maximal suppression are fused into a single pass over the image: Rows are
+	/// detected and scored (see @ref fast_corner_detect_score_simd) into a rolling window of three score rows,
+	/// and as soon as the row below is known, the corners of the row in the middle are suppressed (3x3, non-strict,
+	/// exactly as @ref nonmax_suppression) and offered to the bounded heap of their cell, which keeps its best k.
+	///
+	/// The result lists the cells in row-major order, each with its corners sorted by descending score
+	/// (ties in raster order).
+	///
+	/// @param im 		The input image
+	/// @param barrier	Corner detection threshold
+	/// @param grid_cols	Number of cells across
+	/// @param grid_rows	Number of cells down
+	/// @param k		Corners kept per cell
+	/// @param best_corners	The resulting corners and their scores
+	template<int N> void fast_corner_detect_bucketed(const cv::Mat_<uchar> &im, int barrier, int grid_cols, int grid_rows, int k, std::vector<std::pair<cv::Point2i, int> > &best_corners);
+}
+
+#endif
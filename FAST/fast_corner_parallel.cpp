@@ -0,0 +1,84 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "fast_corner.h"
+#include "fast_corner_simd.h"
+#include "fast_corner_parallel.h"
+#include "nonmax_suppression.h"
+
+using namespace std;
+
+namespace FAST
+{
+
+// Detect, score and suppress the rows [row_begin, row_end), looking one row beyond each side.
+template<int N>
+static void detect_tile(const cv::Mat_<uchar> &im, int barrier, int row_begin, int row_end, vector<pair<cv::Point2i, int> > &tile_corners)
+{
+	vector<cv::Point2i> corners;
+	vector<int> scores;
+	vector<pair<cv::Point2i, int> > suppressed;
+
+	fast_corner_detect_simd<N>(im, corners, barrier, row_begin - 1, row_end + 1);
+	compute_fast_score_old(im, corners, barrier, scores);
+	nonmax_suppression_with_scores(corners, scores, suppressed);
+
+	// drop the halo rows (they belong to the neighbouring tiles, which see their full neighbourhood)
+	tile_corners.clear();
+	for(unsigned int i=0; i < suppressed.size(); i++)
+		if(suppressed[i].first.y >= row_begin && suppressed[i].first.y < row_end)
+			tile_corners.push_back(suppressed[i]);
+}
+
+
+template<int N>
+void fast_corner_detect_nonmax_parallel(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows)
+{
+	max_corners.clear();
+
+	threads = max(threads, 1);
+	int rows = im.rows;
+	if(tile_rows <= 0)
+		tile_rows = max(1, (rows + 4 * threads - 1) / (4 * threads));
+
+	int tiles = (rows + tile_rows - 1) / tile_rows;
+	vector<vector<pair<cv::Point2i, int> > > tile_corners(tiles);
+
+	// Tiles are handed out through a shared counter, so faster threads pick up more of them
+	atomic<int> next_tile(0);
+	auto worker = [&]()
+	{
+		for(int t = next_tile++; t < tiles; t = next_tile++)
+			detect_tile<N>(im, barrier, t * tile_rows, min(rows, (t + 1) * tile_rows), tile_corners[t]);
+	};
+
+	vector<thread> pool;
+	for(int i=1; i < min(threads, tiles); i++)
+		pool.push_back(thread(worker));
+	worker();
+	for(unsigned int i=0; i < pool.size(); i++)
+		pool[i].join();
+
+	// Ordered merge: tiles are row bands, so concatenating them in order keeps the raster order
+	size_t total = 0;
+	for(int t=0; t < tiles; t++)
+		total += tile_corners[t].size();
+	max_corners.reserve(total);
+	for(int t=0; t < tiles; t++)
+		max_corners.insert(max_corners.end(), tile_corners[t].begin(), tile_corners[t].end());
+}
+
+
+template void fast_corner_detect_nonmax_parallel<4>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<5>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<6>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<7>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<8>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<9>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<10>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<11>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+template void fast_corner_detect_nonmax_parallel<12>(const cv::Mat_<uchar> &im, vector<pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows);
+
+}
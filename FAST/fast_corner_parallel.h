@@ -0,0 +1,31 @@
+#ifndef FAST_CORNER_PARALLEL_H
+#define FAST_CORNER_PARALLEL_H
+
+#include <vector>
+#include <utility>
+
+#include <opencv2/core.hpp>
+
+namespace FAST
+{
+	/// Tiled, multi-threaded FAST-N detection with non-maximal suppression.
+	///
+	/// The image is split in horizontal bands of rows (tiles), which a pool of threads picks up in turn.
+	/// Each tile is detected (@ref fast_corner_detect_simd) with a halo of one row above and below,
+	/// scored (@ref compute_fast_score_old) and non-maximally suppressed on its own; the halo rows make the 3x3
+	/// suppression at the tile seams see exactly the neighbours it would see in a full-image pass, and only the
+	/// corners of the tile's own rows are kept. The tiles are then concatenated in order, so the result is in
+	/// raster order and identical to
+	///
+	///     fast_corner_detect_simd<N>(im, corners, barrier);
+	///     fast_nonmax_with_scores(im, corners, barrier, max_corners);
+	///
+	/// @param im 		The input image
+	/// @param max_corners	The resulting locally maximal corners and their scores
+	/// @param barrier	Corner detection threshold
+	/// @param threads	Number of threads (1 runs everything on the calling thread)
+	/// @param tile_rows	Rows per tile (0 : about 4 tiles per thread, for load balancing)
+	template<int N> void fast_corner_detect_nonmax_parallel(const cv::Mat_<uchar> &im, std::vector<std::pair<cv::Point2i, int> > &max_corners, int barrier, int threads, int tile_rows = 0);
+}
+
+#endif
@@ -0,0 +1,306 @@
+#include <vector>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fast_corner.h"
+#include "fast_corner_simd.h"
+#include "fast_arena.h"
+
+using namespace std;
+
+namespace FAST
+{
+
+// Thin wrappers around the integer intrinsics, so that the detection kernel is written once
+// and instantiated for the register width we have.
+#if defined(__AVX2__)
+struct SimdOps
+{
+	typedef __m256i reg;
+	static const int width = 32;
+	static inline reg load(const uchar* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	static inline reg set1(int b) { return _mm256_set1_epi8((char)b); }
+	static inline reg adds(reg a, reg b) { return _mm256_adds_epu8(a, b); }
+	static inline reg subs(reg a, reg b) { return _mm256_subs_epu8(a, b); }
+	// a > b (unsigned), as 0xFF lanes
+	static inline reg gt(reg a, reg b) { return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(a, b), _mm256_setzero_si256()), _mm256_set1_epi8((char)0xFF)); }
+	static inline reg and_(reg a, reg b) { return _mm256_and_si256(a, b); }
+	static inline reg or_(reg a, reg b) { return _mm256_or_si256(a, b); }
+	static inline unsigned int movemask(reg a) { return (unsigned int)_mm256_movemask_epi8(a); }
+};
+#elif defined(__SSE2__)
+struct SimdOps
+{
+	typedef __m128i reg;
+	static const int width = 16;
+	static inline reg load(const uchar* p) { return _mm_loadu_si128((const __m128i*)p); }
+	static inline reg set1(int b) { return _mm_set1_epi8((char)b); }
+	static inline reg adds(reg a, reg b) { return _mm_adds_epu8(a, b); }
+	static inline reg subs(reg a, reg b) { return _mm_subs_epu8(a, b); }
+	// a > b (unsigned), as 0xFF lanes
+	static inline reg gt(reg a, reg b) { return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(a, b), _mm_setzero_si128()), _mm_set1_epi8((char)0xFF)); }
+	static inline reg and_(reg a, reg b) { return _mm_and_si128(a, b); }
+	static inline reg or_(reg a, reg b) { return _mm_or_si128(a, b); }
+	static inline unsigned int movemask(reg a) { return (unsigned int)_mm_movemask_epi8(a); }
+};
+#endif
+
+
+const char* fast_simd_instruction_set()
+{
+#if defined(__AVX2__)
+	return "AVX2";
+#elif defined(__SSE2__)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Lanes that start a run of N set masks (cyclic), by doubling the run length:
+// run[L][k] = m[k] & m[k+1] & ... & m[k+L-1]
+template<int N>
+static inline SimdOps::reg arc_test(const SimdOps::reg m[16])
+{
+	typedef SimdOps::reg reg;
+	reg run1[16], run2[16], run4[16], run8[16];
+	for(int k=0; k < 16; k++) run1[k] = m[k];
+	for(int k=0; k < 16; k++) run2[k] = SimdOps::and_(run1[k], run1[(k + 1) & 15]);
+	for(int k=0; k < 16; k++) run4[k] = SimdOps::and_(run2[k], run2[(k + 2) & 15]);
+	for(int k=0; k < 16; k++) run8[k] = SimdOps::and_(run4[k], run4[(k + 4) & 15]);
+
+	reg result = SimdOps::set1(0);
+	for(int k=0; k < 16; k++)
+	{
+		// compose the run of N starting at k from the binary digits of N (all compile-time constants)
+		reg r = SimdOps::set1(0xFF);
+		int at = k;
+		if(N & 8) { r = SimdOps::and_(r, run8[at & 15]); at += 8; }
+		if(N & 4) { r = SimdOps::and_(r, run4[at & 15]); at += 4; }
+		if(N & 2) { r = SimdOps::and_(r, run2[at & 15]); at += 2; }
+		if(N & 1) { r = SimdOps::and_(r, run1[at & 15]); at += 1; }
+		result = SimdOps::or_(result, r);
+	}
+	return result;
+}
+#endif
+
+
+// The detection loop over the rows [row_begin, row_end), written once for all outputs:
+// Every corner (in raster order) is handed to sink(x, y, p, offset), with p pointing at the pixel. 
+// If the sink returns false (e.g., it ran out of space), detection stops and so do we (returning false).
+template<int N, class Sink>
+static inline bool detect_rows(const cv::Mat_<uchar> &im, int b, int row_begin, int row_end, Sink &sink)
+{
+	const int stride = (int)im.step[0];
+	int offset[16];
+	for(int k=0; k < 16; k++)
+		offset[k] = fast_pixel_ring[k].x + fast_pixel_ring[k].y * stride;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+	// The vector path works on saturated bytes; a barrier outside [0, 255] is left to the scalar path
+	bool bVector = b >= 0 && b <= 255;
+#endif
+
+	row_begin = std::max(row_begin, 3);
+	row_end = std::min(row_end, im.rows - 3);
+
+	for(int y = row_begin; y < row_end; y++)
+	{
+		const uchar* row = im.ptr<uchar>(y);
+		int x = 3;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+		if(bVector)
+		{
+			typedef SimdOps::reg reg;
+			const reg barrier = SimdOps::set1(b);
+
+			// the ring of the last pixel of a segment reaches 3 columns further, so stop at cols - 3
+			for(; x + SimdOps::width <= im.cols - 3; x += SimdOps::width)
+			{
+				const uchar* p = row + x;
+				reg c = SimdOps::load(p);
+				reg hi = SimdOps::adds(c, barrier); // saturates at 255, where nothing can be brighter anyway
+				reg lo = SimdOps::subs(c, barrier); // ... and at 0, where nothing can be darker
+
+				// Early rejection with the compass points: any arc of N >= 4 contains at least one of them
+				reg quick = SimdOps::set1(0);
+				for(int k=0; k < 16; k += 4)
+				{
+					reg v = SimdOps::load(p + offset[k]);
+					quick = SimdOps::or_(quick, SimdOps::or_(SimdOps::gt(v, hi), SimdOps::gt(lo, v)));
+				}
+				if(SimdOps::movemask(quick) == 0)
+					continue;
+
+				reg bright[16], dark[16];
+				for(int k=0; k < 16; k++)
+				{
+					reg v = SimdOps::load(p + offset[k]);
+					bright[k] = SimdOps::gt(v, hi);
+					dark[k] = SimdOps::gt(lo, v);
+				}
+
+				unsigned int mask = SimdOps::movemask(SimdOps::or_(arc_test<N>(bright), arc_test<N>(dark)));
+
+				// lanes come out left to right, so the raster order is kept
+				while(mask)
+				{
+					int lane = __builtin_ctz(mask);
+					if(!sink(x + lane, y, p + lane, offset))
+						return false;
+					mask &= mask - 1;
+				}
+			}
+		}
+#endif
+		for(; x < im.cols - 3; x++)
+			if(fast_segment_test<N>(row + x, offset, b))
+				if(!sink(x, y, row + x, offset))
+					return false;
+	}
+	return true;
+}
+
+
+// Sinks for detect_rows
+struct push_corner
+{
+	vector<cv::Point2i> &corners;
+	push_corner(vector<cv::Point2i> &c) : corners(c) {}
+	inline bool operator()(int x, int y, const uchar*, const int*) { corners.push_back(cv::Point2i(x, y)); return true; }
+};
+
+template<int N>
+struct push_scored_corner
+{
+	vector<cv::Point2i> &corners;
+	vector<int> &scores;
+	int barrier;
+	push_scored_corner(vector<cv::Point2i> &c, vector<int> &s, int b) : corners(c), scores(s), barrier(b) {}
+	inline bool operator()(int x, int y, const uchar* p, const int* offset)
+	{
+		// scored right away, while the ring is still in cache
+		corners.push_back(cv::Point2i(x, y));
+		scores.push_back(fast_segment_score<N>(p, offset, barrier));
+		return true;
+	}
+};
+
+// Into a caller-owned arena: no allocations, and a full arena stops detection
+template<int N, bool Score>
+struct arena_corner
+{
+	fast_corner_arena &arena;
+	int barrier;
+	arena_corner(fast_corner_arena &a, int b) : arena(a), barrier(b) {}
+	inline bool operator()(int x, int y, const uchar* p, const int* offset)
+	{
+		return arena.push(x, y, Score ? fast_segment_score<N>(p, offset, barrier) : 0);
+	}
+};
+
+
+template<int N>
+void fast_corner_detect_simd(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b)
+{
+	fast_corner_detect_simd<N>(im, corners, b, 3, im.rows - 3);
+}
+
+
+template<int N>
+void fast_corner_detect_simd(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end)
+{
+	push_corner sink(corners);
+	detect_rows<N>(im, b, row_begin, row_end, sink);
+}
+
+
+template<int N>
+void fast_corner_detect_score_simd(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b)
+{
+	corners.clear();
+	scores.clear();
+	push_scored_corner<N> sink(corners, scores, b);
+	detect_rows<N>(im, b, 3, im.rows - 3, sink);
+}
+
+
+template<int N>
+bool fast_corner_detect_simd(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b)
+{
+	corners.clear();
+	arena_corner<N, false> sink(corners, b);
+	return detect_rows<N>(im, b, 3, im.rows - 3, sink);
+}
+
+
+template<int N>
+bool fast_corner_detect_score_simd(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b)
+{
+	corners.clear();
+	arena_corner<N, true> sink(corners, b);
+	return detect_rows<N>(im, b, 3, im.rows - 3, sink);
+}
+
+
+// N = 4 ... 6 are too short for proper corners, but they do fire on the saddle points (X-junctions) of a 
+// checkerboard, whose ring has four arcs of roughly 4 pixels each (see CalibImage::MakeFromImage).
+template void fast_corner_detect_simd<4>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<5>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<6>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<7>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<8>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<9>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<10>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<11>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+template void fast_corner_detect_simd<12>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b);
+
+template void fast_corner_detect_simd<4>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<5>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<6>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<7>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<8>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<9>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<10>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<11>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+template void fast_corner_detect_simd<12>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, int b, int row_begin, int row_end);
+
+template void fast_corner_detect_score_simd<4>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<5>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<6>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<7>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<8>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<9>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<10>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<11>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+template void fast_corner_detect_score_simd<12>(const cv::Mat_<uchar> &im, vector<cv::Point2i> &corners, vector<int> &scores, int b);
+
+template bool fast_corner_detect_simd<4>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<5>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<6>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<7>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<8>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<9>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<10>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<11>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_simd<12>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<4>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<5>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<6>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<7>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<8>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<9>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<10>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<11>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+template bool fast_corner_detect_score_simd<12>(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int b);
+
+}
@@ -0,0 +1,109 @@
+#ifndef FAST_CORNER_SIMD_H
+#define FAST_CORNER_SIMD_H
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "fast_arena.h"
+
+namespace FAST
+{
+	/// A single FAST-N segment test engine (N = 4 ... 12) in place of the generated decision trees.
+	///
+	/// Instead of walking a tree per pixel, a whole row segment (32 pixels with AVX2, 16 with SSE2)
+	/// is classified at once: For each of the 16 ring offsets (see @ref fast_pixel_ring) we compute
+	/// a "brighter" (p > c + b) and a "darker" (p < c - b) lane mask with saturating byte arithmetic.
+	/// A pixel is a corner if N contiguous (cyclic) ring masks are all set for either of the two, which is
+	/// worked out with a handful of ANDs by doubling the run length (1, 2, 4, 8 contiguous positions).
+	/// Segments in which no pixel passes the compass test (ring positions 0, 4, 8, 12) are skipped early.
+	/// The remainder of each row (and builds without SSE2) go through the scalar arc test below.
+	///
+	/// The output is in raster order and identical to fast_corner_detect_plain_N (for N = 7 ... 12, where those exist).
+	///
+	/// @param im 		The input image
+	/// @param corners	The resulting container of corner locations
+	/// @param barrier	Corner detection threshold
+	template<int N> void fast_corner_detect_simd(const cv::Mat_<uchar> &im, std::vector<cv::Point2i> &corners, int barrier);
+
+	/// As above, but only for the rows [row_begin, row_end) (clipped to the rows that have a full ring, i.e., [3, rows - 3)).
+	/// Corners are appended to the container.
+	template<int N> void fast_corner_detect_simd(const cv::Mat_<uchar> &im, std::vector<cv::Point2i> &corners, int barrier, int row_begin, int row_end);
+
+	/// Fused FAST-N detection and scoring: Each corner is scored as soon as it is found (while its ring is still in cache),
+	/// so there is no second pass over the image. The score is the largest barrier at which the pixel is still a corner,
+	/// i.e., the same as fast_corner_score_N.
+	///
+	/// @param im 		The input image
+	/// @param corners	The resulting container of corner locations (raster order)
+	/// @param scores	The scores of the corners
+	/// @param barrier	Corner detection threshold
+	template<int N> void fast_corner_detect_score_simd(const cv::Mat_<uchar> &im, std::vector<cv::Point2i> &corners, std::vector<int> &scores, int barrier);
+
+	/// Allocation-free FAST-N detection into a caller-owned arena (scores are left at 0).
+	/// The arena is cleared first; if it fills up, detection stops there and the function returns false
+	/// (with arena.overflow set and the corners found so far kept).
+	///
+	/// @param im 		The input image
+	/// @param corners	The arena that receives the corner locations (raster order)
+	/// @param barrier	Corner detection threshold
+	template<int N> bool fast_corner_detect_simd(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int barrier);
+
+	/// Allocation-free fused detection and scoring (see above) into a caller-owned arena; false on overflow.
+	template<int N> bool fast_corner_detect_score_simd(const cv::Mat_<uchar> &im, fast_corner_arena &corners, int barrier);
+
+	/// The instruction set fast_corner_detect_simd was compiled for ("AVX2", "SSE2" or "scalar")
+	const char* fast_simd_instruction_set();
+
+	/// Scalar arc test: True if the 16-bit ring mask contains N contiguous set bits (cyclically).
+	template<int N> inline bool fast_arc_test(unsigned int mask16)
+	{
+		// Duplicate the ring so that runs which wrap around position 15 -> 0 become plain runs,
+		// then shift-and the mask N-1 times: a bit survives only if it starts a run of N.
+		unsigned int run = mask16 | (mask16 << 16);
+		for(int i=1; i < N; i++)
+			run &= run >> 1;
+
+		return (run & 0xFFFF) != 0;
+	}
+
+	/// The brighter (p > c + b) and darker (p < c - b) ring masks of the pixel at p (bit k for ring position k).
+	inline void fast_ring_masks(const uchar* p, const int offset[16], int b, unsigned int &bright, unsigned int &dark)
+	{
+		int cb = *p + b;
+		int c_b = *p - b;
+		bright = dark = 0;
+		for(int k=0; k < 16; k++)
+		{
+			int v = p[offset[k]];
+			bright |= (unsigned int)(v > cb) << k;
+			dark |= (unsigned int)(v < c_b) << k;
+		}
+	}
+
+	/// Scalar segment test of the pixel at p (same comparisons as the generated trees)
+	template<int N> inline bool fast_segment_test(const uchar* p, const int offset[16], int b)
+	{
+		unsigned int bright, dark;
+		fast_ring_masks(p, offset, b, bright, dark);
+		return fast_arc_test<N>(bright) || fast_arc_test<N>(dark);
+	}
+
+	/// The largest barrier (>= b) at which the pixel at p, known to be a corner at b, is still a corner.
+	/// The segment test is monotonic in the barrier, so a bisection over [b, 255] does it in 8 tests at most.
+	template<int N> inline int fast_segment_score(const uchar* p, const int offset[16], int b)
+	{
+		int lo = b, hi = 256; // corner at lo, not a corner at hi
+		while(hi - lo > 1)
+		{
+			int mid = (lo + hi) / 2;
+			if(fast_segment_test<N>(p, offset, mid))
+				lo = mid;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+}
+
+#endif
@@ -1,6 +1,7 @@
 //#include <cvd/image_ref.h>
 //#include <cvd/nonmax_suppression.h>
 #include <vector>
+#include <algorithm>
 #include "nonmax_suppression.h"
 
 #include "prototypes.h"
@@ -31,15 +32,17 @@ inline void nonmax_suppression_t(const vector<cv::Point2i> &corners, const vecto
 	
 	// Find where each row begins
 	// (the corners are output in raster scan order). A beginning of -1 signifies
-	// that there are no corners on that row.
+	// that there are no corners on that row. The index starts at the first row with
+	// corners, so a band of rows (a tile, see fast_corner_parallel.cpp) only pays for its own rows.
+	int first_row = corners.front().y;
 	int last_row = corners.back().y;
-	vector<int> row_start(last_row + 1, -1);
+	vector<int> row_start(last_row - first_row + 1, -1);
 
 	int prev_row = -1;
 	for(unsigned int i=0; i< corners.size(); i++)
 		if(corners[i].y != prev_row)
 		{
-			row_start[corners[i].y] = i;
+			row_start[corners[i].y - first_row] = i;
 			prev_row = corners[i].y;
 		}
 	
@@ -68,11 +71,11 @@ inline void nonmax_suppression_t(const vector<cv::Point2i> &corners, const vecto
 			  continue;
 			
 		//Check above (if there is a valid row above)
-		if(pos.y != 0 && row_start[pos.y - 1] != -1) 
+		if(pos.y != first_row && row_start[pos.y - 1 - first_row] != -1) 
 		{
 			//Make sure that current point_above is one
 			//row above.
-			if(corners[point_above].y < pos.y - 1) point_above = row_start[pos.y-1];
+			if(corners[point_above].y < pos.y - 1) point_above = row_start[pos.y - 1 - first_row];
 			
 			//Make point_above point to the first of the pixels above the current point,
 			//if it exists.
@@ -90,10 +93,10 @@ inline void nonmax_suppression_t(const vector<cv::Point2i> &corners, const vecto
 		}
 			
 		//Check below (if there is anything below)
-		if(pos.y != last_row && row_start[pos.y + 1] != -1 && point_below < sz) //Nothing below
+		if(pos.y != last_row && row_start[pos.y + 1 - first_row] != -1 && point_below < sz) //Nothing below
 		{
 			if(corners[point_below].y < pos.y + 1)
-				point_below = row_start[pos.y+1];
+				point_below = row_start[pos.y + 1 - first_row];
 			
 			// Make point below point to one of the pixels belowthe current point, if it
 			// exists.
@@ -165,4 +168,84 @@ void nonmax_suppression_with_scores(const vector<cv::Point2i> &corners, const ve
 	nonmax_suppression_t<int, pair<cv::Point2i,int> , collect_score, Greater>(corners, scores, nonmax_corners);
 }
 
-}
\ No newline at end of file
+// The same (non-strict) suppression over the structure of arrays of an arena. The output goes into
+// the caller's arena and the row index into the workspace, so nothing is allocated once both are big enough.
+bool nonmax_suppression(const fast_corner_arena &corners, fast_corner_arena &nonmax_corners, fast_nonmax_workspace &workspace)
+{
+	nonmax_corners.clear();
+
+	const int sz = corners.size;
+	if(sz < 1) return true;
+
+	const int* cx = &corners.x[0];
+	const int* cy = &corners.y[0];
+	const int* scores = &corners.score[0];
+
+	// Find where each row begins (-1 : no corners on that row)
+	int last_row = cy[sz - 1];
+	vector<int> &row_start = workspace.row_start;
+	if((int)row_start.size() < last_row + 2)
+		row_start.resize(last_row + 2);
+	std::fill(row_start.begin(), row_start.begin() + last_row + 2, -1);
+
+	int prev_row = -1;
+	for(int i=0; i < sz; i++)
+		if(cy[i] != prev_row)
+		{
+			row_start[cy[i]] = i;
+			prev_row = cy[i];
+		}
+
+	int point_above = 0;
+	int point_below = 0;
+
+	for(int i=0; i < sz; i++)
+	{
+		int score = scores[i];
+		int px = cx[i], py = cy[i];
+
+		//Check left
+		if(i > 0 && cy[i-1] == py && cx[i-1] == px - 1 && Greater::Compare(scores[i-1], score))
+			continue;
+
+		//Check right
+		if(i < sz - 1 && cy[i+1] == py && cx[i+1] == px + 1 && Greater::Compare(scores[i+1], score))
+			continue;
+
+		//Check above (if there is a valid row above)
+		if(py != 0 && row_start[py - 1] != -1)
+		{
+			if(cy[point_above] < py - 1) point_above = row_start[py - 1];
+
+			for(; cy[point_above] < py && cx[point_above] < px - 1; point_above++)
+			{}
+
+			for(int j=point_above; cy[j] < py && cx[j] <= px + 1; j++)
+				if(cx[j] >= px - 1 && Greater::Compare(scores[j], score))
+					goto cont;
+		}
+
+		//Check below (if there is anything below)
+		if(py != last_row && row_start[py + 1] != -1 && point_below < sz)
+		{
+			if(cy[point_below] < py + 1)
+				point_below = row_start[py + 1];
+
+			for(; point_below < sz && cy[point_below] == py + 1 && cx[point_below] < px - 1; point_below++)
+			{}
+
+			for(int j=point_below; j < sz && cy[j] == py + 1 && cx[j] <= px + 1; j++)
+				if(cx[j] >= px - 1 && Greater::Compare(scores[j], score))
+					goto cont;
+		}
+
+		if(!nonmax_corners.push(px, py, score))
+			return false;
+
+		cont:
+			;
+	}
+	return true;
+}
+
+}
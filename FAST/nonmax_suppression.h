@@ -8,6 +8,8 @@
 #include <cv.hpp>
 #include <highgui.hpp>
 
+#include "fast_arena.h"
+
 
 
 namespace FAST
@@ -36,6 +38,16 @@ namespace FAST
 	*/
 	void nonmax_suppression_with_scores(const std::vector<cv::Point2i>& corners, const std::vector<int>& scores, std::vector<std::pair<cv::Point2i,int> > &max_corners);
 
+	/**Perform nonmaximal suppression on the (raster ordered) corners of an arena, in a 3 by 3 window.
+	   Non strict, i.e. the same as nonmax_suppression_with_scores, but without any heap allocations
+	   once the workspace has seen an image of the same height.
+	@param corners The corner locations and scores
+	@param max_corners The locally maximal corners, and their scores (cleared first).
+	@param workspace Scratch space, reused across calls
+	@return false if max_corners ran out of capacity.
+	*/
+	bool nonmax_suppression(const fast_corner_arena &corners, fast_corner_arena &max_corners, fast_nonmax_workspace &workspace);
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+// George Terzakis 2016 - University of Portsmouth
+
+#include "FramePipeline.h"
+#include "Profiling.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+
+FramePipeline::FramePipeline(VideoSource &videoSource, int nWorkers, int nQueueSize) :
+  mVideoSource(videoSource), mqCaptured(std::max(nQueueSize, 1)), mqCommitted(std::max(nQueueSize, 1)),
+  mnNextCommit(0), mbDetecting(true), mbStop(false), mnDropped(0)
+{
+  nWorkers = std::max(nWorkers, 1);
+  cout << "  Frame pipeline: capture thread, " << nWorkers << " detection worker(s), queues of "
+       << std::max(nQueueSize, 1) << " frames." << endl;
+
+  mnWorkersRunning = nWorkers;
+  mCaptureThread = std::thread(&FramePipeline::CaptureLoop, this);
+  for(int i=0; i<nWorkers; i++)
+    mvWorkerThreads.push_back(std::thread(&FramePipeline::WorkerLoop, this));
+}
+
+
+FramePipeline::~FramePipeline()
+{
+  mbStop = true;
+  // (closing the queues wakes up the workers, and the GL thread if it were still waiting)
+  mqCaptured.Close();
+  mqCommitted.Close();
+  if(mCaptureThread.joinable()) mCaptureThread.join();
+  for(unsigned int i=0; i<mvWorkerThreads.size(); i++)
+    mvWorkerThreads[i].join();
+}
+
+
+void FramePipeline::CaptureLoop()
+{
+  static Profiling::Stage gStageCapture("Pipeline.Capture");
+
+  int nFrame = 0;
+  while(!mbStop) {
+
+    FramePtr pFrame(new Frame);
+    {
+      Profiling::ScopedTimer timer(gStageCapture);
+      // (no more frames: the end of a recording, or the camera failed)
+      if(!mVideoSource.GetAndFillFrameBWandRGB(pFrame->imBW, pFrame->imRGB)) break;
+    }
+    pFrame->nFrame = nFrame++;
+    pFrame->bDetected = pFrame->bMade = false;
+
+    // The workers are behind: the oldest frame waiting for them goes, and the commit must not wait for it
+    bool bDropped;
+    FramePtr pDropped;
+    if(!mqCaptured.Push(pFrame, &bDropped, &pDropped)) break;
+    if(bDropped) {
+      mnDropped++;
+      Commit(pDropped->nFrame, FramePtr());
+    }
+  }
+  // The workers finish what is in the queue, and then the last one closes the result queue
+  mqCaptured.Close();
+}
+
+
+void FramePipeline::WorkerLoop()
+{
+  static Profiling::Stage gStageDetect("Pipeline.Detect");
+
+  FramePtr pFrame;
+  while(mqCaptured.Pop(pFrame)) {
+
+    if(mbDetecting && !mbStop) {
+      Profiling::ScopedTimer timer(gStageDetect);
+      // The detection draws into this thread's batch (see GLBatch.h), which is moved over to the frame
+      GLXInterface::GLBatch &batch = GLXInterface::glBatch();
+      batch.Clear();
+      pFrame->bMade = pFrame->calibImage.MakeFromImage(pFrame->imBW, pFrame->imRGB);
+      pFrame->bDetected = true;
+      pFrame->batch.Append(batch);
+      batch.Clear();
+    }
+    Commit(pFrame->nFrame, pFrame);
+  }
+
+  if(--mnWorkersRunning == 0) mqCommitted.Close();
+}
+
+
+void FramePipeline::Commit(int nFrame, const FramePtr &pFrame)
+{
+  std::lock_guard<std::mutex> lock(mCommitMutex);
+  mmPending[nFrame] = pFrame;
+
+  // Everything that is next in line goes out (in order; the dropped frames are just skipped)
+  std::map<int, FramePtr>::iterator it = mmPending.begin();
+  while(it != mmPending.end() && it->first == mnNextCommit) {
+
+    if(it->second) {
+      bool bDropped;
+      mqCommitted.Push(it->second, &bDropped);
+      if(bDropped) mnDropped++;
+    }
+    mmPending.erase(it++);
+    mnNextCommit++;
+  }
+}
+
+
+bool FramePipeline::GetFrames(std::vector<FramePtr> &vFrames)
+{
+  // (the time the GL thread waits for the other stages: ~0 if rendering is the slowest one)
+  static Profiling::Stage gStageWait("Pipeline.Wait");
+  static Profiling::Stage gStageDropped("Pipeline.Dropped", Profiling::COUNTER);
+
+  vFrames.clear();
+  FramePtr pFrame;
+  {
+    Profiling::ScopedTimer timer(gStageWait);
+    if(!mqCommitted.Pop(pFrame)) return false;
+  }
+  vFrames.push_back(pFrame);
+  while(mqCommitted.TryPop(pFrame)) vFrames.push_back(pFrame);
+
+  gStageDropped.Add(mnDropped.exchange(0));
+  return true;
+}
@@ -0,0 +1,156 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+//
+// FramePipeline.h
+// Capture -> detect -> render, each stage on its own thread(s)
+//
+// Without it, the calibrator grabs a frame, detects the grid in it and draws it one after the other, so the frame
+// rate is one over the sum of the stages. With it:
+//   - a capture thread pulls frames from the VideoSource (numbered in the order they come) into the frame queue,
+//   - N detection workers take frames from that queue and run CalibImage::MakeFromImage on them, out of order,
+//     each drawing into its own GL batch (see GLBatch.h), which goes with the result,
+//   - the results are committed in frame order (a result waits for the ones of the earlier frames), into the result queue,
+//   - and the GL thread takes whatever has been committed since its last look, draws the latest and decides on grabbing.
+// So the frame rate is that of the slowest stage.
+//
+// Both queues are bounded (CameraCalibrator.PipelineQueueSize), and when one is full the OLDEST entry is dropped:
+// a stage that falls behind works on the newest frames rather than on a backlog (frames that are dropped before
+// detection are skipped by the in-order commit). The drops are counted in the Pipeline.Dropped stage (see Profiling.h).
+
+#ifndef __FRAME_PIPELINE_H
+#define __FRAME_PIPELINE_H
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "OpenCV.h"
+#include "CalibImage.h"
+#include "VideoSource.h"
+#include "GCVD/GLBatch.h"
+
+
+// A queue of at most nCapacity entries that never blocks the producer: pushing into a full queue drops the oldest entry.
+// Pop waits for an entry, until the queue is closed (and drained).
+template<class T>
+class DropOldestQueue
+{
+ public:
+  DropOldestQueue(unsigned int nCapacity) : mnCapacity(nCapacity), mbClosed(false) {}
+
+  // False if the queue is closed (the entry is not queued then). If the queue was full, the oldest entry goes to
+  // *pDropped (if given) and *pbDropped is set.
+  bool Push(const T &t, bool *pbDropped = NULL, T *pDropped = NULL)
+  {
+    if(pbDropped) *pbDropped = false;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if(mbClosed) return false;
+      if(mqEntries.size() >= mnCapacity) {
+	if(pbDropped) *pbDropped = true;
+	if(pDropped) *pDropped = mqEntries.front();
+	mqEntries.pop_front();
+      }
+      mqEntries.push_back(t);
+    }
+    mcvNotEmpty.notify_one();
+    return true;
+  }
+
+  // Waits for an entry; false if the queue was closed and there are no more
+  bool Pop(T &t)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mcvNotEmpty.wait(lock, [this]() { return mbClosed || !mqEntries.empty(); });
+    if(mqEntries.empty()) return false;
+    t = mqEntries.front();
+    mqEntries.pop_front();
+    return true;
+  }
+
+  // Does not wait; false if there is nothing in the queue
+  bool TryPop(T &t)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(mqEntries.empty()) return false;
+    t = mqEntries.front();
+    mqEntries.pop_front();
+    return true;
+  }
+
+  // No more pushes; the entries still in the queue can be popped
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mbClosed = true;
+    }
+    mcvNotEmpty.notify_all();
+  }
+
+ private:
+  std::deque<T> mqEntries;
+  unsigned int mnCapacity;
+  bool mbClosed;
+  std::mutex mMutex;
+  std::condition_variable mcvNotEmpty;
+};
+
+
+class FramePipeline
+{
+ public:
+  // A frame on its way through the pipeline, and (past the workers) what the detection made of it
+  struct Frame
+  {
+    int nFrame;                  // the order of the frame in the video
+    cv::Mat_<uchar> imBW;
+    cv::Mat imRGB;
+    bool bDetected;              // MakeFromImage was run (it is not while the calibrator is optimizing)
+    bool bMade;                  // ... and found a grid, so calibImage can be grabbed
+    CalibImage calibImage;
+    GLXInterface::GLBatch batch; // the drawing of the detection, to be appended to the GL thread's batch
+  };
+  typedef std::shared_ptr<Frame> FramePtr;
+
+  // Starts the capture thread and nWorkers (at least one) detection workers, with queues of nQueueSize frames
+  FramePipeline(VideoSource &videoSource, int nWorkers, int nQueueSize);
+  // Stops and joins all the threads (the capture thread finishes the frame it is grabbing first)
+  ~FramePipeline();
+
+  // GL thread: waits for the next committed frame, and gets it along with any others committed meanwhile, in frame
+  // order (so the latest is the last). False once the video has ended and every frame has been handed out.
+  bool GetFrames(std::vector<FramePtr> &vFrames);
+
+  // Whether the workers should run the detection on the frames (they just pass them on otherwise)
+  void SetDetecting(bool bDetecting) { mbDetecting = bDetecting; }
+
+ private:
+  void CaptureLoop();
+  void WorkerLoop();
+  // Commits frame nFrame (a NULL pFrame: the frame was dropped), and whatever was waiting for it
+  void Commit(int nFrame, const FramePtr &pFrame);
+
+  VideoSource &mVideoSource;
+  DropOldestQueue<FramePtr> mqCaptured;   // capture -> workers
+  DropOldestQueue<FramePtr> mqCommitted;  // commit -> GL thread
+
+  // The in-order commit
+  std::mutex mCommitMutex;
+  std::map<int, FramePtr> mmPending;      // frames done ahead of their turn (NULL: dropped)
+  int mnNextCommit;                       // the frame whose turn it is
+
+  std::atomic<bool> mbDetecting;
+  std::atomic<bool> mbStop;
+  std::atomic<int> mnDropped;             // frames dropped by both queues, since the last GetFrames
+  std::atomic<int> mnWorkersRunning;      // the last one out closes the result queue
+  std::thread mCaptureThread;
+  std::vector<std::thread> mvWorkerThreads;
+};
+
+#endif
@@ -0,0 +1,185 @@
+// The buffer object entry points (GL 1.5) come from glext.h
+#define GL_GLEXT_PROTOTYPES
+
+#include <cstring>
+#include <cstdlib>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "GLBatch.h"
+
+namespace GLXInterface
+{
+
+GLBatch& glBatch()
+{
+	static thread_local GLBatch batch;
+	return batch;
+}
+
+
+bool GLBatch::Style::operator==(const Style &s) const
+{
+	return nPrimitive == s.nPrimitive && fSize == s.fSize && bSmooth == s.bSmooth &&
+	       afColor[0] == s.afColor[0] && afColor[1] == s.afColor[1] && afColor[2] == s.afColor[2] && afColor[3] == s.afColor[3];
+}
+
+
+GLBatch::GLBatch() : mnVBO(0), mbVBOChecked(false)
+{
+	mCurrent.nPrimitive = GL_POINTS;
+	mCurrent.afColor[0] = mCurrent.afColor[1] = mCurrent.afColor[2] = mCurrent.afColor[3] = 1.0f;
+	mCurrent.fSize = 1.0f;
+	mCurrent.bSmooth = false;
+	mnLastBucket[0] = mnLastBucket[1] = -1;
+}
+
+
+void GLBatch::Color(float r, float g, float b, float a)
+{
+	mCurrent.afColor[0] = r; mCurrent.afColor[1] = g; mCurrent.afColor[2] = b; mCurrent.afColor[3] = a;
+}
+
+void GLBatch::PointSize(float fSize) { mCurrent.fSize = fSize; }
+void GLBatch::LineWidth(float fWidth) { mCurrent.fSize = fWidth; }
+void GLBatch::Smooth(bool bSmooth) { mCurrent.bSmooth = bSmooth; }
+
+
+// The bucket for the current style and the given primitive (created on first use)
+std::vector<float>& GLBatch::Vertices(GLenum nPrimitive)
+{
+	Style style = mCurrent;
+	style.nPrimitive = nPrimitive;
+	return Vertices(style);
+}
+
+
+std::vector<float>& GLBatch::Vertices(const Style &style)
+{
+	int nSlot = style.nPrimitive == GL_POINTS ? 0 : 1;
+
+	// most appends continue with the style of the previous one
+	if(mnLastBucket[nSlot] >= 0 && mvBuckets[mnLastBucket[nSlot]].style == style)
+		return mvBuckets[mnLastBucket[nSlot]].vfVertices;
+
+	// a handful of styles per frame, so a linear search it is
+	for(unsigned int i=0; i<mvBuckets.size(); i++)
+		if(mvBuckets[i].style == style) {
+			mnLastBucket[nSlot] = i;
+			return mvBuckets[i].vfVertices;
+		}
+
+	mvBuckets.push_back(Bucket());
+	mvBuckets.back().style = style;
+	mnLastBucket[nSlot] = mvBuckets.size() - 1;
+	return mvBuckets.back().vfVertices;
+}
+
+
+void GLBatch::Point(float x, float y)
+{
+	std::vector<float> &v = Vertices(GL_POINTS);
+	v.push_back(x);
+	v.push_back(y);
+}
+
+
+void GLBatch::Line(float x0, float y0, float x1, float y1)
+{
+	std::vector<float> &v = Vertices(GL_LINES);
+	v.push_back(x0);
+	v.push_back(y0);
+	v.push_back(x1);
+	v.push_back(y1);
+}
+
+
+void GLBatch::Clear()
+{
+	for(unsigned int i=0; i<mvBuckets.size(); i++)
+		mvBuckets[i].vfVertices.clear();
+}
+
+
+void GLBatch::Append(const GLBatch &other)
+{
+	for(unsigned int i=0; i<other.mvBuckets.size(); i++) {
+		const Bucket &b = other.mvBuckets[i];
+		if(b.vfVertices.empty()) continue;
+		std::vector<float> &v = Vertices(b.style);
+		v.insert(v.end(), b.vfVertices.begin(), b.vfVertices.end());
+	}
+}
+
+
+void GLBatch::Flush()
+{
+	// Pack the buckets back to back (in first use order)
+	mvfStaging.clear();
+	for(unsigned int i=0; i<mvBuckets.size(); i++)
+		mvfStaging.insert(mvfStaging.end(), mvBuckets[i].vfVertices.begin(), mvBuckets[i].vfVertices.end());
+	if(mvfStaging.empty())
+		return;
+
+	// Buffer objects are core since GL 1.5
+	if(!mbVBOChecked) {
+		mbVBOChecked = true;
+		const char* pVersion = (const char*) glGetString(GL_VERSION);
+		const char* pMinor = pVersion == NULL ? NULL : strchr(pVersion, '.');
+		if(pMinor != NULL && (atoi(pVersion) > 1 || atoi(pMinor + 1) >= 5))
+			glGenBuffers(1, &mnVBO);
+	}
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POINT_BIT | GL_LINE_BIT | GL_COLOR_BUFFER_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glDisable(GL_TEXTURE_2D);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+	// One upload for the whole frame (the old storage is orphaned, so there is no wait on the previous frame's draws)
+	const float* pBase = &mvfStaging[0];
+	if(mnVBO != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, mnVBO);
+		glBufferData(GL_ARRAY_BUFFER, mvfStaging.size() * sizeof(float), pBase, GL_STREAM_DRAW);
+		glVertexPointer(2, GL_FLOAT, 0, 0);
+	}
+	else
+		glVertexPointer(2, GL_FLOAT, 0, pBase);
+
+	// ... and a single draw per style
+	GLint nFirst = 0;
+	for(unsigned int i=0; i<mvBuckets.size(); i++) {
+
+		const Bucket &b = mvBuckets[i];
+		GLsizei nCount = b.vfVertices.size() / 2;
+		if(nCount == 0) continue;
+
+		glColor4fv(b.style.afColor);
+		GLenum nSmooth = b.style.nPrimitive == GL_POINTS ? GL_POINT_SMOOTH : GL_LINE_SMOOTH;
+		if(b.style.nPrimitive == GL_POINTS)
+			glPointSize(b.style.fSize);
+		else
+			glLineWidth(b.style.fSize);
+		if(b.style.bSmooth) {
+			glEnable(nSmooth);
+			glEnable(GL_BLEND);
+		}
+		else {
+			glDisable(nSmooth);
+			glDisable(GL_BLEND);
+		}
+
+		glDrawArrays(b.style.nPrimitive, nFirst, nCount);
+		nFirst += nCount;
+	}
+
+	if(mnVBO != 0)
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glPopClientAttrib();
+	glPopAttrib();
+
+	Clear();
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef GLBATCH_H
+#define GLBATCH_H
+
+#include <vector>
+
+#include <GL/gl.h>
+
+namespace GLXInterface
+{
+	/// Collects 2D points and lines during a frame and draws them all at once.
+	///
+	/// Instead of a glBegin/glVertex/glEnd per primitive, the drawing code sets a style (color, point size or
+	/// line width, smoothing) and appends vertices; vertices of the same primitive type and style go into
+	/// the same bucket. Flush() packs all buckets into one vertex buffer object (a single upload) and issues one
+	/// glDrawArrays per bucket, in the order in which the styles were first used in the frame.
+	/// The buckets are plain vectors that are cleared but never shrunk, so once warmed up, a frame costs no allocations.
+	///
+	/// Vertices are in the coordinate frame that is current at Flush() (the video ortho frame for the calibrator).
+	class GLBatch
+	{
+	public:
+		GLBatch();
+
+		/// Style of the subsequent primitives
+		void Color(float r, float g, float b, float a = 1.0f);
+		void PointSize(float fSize);
+		void LineWidth(float fWidth);
+		void Smooth(bool bSmooth);	///< antialiased (blended) points and lines
+
+		/// Append a point / a line segment
+		void Point(float x, float y);
+		void Line(float x0, float y0, float x1, float y1);
+
+		/// Draw everything appended since the last Flush() (needs the GL context), then start over
+		void Flush();
+
+		/// Drop everything appended since the last Flush() without drawing it
+		void Clear();
+
+		/// Append everything appended to another batch (style by style; no GL calls, so any thread can do it)
+		void Append(const GLBatch &other);
+
+	private:
+		struct Style
+		{
+			GLenum nPrimitive;	// GL_POINTS or GL_LINES
+			float afColor[4];
+			float fSize;		// point size or line width
+			bool bSmooth;
+			bool operator==(const Style &s) const;
+		};
+
+		struct Bucket
+		{
+			Style style;
+			std::vector<float> vfVertices;	// x, y pairs
+		};
+
+		std::vector<float>& Vertices(GLenum nPrimitive);
+		std::vector<float>& Vertices(const Style &style);
+
+		Style mCurrent;				// the style set by the caller (primitive left open)
+		std::vector<Bucket> mvBuckets;		// first use order; empty buckets are kept for reuse
+		int mnLastBucket[2];			// the bucket last used for points / lines (a cache for the lookup)
+		std::vector<float> mvfStaging;		// all buckets back to back, for the single upload
+		GLuint mnVBO;				// 0 : not created (or no VBO support; client arrays then)
+		bool mbVBOChecked;
+	};
+
+	/// The batch the calibrator's drawing code appends to (flushed once per frame).
+	/// Every thread has its own: the detection workers draw into theirs and hand the result over to the GL thread
+	/// (see FramePipeline.h), which appends it to its own batch before the Flush().
+	GLBatch& glBatch();
+}
+
+#endif
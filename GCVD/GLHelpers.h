@@ -42,7 +42,8 @@ namespace GLXInterface
 	enum TEXT_STYLE {
 	  FILL = 0,       ///< renders glyphs as filled polygons
 	  OUTLINE = 1,    ///< renders glyphs as outlines with GL_LINES
-	  NICE = 2        ///< renders glyphs filled with antialiased outlines
+	  NICE = 2,       ///< renders glyphs filled with antialiased outlines
+	  ATLAS = 3       ///< renders glyphs as textured quads from a glyph atlas of the font (see @ref glBuildTextAtlas)
 	};
 
 	/// renders a string in GL using the current settings.
@@ -59,6 +60,11 @@ namespace GLXInterface
 	/// returns the size of the bounding box of a text to be rendered, similar to @ref glDrawText but without any visual output
 	std::pair<double, double> glGetExtends(const std::string & text, double spacing = 1.5, double kerning = 0.1);
 
+	/// builds the glyph atlas of the current font: every glyph is rasterized (antialiased) once into a single alpha texture,
+	/// so that text in the @ref ATLAS style is drawn with one textured quad per character and one draw call per string.
+	/// Needs a current GL context; glDrawText builds the atlas on first use otherwise.
+	void glBuildTextAtlas();
+
   
 	/// @defgroup gGLText OpenGL text rendering
 	/// sets the font to use for future font rendering commands. currently sans, serif and mono are available.
@@ -264,6 +270,18 @@ namespace GLXInterface
 		glMultMatrixd(glm);
 	}
 
+	/// @overload (the fixed-size matrices of SO3)
+	template <class P> inline void glMultMatrix3x3( const cv::Matx<P, 3, 3> &m )
+	{
+		GLdouble glm[16];
+		glm[0] = m(0, 0); glm[1] = m(1, 0); glm[2] = m(2, 0); glm[3] = 0;
+		glm[4] = m(0, 1); glm[5] = m(1, 1); glm[6] = m(2, 1); glm[7] = 0;
+		glm[8] = m(0, 2); glm[9] = m(1, 2); glm[10] = m(2, 2); glm[11] = 0;
+		glm[12] = 0; glm[13] = 0; glm[14] = 0; glm[15] = 1;
+		
+		glMultMatrixd(glm);
+	}
+
 	/// multiply a TooN 2x2 matrix onto the current matrix stack. The TooN matrix
 	/// will only occupy the upper left hand block, the remainder will be from the
 	/// identity matrix. The matrix is also transposed to account for GL's column major format.
@@ -278,6 +296,17 @@ namespace GLXInterface
 		glMultMatrixd(glm);
 	}
 
+	/// @overload (the fixed-size matrices of SO2)
+	template <class P> inline void glMultMatrix2x2( const cv::Matx<P, 2, 2> &m )
+	{
+		GLdouble glm[16];
+		glm[0] = m(0, 0); glm[1] = m(1, 0); glm[2] = 0; glm[3] = 0;
+		glm[4] = m(0, 1); glm[5] = m(1, 1); glm[6] = 0; glm[7] = 0;
+		glm[8] = 0; glm[9] = 0; glm[10] = 1; glm[11] = 0;
+		glm[12] = 0; glm[13] = 0; glm[14] = 0; glm[15] = 1;
+		glMultMatrixd(glm);
+	}
+
 	/// multiplies a SO3 onto the current matrix stack
 	/// @param so3 the SO3
 	template <typename P>
@@ -4,6 +4,9 @@
 #include <cassert>
 #include <cmath> 
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <cctype>
 
 
 // the fonts defined in these headers are derived from Bitstream Vera fonts. See http://www.gnome.org/fonts/ for license and details
@@ -31,7 +34,269 @@ const std::string& glGetFont() {
   return data.currentFontName;
 }
 
+// ************************************* GLYPH ATLAS ****************************************
+// The vector glyphs are rasterized once (on the CPU, from their triangles, with 4x4 supersampling) into one alpha texture.
+// A string is then laid out into textured quads (the same layout as glDrawText) and drawn with a single glDrawArrays.
+// Laid out strings are cached, so an unchanged caption or menu label costs a map lookup and a draw call.
+
+static const int ATLAS_PIXELS_PER_UNIT = 16;   // glyph resolution (text is normally drawn at 8 pixels per unit)
+static const int ATLAS_SUPERSAMPLING = 4;      // samples per pixel, per axis
+static const int ATLAS_WIDTH = 512;
+static const size_t ATLAS_MAX_CACHED = 256;    // laid out strings kept (slider values keep making new ones)
+
+struct GlyphAtlas {
+
+    struct Glyph {
+        bool visible;                   // false for blanks (advance only)
+        float x0, y0, x1, y1;           // quad in font units (y up)
+        float u0, v0, u1, v1;           // texture coordinates (v0 : top)
+    };
+
+    struct Layout {
+        double spacing, kerning;
+        std::vector<float> quads;       // x, y, u, v per vertex, 4 vertices per visible character
+        std::pair<double, double> extends;
+    };
+
+    GLuint texture;
+    Glyph glyphs[256];
+    std::map<std::string, Layout> cache;
+
+    GlyphAtlas() : texture(0) {
+        for(int i = 0; i < 256; ++i)
+            glyphs[i].visible = false;
+    }
+};
+
+static map<const Font*, GlyphAtlas> atlases;
+
+
+// Rasterize the glyph of character c into an alpha bitmap (row 0 at the top) and fill in its quad
+static void rasterizeGlyph(const Font & font, const Font::Char & ch, GlyphAtlas::Glyph & glyph, std::vector<unsigned char> & bitmap, int & w, int & h)
+{
+    const int S = ATLAS_PIXELS_PER_UNIT, SS = ATLAS_SUPERSAMPLING;
+    glyph.visible = false;
+    w = h = 0;
+    if(ch.numTriangles == 0)
+        return;
+
+    const Point * v = font.vertices + ch.vertexOffset;
+    const Font::Index * tri = font.triangles + ch.triangleOffset;
+
+    float minx = 1e10f, miny = 1e10f, maxx = -1e10f, maxy = -1e10f;
+    for(GLsizei i = 0; i < ch.numTriangles; ++i) {
+        const Point & p = v[tri[i]];
+        minx = std::min(minx, p.x); maxx = std::max(maxx, p.x);
+        miny = std::min(miny, p.y); maxy = std::max(maxy, p.y);
+    }
+
+    // a pixel of margin around the glyph, so that linear filtering does not bleed into the neighbours
+    const int gx0 = (int)std::floor(minx * S) - 1, gx1 = (int)std::ceil(maxx * S) + 1;
+    const int gy0 = (int)std::floor(miny * S) - 1, gy1 = (int)std::ceil(maxy * S) + 1;
+    w = gx1 - gx0;
+    h = gy1 - gy0;
+
+    // coverage of the sample grid: a sample is in if it is in any triangle (so shared edges do not count twice)
+    const int sw = w * SS, sh = h * SS;
+    std::vector<unsigned char> mask(sw * sh, 0);
+    for(GLsizei i = 0; i + 2 < ch.numTriangles; i += 3) {
+
+        float ax[3], ay[3];
+        for(int k = 0; k < 3; ++k) {
+            ax[k] = (v[tri[i + k]].x * S - gx0) * SS;
+            ay[k] = (gy1 - v[tri[i + k]].y * S) * SS;
+        }
+        const int sx0 = std::max(0, (int)std::floor(std::min(ax[0], std::min(ax[1], ax[2]))));
+        const int sx1 = std::min(sw - 1, (int)std::ceil(std::max(ax[0], std::max(ax[1], ax[2]))));
+        const int sy0 = std::max(0, (int)std::floor(std::min(ay[0], std::min(ay[1], ay[2]))));
+        const int sy1 = std::min(sh - 1, (int)std::ceil(std::max(ay[0], std::max(ay[1], ay[2]))));
+
+        for(int sy = sy0; sy <= sy1; ++sy)
+            for(int sx = sx0; sx <= sx1; ++sx) {
+                const float px = sx + 0.5f, py = sy + 0.5f;
+                // edge functions; either winding will do
+                const float e0 = (ax[1] - ax[0]) * (py - ay[0]) - (ay[1] - ay[0]) * (px - ax[0]);
+                const float e1 = (ax[2] - ax[1]) * (py - ay[1]) - (ay[2] - ay[1]) * (px - ax[1]);
+                const float e2 = (ax[0] - ax[2]) * (py - ay[2]) - (ay[0] - ay[2]) * (px - ax[2]);
+                if((e0 >= 0 && e1 >= 0 && e2 >= 0) || (e0 <= 0 && e1 <= 0 && e2 <= 0))
+                    mask[sy * sw + sx] = 1;
+            }
+    }
+
+    bitmap.assign(w * h, 0);
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x) {
+            int n = 0;
+            for(int j = 0; j < SS; ++j)
+                for(int i = 0; i < SS; ++i)
+                    n += mask[(y * SS + j) * sw + x * SS + i];
+            bitmap[y * w + x] = (unsigned char)((n * 255) / (SS * SS));
+        }
+
+    glyph.visible = true;
+    glyph.x0 = (float)gx0 / S; glyph.x1 = (float)gx1 / S;
+    glyph.y0 = (float)gy1 / S; glyph.y1 = (float)gy0 / S;   // top, bottom
+}
+
+
+static GlyphAtlas & buildAtlas(const Font * font)
+{
+    GlyphAtlas & atlas = atlases[font];
+    if(atlas.texture != 0)
+        return atlas;
+
+    // rasterize every glyph and place them in rows (shelves) across the atlas
+    std::vector<std::vector<unsigned char> > bitmaps(font->glyphs.size());
+    std::vector<int> ws(font->glyphs.size()), hs(font->glyphs.size()), xs(font->glyphs.size()), ys(font->glyphs.size());
+    int x = 0, y = 0, row_height = 0;
+    for(size_t i = 0; i < font->glyphs.size(); ++i) {
+
+        GlyphAtlas::Glyph & glyph = atlas.glyphs[(unsigned char)font->glyphs[i]];
+        rasterizeGlyph(*font, font->characters[i], glyph, bitmaps[i], ws[i], hs[i]);
+        if(!glyph.visible)
+            continue;
+        if(x + ws[i] > ATLAS_WIDTH) {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+        xs[i] = x;
+        ys[i] = y;
+        x += ws[i];
+        row_height = std::max(row_height, hs[i]);
+    }
+    int height = 1;
+    while(height < y + row_height)
+        height *= 2;
+
+    std::vector<unsigned char> image(ATLAS_WIDTH * height, 0);
+    for(size_t i = 0; i < font->glyphs.size(); ++i) {
+
+        GlyphAtlas::Glyph & glyph = atlas.glyphs[(unsigned char)font->glyphs[i]];
+        if(!glyph.visible)
+            continue;
+        for(int r = 0; r < hs[i]; ++r)
+            std::copy(bitmaps[i].begin() + r * ws[i], bitmaps[i].begin() + (r + 1) * ws[i], image.begin() + (ys[i] + r) * ATLAS_WIDTH + xs[i]);
+        glyph.u0 = (float)xs[i] / ATLAS_WIDTH;
+        glyph.u1 = (float)(xs[i] + ws[i]) / ATLAS_WIDTH;
+        glyph.v0 = (float)ys[i] / height;
+        glyph.v1 = (float)(ys[i] + hs[i]) / height;
+    }
+
+    glGenTextures(1, &atlas.texture);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA8, ATLAS_WIDTH, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &image[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return atlas;
+}
+
+
+// The quads of a string, laid out just as glDrawText does (cached)
+static const GlyphAtlas::Layout & layoutText(GlyphAtlas & atlas, const Font * font, const std::string & text, double spacing, double kerning)
+{
+    map<string, GlyphAtlas::Layout>::iterator it = atlas.cache.find(text);
+    if(it != atlas.cache.end() && it->second.spacing == spacing && it->second.kerning == kerning)
+        return it->second;
+
+    if(atlas.cache.size() >= ATLAS_MAX_CACHED)
+        atlas.cache.clear();
+    GlyphAtlas::Layout & layout = atlas.cache[text];
+    layout.spacing = spacing;
+    layout.kerning = kerning;
+    layout.quads.clear();
+
+    int lines = 0;
+    double max_total = 0;
+    double total = 0;
+    const Font::Char * space = font->findChar(' ');
+    const double tab_width = 8 * ((space)?(space->advance):1);
+    for (size_t i=0; i<text.length(); ++i) {
+        char c = text[i];
+        if (c == '\n') {
+            max_total = std::max(max_total, total);
+            total = 0;
+            ++lines;
+            continue;
+        }
+        if(c == '\t'){
+            total += tab_width - std::fmod(total, tab_width);
+            continue;
+        }
+        const Font::Char * ch = font->findChar(c);
+        if(!ch){
+            c = toupper(c);
+            ch = font->findChar(c);
+            if(!ch) {
+                c = '?';
+                ch = font->findChar(c);
+            }
+        }
+        if(!ch)
+            continue;
+
+        const GlyphAtlas::Glyph & g = atlas.glyphs[(unsigned char)c];
+        if(g.visible) {
+            const float ox = (float)total, oy = (float)(-lines * spacing);
+            const float q[16] = { ox + g.x0, oy + g.y0, g.u0, g.v0,
+                                  ox + g.x1, oy + g.y0, g.u1, g.v0,
+                                  ox + g.x1, oy + g.y1, g.u1, g.v1,
+                                  ox + g.x0, oy + g.y1, g.u0, g.v1 };
+            layout.quads.insert(layout.quads.end(), q, q + 16);
+        }
+        total += ch->advance + kerning;
+    }
+    max_total = std::max(total, max_total);
+    layout.extends = std::make_pair(max_total, (lines+1)*spacing);
+    return layout;
+}
+
+
+static std::pair<double,double> glDrawTextAtlas(const std::string& text, double spacing, double kerning)
+{
+    const Font * font = data.currentFont();
+    GlyphAtlas & atlas = buildAtlas(font);
+    const GlyphAtlas::Layout & layout = layoutText(atlas, font, text, spacing, kerning);
+    if(layout.quads.empty())
+        return layout.extends;
+
+    // the current color, with the glyph coverage as alpha
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), &layout.quads[0]);
+    glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), &layout.quads[2]);
+    glDrawArrays(GL_QUADS, 0, layout.quads.size() / 4);
+
+    glPopClientAttrib();
+    glPopAttrib();
+    return layout.extends;
+}
+
+
+void glBuildTextAtlas()
+{
+    buildAtlas(data.currentFont());
+}
+
+
 std::pair<double,double> glDrawText(const std::string& text, enum TEXT_STYLE style, double spacing, double kerning){
+    if(style == ATLAS)
+        return glDrawTextAtlas(text, spacing, kerning);
+
     glPushMatrix();
     if(style == NICE) {
         glPushAttrib( GL_COLOR_BUFFER_BIT | GL_LINE_BIT );
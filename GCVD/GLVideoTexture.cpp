@@ -0,0 +1,179 @@
+// The buffer object entry points (GL 1.5 / 2.1) come from glext.h
+#define GL_GLEXT_PROTOTYPES
+
+#include <cstring>
+#include <cstdlib>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "GLVideoTexture.h"
+
+namespace GLXInterface
+{
+
+// PBOs need buffer objects (1.5) and GL_PIXEL_UNPACK_BUFFER (2.1, or the ARB extension before that)
+static bool HavePixelBufferObjects()
+{
+	const char* pVersion = (const char*) glGetString(GL_VERSION);
+	if(pVersion != NULL) {
+		int nMajor = atoi(pVersion);
+		const char* pMinor = strchr(pVersion, '.');
+		int nMinor = pMinor == NULL ? 0 : atoi(pMinor + 1);
+		if(nMajor > 2 || (nMajor == 2 && nMinor >= 1))
+			return true;
+	}
+	const char* pExtensions = (const char*) glGetString(GL_EXTENSIONS);
+	return pExtensions != NULL && strstr(pExtensions, "GL_ARB_pixel_buffer_object") != NULL;
+}
+
+
+GLVideoTexture::GLVideoTexture() : mnTexture(0), mnPBO(0), mbHasFrame(false), mirSize(0, 0), mnChannels(0), mnFrameBytes(0)
+{
+}
+
+
+GLVideoTexture::~GLVideoTexture()
+{
+	// The context may be gone by now (window destroyed first); the driver frees everything with it then.
+	// Call Release() explicitly to free the texture while the context is alive.
+}
+
+
+void GLVideoTexture::Release()
+{
+	if(mnPBO != 0)
+		glDeleteBuffers(1, &mnPBO);
+	if(mnTexture != 0)
+		glDeleteTextures(1, &mnTexture);
+
+	mnTexture = 0;
+	mnPBO = 0;
+	mbHasFrame = false;
+	mirSize = cv::Size2i(0, 0);
+	mnChannels = 0;
+	mnFrameBytes = 0;
+}
+
+
+void GLVideoTexture::Create(const cv::Mat &im)
+{
+	Release();
+
+	mirSize = cv::Size2i(im.cols, im.rows);
+	mnChannels = im.channels();
+	mnFrameBytes = (size_t)im.cols * im.rows * mnChannels;
+
+	// Non-power-of-two textures are fine since GL 2.0; no mipmaps, so the texture is complete with level 0 only
+	glGenTextures(1, &mnTexture);
+	glBindTexture(GL_TEXTURE_2D, mnTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, mnChannels == 1 ? GL_LUMINANCE8 : GL_RGB8, im.cols, im.rows, 0,
+		     mnChannels == 1 ? GL_LUMINANCE : GL_BGR, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if(HavePixelBufferObjects()) {
+		glGenBuffers(1, &mnPBO);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mnPBO);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, mnFrameBytes, NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+}
+
+
+bool GLVideoTexture::Upload(const cv::Mat &im)
+{
+	// Nothing that can be shown: rather no picture than the previous frame passing for this one
+	if(im.empty() || im.depth() != CV_8U || (im.channels() != 1 && im.channels() != 3)) {
+		mbHasFrame = false;
+		return false;
+	}
+
+	if(mnTexture == 0 || im.cols != mirSize.width || im.rows != mirSize.height || im.channels() != mnChannels)
+		Create(im);
+
+	const size_t nRowBytes = (size_t)im.cols * mnChannels;
+	GLenum nFormat = mnChannels == 1 ? GL_LUMINANCE : GL_BGR;
+
+	glBindTexture(GL_TEXTURE_2D, mnTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	void* pDst = NULL;
+	if(mnPBO != 0) {
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mnPBO);
+		// Orphan the old storage first: if the GPU still reads from it, the driver hands us fresh memory instead of stalling
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, mnFrameBytes, NULL, GL_STREAM_DRAW);
+		pDst = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	}
+
+	if(pDst != NULL) {
+
+		// tightly packed rows in the PBO (im.step may be padded, or im may be a region of a larger image)
+		if(im.isContinuous())
+			memcpy(pDst, im.data, mnFrameBytes);
+		else
+			for(int r=0; r<im.rows; r++)
+				memcpy((uchar*)pDst + r * nRowBytes, im.ptr<uchar>(r), nRowBytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// with a PBO bound, the "pixels" argument is an offset into it and the call returns without waiting for the copy
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, im.cols, im.rows, nFormat, GL_UNSIGNED_BYTE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else {
+
+		if(mnPBO != 0)
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // mapping failed; go the plain way this time
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, im.step / im.elemSize());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, im.cols, im.rows, nFormat, GL_UNSIGNED_BYTE, im.data);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	mbHasFrame = true;
+	return true;
+}
+
+
+void GLVideoTexture::Draw(double x0, double y0, double x1, double y1) const
+{
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	// No (valid) frame: a black rectangle
+	if(!mbHasFrame) {
+		glDisable(GL_TEXTURE_2D);
+		glColor3f(0, 0, 0);
+		glBegin(GL_QUADS);
+		glVertex2d(x0, y0);
+		glVertex2d(x1, y0);
+		glVertex2d(x1, y1);
+		glVertex2d(x0, y1);
+		glEnd();
+		glPopAttrib();
+		return;
+	}
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, mnTexture);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glColor3f(1, 1, 1);
+
+	// texture row 0 is the top row of the image
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0); glVertex2d(x0, y0);
+	glTexCoord2f(1, 0); glVertex2d(x1, y0);
+	glTexCoord2f(1, 1); glVertex2d(x1, y1);
+	glTexCoord2f(0, 1); glVertex2d(x0, y1);
+	glEnd();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPopAttrib();
+}
+
+}
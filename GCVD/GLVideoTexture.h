@@ -0,0 +1,60 @@
+#ifndef GLVIDEOTEXTURE_H
+#define GLVIDEOTEXTURE_H
+
+#include <core.hpp>
+
+#include <GL/gl.h>
+
+namespace GLXInterface
+{
+	/// Streams video frames into a texture and draws them as a textured quad (instead of glDrawPixels).
+	///
+	/// Frames are copied into a pixel-buffer object (PBO) and the texture is updated from it with glTexSubImage2D,
+	/// which returns immediately and lets the driver do the transfer in the background. The PBO storage is orphaned
+	/// before every frame, so writing the next frame never waits on the transfer of the previous one (the driver hands
+	/// out fresh memory if the old one is still being read). A second PBO would only help if the upload of a frame were
+	/// deferred to the next one, which would draw the video one frame behind the overlays on top of it; the texture
+	/// always shows the frame that was passed last instead (no latency).
+	/// An empty or unsupported frame (anything but 8 bit gray or BGR) clears the picture: Draw() then fills
+	/// the rectangle with black rather than going on showing the previous frame.
+	/// Without PBO support (GL < 2.1) the frame goes to glTexSubImage2D straight from client memory.
+	///
+	/// All calls need the GL context of the window in which the texture is drawn to be current.
+	class GLVideoTexture
+	{
+	public:
+		GLVideoTexture();
+		~GLVideoTexture();
+
+		/// Upload a frame (CV_8UC1 grayscale or CV_8UC3 BGR). (Re)creates the texture and buffer if the size or format changed.
+		/// False (and no picture until the next good frame) if the frame is empty or of another format.
+		bool Upload(const cv::Mat &im);
+
+		/// Is there a picture to draw? (false before the first frame, and after an empty or unsupported one)
+		bool HasFrame() const { return mbHasFrame; }
+
+		/// Draw the last frame uploaded over the rectangle [x0, x1] x [y0, y1] of the current coordinate frame
+		/// (with y0 the top row of the image).
+		void Draw(double x0, double y0, double x1, double y1) const;
+
+		/// Free the texture and the buffer (the next Upload creates them again)
+		void Release();
+
+		cv::Size2i Size() const { return mirSize; }
+
+	private:
+		GLVideoTexture(const GLVideoTexture&);
+		GLVideoTexture& operator=(const GLVideoTexture&);
+
+		void Create(const cv::Mat &im);
+
+		GLuint mnTexture;	// the texture (0 : not created yet)
+		GLuint mnPBO;		// the pixel unpack buffer (0 : no PBO support)
+		bool mbHasFrame;	// the texture holds the last frame passed to Upload
+		cv::Size2i mirSize;	// texture size
+		int mnChannels;		// 1 (luminance) or 3 (BGR)
+		size_t mnFrameBytes;	// bytes of a tightly packed frame
+	};
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "../OpenCV.h"
 
 #include <limits.h>
+#include <type_traits>
 using namespace std;
 using namespace cv;
 
@@ -461,4 +462,462 @@ cv::Mat_<typename MyOperatorOverloads::MultiplyType<PV, PM>::type > operator *(c
 
 
 
+// again back to MyOperatorOverloads, for the lazy versions of the above
+namespace MyOperatorOverloads {
+//////////////////////////////////////////////////////////////////////////////////
+//          Lazy evaluation (expression templates) for fixed-size cv::Vec and cv::Matx 
+//////////////////////////////////////////////////////////////////////////////////
+//
+// The Operator structs above materialize the result of every binary operation, so a chain like a + b - c * k
+// creates a temporary per operator. Wrapping (at least) one operand with lazy() instead builds a tree of expression 
+// nodes whose type encodes the whole chain. Nothing is computed until the expression is assigned to a cv::Vec / cv::Matx
+// (or eval() is called); then the whole chain is evaluated element by element in ONE loop over the compile-time size,
+// which the compiler unrolls and vectorizes. Reading a single element with [] (or (r, c)) computes only that element.
+//
+// BEWARE: The nodes keep references to their operands (which may be temporaries), so an expression must be evaluated 
+// in the statement that builds it. Never keep one in an "auto" variable.
+//
+// Sizes are checked at compile time (static_assert), and the element types follow the same rules as the eager
+// operators (AddType, MultiplyType etc.).
+
+
+// ***************************************** Vector expressions *************************************************
+
+// The CRTP base of every vector expression of size S and element type P.
+// Every node E provides "P elem(int i) const".
+template<class E, typename P, int S> struct VExpr {
+  
+  typedef P value_type;
+  static const int size = S;
+  
+  const E& self() const { return static_cast<const E&>(*this); }
+  
+  P operator[](int i) const { return self().elem(i); }
+  
+  cv::Vec<P, S> eval() const 
+  {
+    cv::Vec<P, S> res;
+    for(int i=0; i<S; i++) res[i] = self().elem(i);
+    return res;
+  }
+  
+  template<typename T> operator cv::Vec<T, S>() const 
+  {
+    cv::Vec<T, S> res;
+    for(int i=0; i<S; i++) res[i] = (T)self().elem(i);
+    return res;
+  }
+};
+
+// A cv::Vec as a leaf of the tree
+template<typename P, int S> struct VExprLeaf : public VExpr<VExprLeaf<P, S>, P, S> {
+  const cv::Vec<P, S> &v;
+  VExprLeaf(const cv::Vec<P, S> &v_in) : v(v_in) {}
+  P elem(int i) const { return v[i]; }
+};
+
+// Elementwise Op (Add, Subtract, Multiply, Divide) between two expressions
+template<typename Op, class L, class R> 
+struct VExprElementwise : public VExpr<VExprElementwise<Op, L, R>, 
+				       typename Op::template Return<typename L::value_type, typename R::value_type>::Type, L::size> {
+  static_assert(L::size == R::size, "lazy vector expression: the operands must have the same size");
+  
+  typedef typename L::value_type P1;
+  typedef typename R::value_type P2;
+  typedef typename Op::template Return<P1, P2>::Type P0;
+  
+  const L left;
+  const R right;
+  VExprElementwise(const L &left_in, const R &right_in) : left(left_in), right(right_in) {}
+  
+  P0 elem(int i) const { return Op::template op<P0, P1, P2>(left.elem(i), right.elem(i)); }
+};
+
+// Expression <Op> scalar
+template<typename Op, class L, typename PS> 
+struct VExprScalar : public VExpr<VExprScalar<Op, L, PS>, typename Op::template Return<typename L::value_type, PS>::Type, L::size> {
+  
+  typedef typename L::value_type P1;
+  typedef typename Op::template Return<P1, PS>::Type P0;
+  
+  const L left;
+  const PS s;
+  VExprScalar(const L &left_in, const PS &s_in) : left(left_in), s(s_in) {}
+  
+  P0 elem(int i) const { return Op::template op<P0, P1, PS>(left.elem(i), s); }
+};
+
+// scalar <Op> expression
+template<typename Op, typename PS, class R> 
+struct VExprScalarLeft : public VExpr<VExprScalarLeft<Op, PS, R>, typename Op::template Return<PS, typename R::value_type>::Type, R::size> {
+  
+  typedef typename R::value_type P2;
+  typedef typename Op::template Return<PS, P2>::Type P0;
+  
+  const PS s;
+  const R right;
+  VExprScalarLeft(const PS &s_in, const R &right_in) : s(s_in), right(right_in) {}
+  
+  P0 elem(int i) const { return Op::template op<P0, PS, P2>(s, right.elem(i)); }
+};
+
+// -expression
+template<class L> struct VExprNegate : public VExpr<VExprNegate<L>, typename L::value_type, L::size> {
+  const L left;
+  VExprNegate(const L &left_in) : left(left_in) {}
+  typename L::value_type elem(int i) const { return -left.elem(i); }
+};
+
+
+// ***************************************** Matrix expressions *************************************************
+
+// The CRTP base of every M x N matrix expression with element type P.
+// Every node E provides "P elem(int r, int c) const".
+template<class E, typename P, int M, int N> struct MExpr {
+  
+  typedef P value_type;
+  static const int rows = M;
+  static const int cols = N;
+  
+  const E& self() const { return static_cast<const E&>(*this); }
+  
+  P operator()(int r, int c) const { return self().elem(r, c); }
+  
+  cv::Matx<P, M, N> eval() const 
+  {
+    cv::Matx<P, M, N> res;
+    for(int r=0; r<M; r++) 
+      for(int c=0; c<N; c++) res(r, c) = self().elem(r, c);
+    return res;
+  }
+  
+  template<typename T> operator cv::Matx<T, M, N>() const 
+  {
+    cv::Matx<T, M, N> res;
+    for(int r=0; r<M; r++) 
+      for(int c=0; c<N; c++) res(r, c) = (T)self().elem(r, c);
+    return res;
+  }
+};
+
+// A cv::Matx as a leaf of the tree
+template<typename P, int M, int N> struct MExprLeaf : public MExpr<MExprLeaf<P, M, N>, P, M, N> {
+  const cv::Matx<P, M, N> &m;
+  MExprLeaf(const cv::Matx<P, M, N> &m_in) : m(m_in) {}
+  P elem(int r, int c) const { return m(r, c); }
+};
+
+// Elementwise Op between two matrix expressions
+template<typename Op, class L, class R> 
+struct MExprElementwise : public MExpr<MExprElementwise<Op, L, R>, 
+				       typename Op::template Return<typename L::value_type, typename R::value_type>::Type, L::rows, L::cols> {
+  static_assert(L::rows == R::rows && L::cols == R::cols, "lazy matrix expression: the operands must have the same size");
+  
+  typedef typename L::value_type P1;
+  typedef typename R::value_type P2;
+  typedef typename Op::template Return<P1, P2>::Type P0;
+  
+  const L left;
+  const R right;
+  MExprElementwise(const L &left_in, const R &right_in) : left(left_in), right(right_in) {}
+  
+  P0 elem(int r, int c) const { return Op::template op<P0, P1, P2>(left.elem(r, c), right.elem(r, c)); }
+};
+
+// Matrix expression <Op> scalar
+template<typename Op, class L, typename PS> 
+struct MExprScalar : public MExpr<MExprScalar<Op, L, PS>, typename Op::template Return<typename L::value_type, PS>::Type, L::rows, L::cols> {
+  
+  typedef typename L::value_type P1;
+  typedef typename Op::template Return<P1, PS>::Type P0;
+  
+  const L left;
+  const PS s;
+  MExprScalar(const L &left_in, const PS &s_in) : left(left_in), s(s_in) {}
+  
+  P0 elem(int r, int c) const { return Op::template op<P0, P1, PS>(left.elem(r, c), s); }
+};
+
+// scalar <Op> matrix expression
+template<typename Op, typename PS, class R> 
+struct MExprScalarLeft : public MExpr<MExprScalarLeft<Op, PS, R>, typename Op::template Return<PS, typename R::value_type>::Type, R::rows, R::cols> {
+  
+  typedef typename R::value_type P2;
+  typedef typename Op::template Return<PS, P2>::Type P0;
+  
+  const PS s;
+  const R right;
+  MExprScalarLeft(const PS &s_in, const R &right_in) : s(s_in), right(right_in) {}
+  
+  P0 elem(int r, int c) const { return Op::template op<P0, PS, P2>(s, right.elem(r, c)); }
+};
+
+// -matrix expression
+template<class L> struct MExprNegate : public MExpr<MExprNegate<L>, typename L::value_type, L::rows, L::cols> {
+  const L left;
+  MExprNegate(const L &left_in) : left(left_in) {}
+  typename L::value_type elem(int r, int c) const { return -left.elem(r, c); }
+};
+
+// The transpose of a matrix expression (just swaps the indexes)
+template<class L> struct MExprTranspose : public MExpr<MExprTranspose<L>, typename L::value_type, L::cols, L::rows> {
+  const L left;
+  MExprTranspose(const L &left_in) : left(left_in) {}
+  typename L::value_type elem(int r, int c) const { return left.elem(c, r); }
+};
+
+// What a product keeps of its operands: Every element of an operand is read several times by a product, 
+// so anything other than a leaf (or a transposed leaf) is evaluated once into a fixed size matrix (on the stack)
+// and wrapped in a leaf. Otherwise, a chain like A * B * C would recompute the elements of A * B for every column of C.
+template<class E> struct MProductOperand {
+  typedef cv::Matx<typename E::value_type, E::rows, E::cols> Storage;
+  typedef MExprLeaf<typename E::value_type, E::rows, E::cols> Type;
+  static Storage store(const E &e) { return e.eval(); }
+};
+template<typename P, int M, int N> struct MProductOperand<MExprLeaf<P, M, N> > {
+  typedef MExprLeaf<P, M, N> Storage;
+  typedef MExprLeaf<P, M, N> Type;
+  static Storage store(const MExprLeaf<P, M, N> &e) { return e; }
+};
+template<typename P, int M, int N> struct MProductOperand<MExprTranspose<MExprLeaf<P, M, N> > > {
+  typedef MExprTranspose<MExprLeaf<P, M, N> > Storage;
+  typedef MExprTranspose<MExprLeaf<P, M, N> > Type;
+  static Storage store(const MExprTranspose<MExprLeaf<P, M, N> > &e) { return e; }
+};
+
+// (M x K) * (K x N) matrix product; each element is a K-term dot product
+template<class L, class R> 
+struct MExprProduct : public MExpr<MExprProduct<L, R>, 
+				   typename MultiplyType<typename L::value_type, typename R::value_type>::type, L::rows, R::cols> {
+  static_assert(L::cols == R::rows, "lazy matrix product: the inner dimensions must agree");
+  
+  typedef typename MultiplyType<typename L::value_type, typename R::value_type>::type P0;
+  static const int K = L::cols;
+  
+  // the operands are stored first (see MProductOperand) and then accessed through leaves (or transposed leaves)
+  const typename MProductOperand<L>::Storage leftStore;
+  const typename MProductOperand<R>::Storage rightStore;
+  const typename MProductOperand<L>::Type left;
+  const typename MProductOperand<R>::Type right;
+  
+  MExprProduct(const L &left_in, const R &right_in) : leftStore(MProductOperand<L>::store(left_in)), 
+						      rightStore(MProductOperand<R>::store(right_in)),
+						      left(leftStore), right(rightStore) {}
+  MExprProduct(const MExprProduct &o) : leftStore(o.leftStore), rightStore(o.rightStore), left(leftStore), right(rightStore) {}
+  
+  P0 elem(int r, int c) const 
+  {
+    P0 sum = 0;
+    for(int k=0; k<K; k++) sum += left.elem(r, k) * right.elem(k, c);
+    return sum;
+  }
+};
+
+// Matrix expression * vector expression is a vector expression
+template<class L, class R> 
+struct MVExprProduct : public VExpr<MVExprProduct<L, R>, 
+				    typename MultiplyType<typename L::value_type, typename R::value_type>::type, L::rows> {
+  static_assert(L::cols == R::size, "lazy matrix-vector product: the matrix columns must agree with the vector size");
+  
+  typedef typename MultiplyType<typename L::value_type, typename R::value_type>::type P0;
+  
+  const typename MProductOperand<L>::Storage leftStore;
+  const cv::Vec<typename R::value_type, R::size> right; // the vector is read once per row, so it is always evaluated
+  const typename MProductOperand<L>::Type left;
+  
+  MVExprProduct(const L &left_in, const R &right_in) : leftStore(MProductOperand<L>::store(left_in)), right(right_in.eval()), left(leftStore) {}
+  MVExprProduct(const MVExprProduct &o) : leftStore(o.leftStore), right(o.right), left(leftStore) {}
+  
+  P0 elem(int i) const 
+  {
+    P0 sum = 0;
+    for(int k=0; k<L::cols; k++) sum += left.elem(i, k) * right[k];
+    return sum;
+  }
+};
+
+} // ****************** close MyOperatorOverloads for operator overloads to follow... ******************************
+
+
+// The entry points: lazy(v) / lazy(M) turns a cv::Vec / cv::Matx into a leaf of an expression
+template<typename P, int S> 
+inline MyOperatorOverloads::VExprLeaf<P, S> lazy(const cv::Vec<P, S> &v) { return MyOperatorOverloads::VExprLeaf<P, S>(v); }
+
+template<typename P, int M, int N> 
+inline MyOperatorOverloads::MExprLeaf<P, M, N> lazy(const cv::Matx<P, M, N> &m) { return MyOperatorOverloads::MExprLeaf<P, M, N>(m); }
+
+
+// Vector expression +/- vector expression (and a plain cv::Vec on either side)
+// addition
+template<class E1, typename P1, int S1, class E2, typename P2, int S2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, E1, E2>
+operator +(const MyOperatorOverloads::VExpr<E1, P1, S1> &e1, const MyOperatorOverloads::VExpr<E2, P2, S2> &e2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, E1, E2>(e1.self(), e2.self());
+}
+template<class E1, typename P1, int S, typename P2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, E1, MyOperatorOverloads::VExprLeaf<P2, S> >
+operator +(const MyOperatorOverloads::VExpr<E1, P1, S> &e1, const cv::Vec<P2, S> &v2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, E1, MyOperatorOverloads::VExprLeaf<P2, S> >(e1.self(), lazy(v2));
+}
+template<typename P1, int S, class E2, typename P2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, MyOperatorOverloads::VExprLeaf<P1, S>, E2>
+operator +(const cv::Vec<P1, S> &v1, const MyOperatorOverloads::VExpr<E2, P2, S> &e2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Add, MyOperatorOverloads::VExprLeaf<P1, S>, E2>(lazy(v1), e2.self());
+}
+
+// subtraction
+template<class E1, typename P1, int S1, class E2, typename P2, int S2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, E1, E2>
+operator -(const MyOperatorOverloads::VExpr<E1, P1, S1> &e1, const MyOperatorOverloads::VExpr<E2, P2, S2> &e2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, E1, E2>(e1.self(), e2.self());
+}
+template<class E1, typename P1, int S, typename P2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, E1, MyOperatorOverloads::VExprLeaf<P2, S> >
+operator -(const MyOperatorOverloads::VExpr<E1, P1, S> &e1, const cv::Vec<P2, S> &v2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, E1, MyOperatorOverloads::VExprLeaf<P2, S> >(e1.self(), lazy(v2));
+}
+template<typename P1, int S, class E2, typename P2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, MyOperatorOverloads::VExprLeaf<P1, S>, E2>
+operator -(const cv::Vec<P1, S> &v1, const MyOperatorOverloads::VExpr<E2, P2, S> &e2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Subtract, MyOperatorOverloads::VExprLeaf<P1, S>, E2>(lazy(v1), e2.self());
+}
+
+// elementwise product of vector expressions (like diagmult)
+template<class E1, typename P1, int S1, class E2, typename P2, int S2>
+inline MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Multiply, E1, E2> 
+diagmult(const MyOperatorOverloads::VExpr<E1, P1, S1> &e1, const MyOperatorOverloads::VExpr<E2, P2, S2> &e2) {
+  return MyOperatorOverloads::VExprElementwise<MyOperatorOverloads::Multiply, E1, E2>(e1.self(), e2.self());
+}
+
+// Vector expression * scalar, scalar * vector expression and vector expression / scalar
+template<class E, typename P, int S, typename PS>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::VExprScalar<MyOperatorOverloads::Multiply, E, PS> >::type 
+operator *(const MyOperatorOverloads::VExpr<E, P, S> &e, const PS &s) {
+  return MyOperatorOverloads::VExprScalar<MyOperatorOverloads::Multiply, E, PS>(e.self(), s);
+}
+
+template<typename PS, class E, typename P, int S>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::VExprScalarLeft<MyOperatorOverloads::Multiply, PS, E> >::type 
+operator *(const PS &s, const MyOperatorOverloads::VExpr<E, P, S> &e) {
+  return MyOperatorOverloads::VExprScalarLeft<MyOperatorOverloads::Multiply, PS, E>(s, e.self());
+}
+
+template<class E, typename P, int S, typename PS>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::VExprScalar<MyOperatorOverloads::Divide, E, PS> >::type 
+operator /(const MyOperatorOverloads::VExpr<E, P, S> &e, const PS &s) {
+  return MyOperatorOverloads::VExprScalar<MyOperatorOverloads::Divide, E, PS>(e.self(), s);
+}
+
+template<class E, typename P, int S>
+inline MyOperatorOverloads::VExprNegate<E> operator -(const MyOperatorOverloads::VExpr<E, P, S> &e) {
+  return MyOperatorOverloads::VExprNegate<E>(e.self());
+}
+
+
+// Matrix expression +/- matrix expression (and a plain cv::Matx on either side)
+// addition
+template<class E1, typename P1, int M1, int N1, class E2, typename P2, int M2, int N2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, E1, E2>
+operator +(const MyOperatorOverloads::MExpr<E1, P1, M1, N1> &e1, const MyOperatorOverloads::MExpr<E2, P2, M2, N2> &e2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, E1, E2>(e1.self(), e2.self());
+}
+template<class E1, typename P1, int M, int N, typename P2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, E1, MyOperatorOverloads::MExprLeaf<P2, M, N> >
+operator +(const MyOperatorOverloads::MExpr<E1, P1, M, N> &e1, const cv::Matx<P2, M, N> &m2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, E1, MyOperatorOverloads::MExprLeaf<P2, M, N> >(e1.self(), lazy(m2));
+}
+template<typename P1, int M, int N, class E2, typename P2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, MyOperatorOverloads::MExprLeaf<P1, M, N>, E2>
+operator +(const cv::Matx<P1, M, N> &m1, const MyOperatorOverloads::MExpr<E2, P2, M, N> &e2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Add, MyOperatorOverloads::MExprLeaf<P1, M, N>, E2>(lazy(m1), e2.self());
+}
+
+// subtraction
+template<class E1, typename P1, int M1, int N1, class E2, typename P2, int M2, int N2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, E1, E2>
+operator -(const MyOperatorOverloads::MExpr<E1, P1, M1, N1> &e1, const MyOperatorOverloads::MExpr<E2, P2, M2, N2> &e2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, E1, E2>(e1.self(), e2.self());
+}
+template<class E1, typename P1, int M, int N, typename P2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, E1, MyOperatorOverloads::MExprLeaf<P2, M, N> >
+operator -(const MyOperatorOverloads::MExpr<E1, P1, M, N> &e1, const cv::Matx<P2, M, N> &m2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, E1, MyOperatorOverloads::MExprLeaf<P2, M, N> >(e1.self(), lazy(m2));
+}
+template<typename P1, int M, int N, class E2, typename P2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, MyOperatorOverloads::MExprLeaf<P1, M, N>, E2>
+operator -(const cv::Matx<P1, M, N> &m1, const MyOperatorOverloads::MExpr<E2, P2, M, N> &e2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Subtract, MyOperatorOverloads::MExprLeaf<P1, M, N>, E2>(lazy(m1), e2.self());
+}
+
+// mmult for matrix expressions (elementwise)
+template<class E1, typename P1, int M1, int N1, class E2, typename P2, int M2, int N2>
+inline MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Multiply, E1, E2>
+mmult(const MyOperatorOverloads::MExpr<E1, P1, M1, N1> &e1, const MyOperatorOverloads::MExpr<E2, P2, M2, N2> &e2) {
+  return MyOperatorOverloads::MExprElementwise<MyOperatorOverloads::Multiply, E1, E2>(e1.self(), e2.self());
+}
+
+// Matrix expression * scalar, scalar * matrix expression, matrix expression / scalar
+template<class E, typename P, int M, int N, typename PS>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::MExprScalar<MyOperatorOverloads::Multiply, E, PS> >::type 
+operator *(const MyOperatorOverloads::MExpr<E, P, M, N> &e, const PS &s) {
+  return MyOperatorOverloads::MExprScalar<MyOperatorOverloads::Multiply, E, PS>(e.self(), s);
+}
+
+template<typename PS, class E, typename P, int M, int N>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::MExprScalarLeft<MyOperatorOverloads::Multiply, PS, E> >::type 
+operator *(const PS &s, const MyOperatorOverloads::MExpr<E, P, M, N> &e) {
+  return MyOperatorOverloads::MExprScalarLeft<MyOperatorOverloads::Multiply, PS, E>(s, e.self());
+}
+
+template<class E, typename P, int M, int N, typename PS>
+inline typename std::enable_if<std::is_arithmetic<PS>::value, MyOperatorOverloads::MExprScalar<MyOperatorOverloads::Divide, E, PS> >::type 
+operator /(const MyOperatorOverloads::MExpr<E, P, M, N> &e, const PS &s) {
+  return MyOperatorOverloads::MExprScalar<MyOperatorOverloads::Divide, E, PS>(e.self(), s);
+}
+
+template<class E, typename P, int M, int N>
+inline MyOperatorOverloads::MExprNegate<E> operator -(const MyOperatorOverloads::MExpr<E, P, M, N> &e) {
+  return MyOperatorOverloads::MExprNegate<E>(e.self());
+}
+
+// the transpose
+template<class E, typename P, int M, int N>
+inline MyOperatorOverloads::MExprTranspose<E> transpose(const MyOperatorOverloads::MExpr<E, P, M, N> &e) {
+  return MyOperatorOverloads::MExprTranspose<E>(e.self());
+}
+
+// Matrix products (matrix expression or a plain cv::Matx on either side)
+template<class E1, typename P1, int M1, int N1, class E2, typename P2, int M2, int N2>
+inline MyOperatorOverloads::MExprProduct<E1, E2> 
+operator *(const MyOperatorOverloads::MExpr<E1, P1, M1, N1> &e1, const MyOperatorOverloads::MExpr<E2, P2, M2, N2> &e2) {
+  return MyOperatorOverloads::MExprProduct<E1, E2>(e1.self(), e2.self());
+}
+
+template<class E1, typename P1, int M, int K, typename P2, int N>
+inline MyOperatorOverloads::MExprProduct<E1, MyOperatorOverloads::MExprLeaf<P2, K, N> > 
+operator *(const MyOperatorOverloads::MExpr<E1, P1, M, K> &e1, const cv::Matx<P2, K, N> &m2) {
+  return MyOperatorOverloads::MExprProduct<E1, MyOperatorOverloads::MExprLeaf<P2, K, N> >(e1.self(), lazy(m2));
+}
+
+template<typename P1, int M, int K, class E2, typename P2, int N>
+inline MyOperatorOverloads::MExprProduct<MyOperatorOverloads::MExprLeaf<P1, M, K>, E2> 
+operator *(const cv::Matx<P1, M, K> &m1, const MyOperatorOverloads::MExpr<E2, P2, K, N> &e2) {
+  return MyOperatorOverloads::MExprProduct<MyOperatorOverloads::MExprLeaf<P1, M, K>, E2>(lazy(m1), e2.self());
+}
+
+// Matrix expression * vector expression (or a plain cv::Vec)
+template<class E1, typename P1, int M, int N, class E2, typename P2, int S>
+inline MyOperatorOverloads::MVExprProduct<E1, E2> 
+operator *(const MyOperatorOverloads::MExpr<E1, P1, M, N> &e1, const MyOperatorOverloads::VExpr<E2, P2, S> &e2) {
+  return MyOperatorOverloads::MVExprProduct<E1, E2>(e1.self(), e2.self());
+}
+
+template<class E1, typename P1, int M, int N, typename P2>
+inline MyOperatorOverloads::MVExprProduct<E1, MyOperatorOverloads::VExprLeaf<P2, N> > 
+operator *(const MyOperatorOverloads::MExpr<E1, P1, M, N> &e1, const cv::Vec<P2, N> &v2) {
+  return MyOperatorOverloads::MVExprProduct<E1, MyOperatorOverloads::VExprLeaf<P2, N> >(e1.self(), lazy(v2));
+}
+
+
+
 #endif
\ No newline at end of file
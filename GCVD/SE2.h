@@ -63,23 +63,13 @@ public:
 	const cv::Vec<Precision, 2>& get_translation() const {return t_;}
 
 	// this is the homogeneous tranformation 3x3 matrix correspondiong to the SE2
-	cv::Mat_<Precision> get_matrix() {
+	cv::Matx<Precision, 3, 3> get_matrix() const {
 	 
-	  cv::Mat_<Precision> mat(3, 3);
+	  cv::Matx<Precision, 3, 3> mat;
 	  mat(0, 0) = R_.get_matrix()(0,0); mat(0, 1) = R_.get_matrix()(0,1);
-	  mat(0, 1) = R_.get_matrix()(0,1); mat(1, 1) = R_.get_matrix()(1,1);
-	  mat(2, 0) = 0 = mat(2, 1) = 0; mat(2, 2) = 1;
-	  mat(0, 2) = get_translation()[0]; mat(0, 2) = get_translation()[1];
-	  
-	  return mat;
-	}
-	const cv::Mat_<Precision> get_matrix() const {
-	 
-	  cv::Mat_<Precision> mat(3, 3);
-	  mat(0, 0) = R_.get_matrix()(0,0); mat(0, 1) = R_.get_matrix()(0,1);
-	  mat(0, 1) = R_.get_matrix()(0,1); mat(1, 1) = R_.get_matrix()(1,1);
-	  mat(2, 0) = 0 = mat(2, 1) = 0; mat(2, 2) = 1;
-	  mat(0, 2) = get_translation()[0]; mat(0, 2) = get_translation()[1];
+	  mat(1, 0) = R_.get_matrix()(1,0); mat(1, 1) = R_.get_matrix()(1,1);
+	  mat(2, 0) = 0; mat(2, 1) = 0; mat(2, 2) = 1;
+	  mat(0, 2) = get_translation()[0]; mat(1, 2) = get_translation()[1];
 	  
 	  return mat;
 	}
@@ -99,9 +89,9 @@ public:
 	/// compute the inverse of the transformation
 	SE2 inverse() const {
 		
-	  const SO2<Precision> &rinv = R_.inverse();
+	  const SO2<Precision> rinv = R_.inverse();
 	  
-	  return SE2(rinv, -(rinv.get_matrix()*t_));
+	  return SE2(rinv, -(rinv * t_));
 	};
 
 	/// Right-multiply by another SE2 (concatenate the two transformations)
@@ -110,7 +100,7 @@ public:
 		
 	  typedef typename MyOperatorOverloads::MultiplyType<Precision,P>::type P0;
 	  
-	  return SE2<P0>(R_*right.get_rotation(), t_ + R_.get_matrix()*right.get_translation()); 
+	  return SE2<P0>(R_*right.get_rotation(), t_ + R_ * right.get_translation()); 
 	}
 
 	/// Self right-multiply by another SE2 (concatenate the two transformations)
@@ -127,9 +117,9 @@ public:
 	/// - 0 is translation in x
 	/// - 1 is translation in y
 	/// - 2 is rotation in the plane
-	static inline cv::Mat_<Precision> generator(int i) {
+	static inline cv::Matx<Precision, 3, 3> generator(int i) {
 		
-	  cv::Mat_<Precision> result = cv::Mat_<Precision>::zeros(3,3);
+	  cv::Matx<Precision, 3, 3> result = cv::Matx<Precision, 3, 3>::zeros();
 	  if(i < 2){
 	    result(i, 2) = 1;
 	    return result;
@@ -155,8 +145,8 @@ public:
 	  return result;
 	}
 	
-	cv::Mat_<Precision> adjoint(const cv::Mat_<Precision> &M) const {
-		cv::Mat_<Precision> result(3, 3);
+	cv::Matx<Precision, 3, 3> adjoint(const cv::Matx<Precision, 3, 3> &M) const {
+		cv::Matx<Precision, 3, 3> result;
 		cv::Vec<Precision, 3> adj;
 		for(int i=0; i<3; ++i) {
 		  //result.T()[i] = adjoint(M.T()[i]); 
@@ -205,8 +195,11 @@ template <class Precision>
 inline std::istream& operator >>(std::istream& is, RigidTransforms::SE2<Precision> &se2){
 	//for(int i=0; i<2; i++)
 	//	is >> se2.get_rotation().mat_ >> rhs.get_translation()[i];
-	// Ok, i am simply relaying the input operator to the Opencv overloads... It should probably work...
-	is >> se2.get_rotation().get_matrix() >> se2.get_translation();
+	// the rotation (row by row), then the translation
+	for(int i=0; i<2; i++)
+	  for(int j=0; j<2; j++)
+	    is >> se2.get_rotation().get_matrix()(i, j);
+	is >> se2.get_translation()[0] >> se2.get_translation()[1];
 	se2.get_rotation().coerce();
 	
 	return is;
@@ -273,14 +266,14 @@ struct Operator<MyOperatorOverloads::VSE2Mult<PV,P> > {
 	     
 	     cv::Vec<P0, 3> res; 
 	     
-	     cv::Mat_<P> R = se2.get_rotation.get_matrix();
-	     cv::Vec<P, 2> t = se2.get_translation();
+	     const cv::Matx<P, 2, 2> &R = se2.get_rotation().get_matrix();
+	     const cv::Vec<P, 2> &t = se2.get_translation();
 	     
 	     res[0] = R(0,0) * v[0] + R(1,0) * v[1]; 
 	     res[1] = R(0,1) * v[0] + R(1,1) * v[1]; 
 	      
 	     
-	     res[2] = t*v + v[2];
+	     res[2] = t[0] * v[0] + t[1] * v[1] + v[2];
 	     
 	     
 	     return res;
@@ -306,11 +299,11 @@ template <typename P, typename PV>
 inline cv::Vec<typename MyOperatorOverloads::MultiplyType<P,PV>::type, 2> operator *(const RigidTransforms::SE2<P> &se2, const cv::Vec<PV, 2> &v) {
 	
   
-  cv::Vec3f v3(v[0], v[1],1); // turning it to a homogeneous vector
+  cv::Vec<PV, 3> v3(v[0], v[1],1); // turning it to a homogeneous vector
  
   typedef typename MyOperatorOverloads::MultiplyType<PV, P>::type P0;
   
-  cv::Vec<P0, 2> result = se2 * v3;
+  cv::Vec<P0, 3> result = se2 * v3;
   
   return cv::Vec<P0, 2>( result[0], 
 			 result[1] );
@@ -347,7 +340,7 @@ namespace MyOperatorOverloads {
 
 template<typename P, typename PM>
 struct Operator<SE2MMult<P, PM> > {
-	const SE2<P> &se2;
+	const RigidTransforms::SE2<P> &se2;
 	const cv::Mat_<PM> &M;
 	
 	Operator(const RigidTransforms::SE2<P> &se2_in, const cv::Mat_<PM> &M_in ) : se2(se2_in), M(M_in) {}
@@ -357,7 +350,7 @@ struct Operator<SE2MMult<P, PM> > {
 	
 	cv::Mat_<P0> compute() const {
 		
-	  return se2.get_matrix() * M;
+	  return cv::Mat_<P>(se2.get_matrix()) * M;
 	}
 	
 };
@@ -393,7 +386,7 @@ struct Operator<MSE2Mult<PM, P> > {
 	
 	cv::Mat_<P0> compute() const {
 		
-	  return M * se2.get_matrix();
+	  return M * cv::Mat_<P>(se2.get_matrix());
 	}
 	
 };
@@ -404,7 +397,7 @@ struct Operator<MSE2Mult<PM, P> > {
 template <typename PM, typename P> 
 inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<PM,P>::type> operator *(const cv::Mat_<PM> &M, const RigidTransforms::SE2<P> &se2 ) {
 	
-  return MyOperatorOverloads::Operator<MyOperatorOverloads::MSE2Mult<PM, P> >(M, se2);
+  return MyOperatorOverloads::Operator<MyOperatorOverloads::MSE2Mult<PM, P> >(M, se2).compute();
 }
 
 
@@ -468,8 +461,8 @@ inline cv::Vec<Precision, 3> RigidTransforms::SE2<Precision>::ln(const RigidTran
 	const SO2<Precision> halfrotator(theta * -0.5);
 	cv::Vec<Precision, 3> result;
 	//result.template slice<0,2>() = (halfrotator * se2.get_translation())/(2 * shtot);
-	cv::Mat_<Precision> R = halfrotator.get_matrix();
-	cv::Vec<Precision, 2> t = se2.get_translation();
+	const cv::Matx<Precision, 2, 2> &R = halfrotator.get_matrix();
+	const cv::Vec<Precision, 2> &t = se2.get_translation();
 	result[0] = ( R(0,0) * t[0] + 
 		      R(0,1) * t[1]  ) / (2 * shtot);
 	result[1] = ( R(1,0) * t[0] + 
@@ -484,7 +477,7 @@ inline cv::Vec<Precision, 3> RigidTransforms::SE2<Precision>::ln(const RigidTran
 template <typename Precision>
 inline RigidTransforms::SE2<Precision> operator *(const RigidTransforms::SO2<Precision> &so2, const RigidTransforms::SE2<Precision> &se2){
 	
-  return RigidTransforms::SE2<Precision>( so2*se2.get_rotation(), so2.get_matrix()*se2.get_translation() );
+  return RigidTransforms::SE2<Precision>( so2*se2.get_rotation(), so2*se2.get_translation() );
 }
 
 
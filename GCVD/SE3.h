@@ -25,6 +25,9 @@ namespace RigidTransforms {
 /// six numbers (in the space of the Lie Algebra). In this class, the first three parameters are a
 /// translation vector while the second three are a rotation vector, whose direction is the axis of rotation
 /// and length the amount of rotation (in radians), as for SO3
+///
+/// Like SO3, the storage is fixed-size (a cv::Matx and a cv::Vec), so exponentials, compositions and 
+/// point transformations work on the stack. For many points at once, use transform().
 template <typename Precision = float>
 class SE3 {
   
@@ -32,6 +35,9 @@ private:
 	SO3<Precision> R_;
 	cv::Vec<Precision, 3> t_;
   
+	/// The 6x6 matrices of adjoint(v) and trinvadjoint(v) (i.e., adjoint(v) = adjoint_matrix() * v)
+	inline cv::Matx<Precision, 6, 6> adjoint_matrix(bool bTransposedInverse) const;
+  
   
 public:
 	/// Default constructor. Initialises the the rotation to zero (the identity) and the translation to zero
@@ -102,8 +108,8 @@ public:
 		return *this;
 	}
 
-	static inline cv::Mat_<Precision> generator(int i) {
-		cv::Mat_<Precision> result = cv::Mat_<Precision>::zeros(4, 4);
+	static inline cv::Matx<Precision, 4, 4> generator(int i) {
+		cv::Matx<Precision, 4, 4> result = cv::Matx<Precision, 4, 4>::zeros();
 		if(i < 3){
 		  
 		  result(i, 3)=1;
@@ -148,11 +154,21 @@ public:
 	
 	///@overload
 	template <typename P2>
-	inline cv::Mat_<Precision> adjoint(const cv::Mat_<P2> &M) const; // 6x6 matrix
+	inline cv::Matx<Precision, 6, 6> adjoint(const cv::Matx<P2, 6, 6> &M) const;
 
 	///@overload
 	template <typename P2>
-	inline cv::Mat_<Precision> trinvadjoint(const cv::Mat_<P2> &M) const; // 6x6 matrix
+	inline cv::Matx<Precision, 6, 6> trinvadjoint(const cv::Matx<P2, 6, 6> &M) const;
+	
+	/// Transform n points at once: out[i] = R * points[i] + t. 
+	/// The rotation and translation are loaded once for the whole batch (out may be the same array as points).
+	template<typename PV, typename PO>
+	inline void transform(const cv::Vec<PV, 3>* points, cv::Vec<PO, 3>* out, int n) const;
+	
+	/// @overload
+	/// The same on separate coordinate arrays (structure of arrays); this is the one the compiler can vectorize.
+	template<typename PV, typename PO>
+	inline void transform(const PV* x, const PV* y, const PV* z, PO* xo, PO* yo, PO* zo, int n) const;
 
 }; // *************** Class SE3 Ends Here - Class SE3 Ends Here - Class SE3 Ends Here ******************
 
@@ -213,73 +229,51 @@ inline cv::Vec<Precision, 6> RigidTransforms::SE3<Precision>::trinvadjoint(const
 }
 
 
+// The adjoint of a vector is A * v with
+//
+//      [ R   t^R ]
+//  A = [         ]      (see adjoint(v) above), and the transposed inverse is A^-T = [ R 0 ; t^R R ]
+//      [ 0    R  ]
+//
+template<typename Precision>
+inline cv::Matx<Precision, 6, 6> RigidTransforms::SE3<Precision>::adjoint_matrix(bool bTransposedInverse) const {
+	
+	const cv::Matx<Precision, 3, 3> &R = R_.get_matrix();
+	const cv::Matx<Precision, 3, 3> tx(0, -t_[2], t_[1],
+					   t_[2], 0, -t_[0],
+					   -t_[1], t_[0], 0);
+	const cv::Matx<Precision, 3, 3> txR = tx * R;
+	
+	cv::Matx<Precision, 6, 6> A = cv::Matx<Precision, 6, 6>::zeros();
+	for(int i=0; i<3; i++)
+	  for(int j=0; j<3; j++) {
+	    A(i, j) = A(i + 3, j + 3) = R(i, j);
+	    if(bTransposedInverse) A(i + 3, j) = txR(i, j);
+	    else A(i, j + 3) = txR(i, j);
+	  }
+	
+	return A;
+}
+
+// The adjoint of a matrix is the adjoint of its columns, and then of its rows, i.e. A * M * A'.
+// The whole product chain is one lazy expression (see Operators.h), evaluated straight into the result.
 template<typename Precision>
 template<typename P2> 
-inline cv::Mat_<Precision> RigidTransforms::SE3<Precision>::adjoint(const cv::Mat_<P2> &M) const { // NOTE: 6x6 matrix argument here...
-	
-	cv::Mat_<Precision> result(6, 6);
-	
-	for(int i=0; i<6; i++){
-	  //result.T()[i] = adjoint(M.T()[i]);
-	  cv::Vec<P2, 6> adj = adjoint( cv::Vec<P2, 6>( M(0, i), 
-							M(1, i), 
-							M(2, i), 
-							M(3, i), 
-							M(4, i), 
-							M(5, i)) );
-	  result(0, i) = adj[0]; result(1, i) = adj[1]; result(2, i) = adj[2];
-	  result(3, i) = adj[3]; result(4, i) = adj[4]; result(5, i) = adj[5];
-	}
+inline cv::Matx<Precision, 6, 6> RigidTransforms::SE3<Precision>::adjoint(const cv::Matx<P2, 6, 6> &M) const {
 	
-	for(int i=0; i<6; i++) {
-	  //result[i] = adjoint(result[i]);
-	  cv::Vec<P2, 6> adj = adjoint( cv::Vec<P2, 6>(result(i, 0), 
-						       result(i, 1), 
-						       result(i, 2), 
-						       result(i, 3), 
-						       result(i, 4), 
-						       result(i, 5)) 
-				        );
-	  result(i, 0) = adj[0]; result(i, 1) = adj[1]; result(i, 2) = adj[2];
-	  result(i, 3) = adj[3]; result(i, 4) = adj[4]; result(i, 5) = adj[5];
-	}
+	const cv::Matx<Precision, 6, 6> A = adjoint_matrix(false);
 	
-	return result;
+	return lazy(A) * M * transpose(lazy(A));
 }
 
-// transposed inverse adjoint
+// transposed inverse adjoint (the same, with A^-T)
 template<typename Precision>
 template<typename P2>
-inline cv::Mat_<Precision> RigidTransforms::SE3<Precision>::trinvadjoint(const cv::Mat_<P2> &M) const{
-	
-	cv::Mat_<Precision> result(6, 6);
-	
-	for(int i=0; i<6; i++){
-	  //result.T()[i] = trinvadjoint(M.T()[i]);
-	  cv::Vec<P2, 6> tadj = trinvadjoint(cv::Vec<P2, 6>(M(0, i),
-							    M(1, i),
-							    M(2, i),
-							    M(3, i),
-							    M(4, i),
-							    M(5, i) ) ); 
-	  
-	  result(0, i) = tadj[0]; result(1, i) = tadj[1]; result(2, i) = tadj[2];
-	  result(3, i) = tadj[3]; result(4, i) = tadj[4]; result(5, i) = tadj[5];
-	}
-	for(int i=0; i<6; i++){
-	  //result[i] = trinvadjoint(result[i]);
-	  cv::Vec<P2, 6> tadj = trinvadjoint(cv::Vec<P2, 6>(result(i, 0),
-							    result(i, 1),
-							    result(i, 2),
-							    result(i, 3),
-							    result(i, 4),
-							    result(i, 5) ) 
-					     ); 
-	result(i, 0) = tadj[0]; result(i, 1) = tadj[1]; result(i, 2) = tadj[2];
-	result(i, 3) = tadj[3]; result(i, 4) = tadj[4]; result(i, 5) = tadj[5];
-	}
+inline cv::Matx<Precision, 6, 6> RigidTransforms::SE3<Precision>::trinvadjoint(const cv::Matx<P2, 6, 6> &M) const{
 	
-	return result;
+	const cv::Matx<Precision, 6, 6> T = adjoint_matrix(true);
+	
+	return lazy(T) * M * transpose(lazy(T));
 }
 
 /// Write an SE3 to a stream 
@@ -295,7 +289,11 @@ inline std::ostream& operator <<(std::ostream& os, const RigidTransforms::SE3<Pr
 /// Reads an SE3 from a stream 
 template <typename Precision>
 inline std::istream& operator >>(std::istream& is, RigidTransforms::SE3<Precision>& se3) {
-	is >> se3.get_rotation().get_matrix() >> se3.get_translation();
+	// the rotation (row by row), then the translation
+	for(int i=0; i<3; i++)
+	  for(int j=0; j<3; j++)
+	    is >> se3.get_rotation().get_matrix()(i, j);
+	is >> se3.get_translation()[0] >> se3.get_translation()[1] >> se3.get_translation()[2];
 	
 	se3.get_rotation().coerce();
 	
@@ -328,8 +326,8 @@ struct Operator<MyOperatorOverloads::SE3VMult<P, PV> > {
 	cv::Vec<P0, 4> compute() const {
 	
 	  cv::Vec<P0, 4> res;
-	  cv::Mat_<P> R = se3.get_rotation().get_matrix();
-	  cv::Vec<P, 3> t = se3.get_translation();
+	  const cv::Matx<P, 3, 3> &R = se3.get_rotation().get_matrix();
+	  const cv::Vec<P, 3> &t = se3.get_translation();
 	  //res.template slice<0,3>()=lhs.get_rotation() * rhs.template slice<0,3>();
 	  res[0] = R(0,0) * v[0] + R(0,1) * v[1] + R(0,2) * v[2];
 	  res[1] = R(1,0) * v[0] + R(1,1) * v[1] + R(1,2) * v[2];
@@ -388,8 +386,8 @@ struct Operator<MyOperatorOverloads::VSE3Mult<PV, P> > {
 	
 	cv::Vec<P0, 4> res;
 	//res.template slice<0,3>()=lhs.template slice<0,3>() * rhs.get_rotation();
-	cv::Mat_<P> R = se3.get_rotation().get_matrix();
-	cv::Vec<P, 3> t = se3.get_translation();
+	const cv::Matx<P, 3, 3> &R = se3.get_rotation().get_matrix();
+	const cv::Vec<P, 3> &t = se3.get_translation();
 	res[0] = v[0] * R(0,0) + v[1] * R(1,0) + v[2] * R(2,0); 
 	res[1] = v[0] * R(0,1) + v[1] * R(1,1) + v[2] * R(2,1); 
 	res[2] = v[0] * R(0,2) + v[1] * R(1,2) + v[2] * R(2,2); 
@@ -514,6 +512,45 @@ inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<PM, P>::type> operato
 
 
 
+// The batch transforms. R and t go into scalars first, so the loops see nothing but the arrays 
+// (no re-loading through the object after every store, in case out aliases it)
+template <typename Precision>
+template<typename PV, typename PO>
+inline void RigidTransforms::SE3<Precision>::transform(const cv::Vec<PV, 3>* points, cv::Vec<PO, 3>* out, int n) const {
+	
+	const cv::Matx<Precision, 3, 3> &R = R_.get_matrix();
+	const Precision r00 = R(0, 0), r01 = R(0, 1), r02 = R(0, 2),
+			r10 = R(1, 0), r11 = R(1, 1), r12 = R(1, 2),
+			r20 = R(2, 0), r21 = R(2, 1), r22 = R(2, 2);
+	const Precision tx = t_[0], ty = t_[1], tz = t_[2];
+	
+	for(int i=0; i<n; i++) {
+	  const Precision x = points[i][0], y = points[i][1], z = points[i][2];
+	  out[i][0] = r00 * x + r01 * y + r02 * z + tx;
+	  out[i][1] = r10 * x + r11 * y + r12 * z + ty;
+	  out[i][2] = r20 * x + r21 * y + r22 * z + tz;
+	}
+}
+
+template <typename Precision>
+template<typename PV, typename PO>
+inline void RigidTransforms::SE3<Precision>::transform(const PV* x, const PV* y, const PV* z, PO* xo, PO* yo, PO* zo, int n) const {
+	
+	const cv::Matx<Precision, 3, 3> &R = R_.get_matrix();
+	const Precision r00 = R(0, 0), r01 = R(0, 1), r02 = R(0, 2),
+			r10 = R(1, 0), r11 = R(1, 1), r12 = R(1, 2),
+			r20 = R(2, 0), r21 = R(2, 1), r22 = R(2, 2);
+	const Precision tx = t_[0], ty = t_[1], tz = t_[2];
+	
+	for(int i=0; i<n; i++) {
+	  const Precision xi = x[i], yi = y[i], zi = z[i];
+	  xo[i] = r00 * xi + r01 * yi + r02 * zi + tx;
+	  yo[i] = r10 * xi + r11 * yi + r12 * zi + ty;
+	  zo[i] = r20 * xi + r21 * yi + r22 * zi + tz;
+	}
+}
+
+
 /// Get the SE3 object corresponding to a 6D pose vector
 template <typename Precision>
 template <typename P>
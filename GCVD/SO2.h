@@ -26,6 +26,7 @@ template<typename Precision> inline std::istream & operator >> (std::istream&, S
 /// Class to represent a two-dimensional rotation matrix. Two-dimensional rotation
 /// matrices are members of the Special Orthogonal Lie group SO2. This group can be parameterised with
 /// one number (the rotation angle).
+/// The matrix is a fixed-size cv::Matx (stack storage, deep copies), as in SO3.
 template<typename Precision = float>
 class SO2 {
 	friend std::istream& operator>> <Precision>(std::istream&, SO2& );
@@ -38,14 +39,14 @@ private:
 	template <typename PA, typename PB>
 	inline SO2(const SO2<PA>& a, const SO2<PB>& b) : mat_(a.get_matrix()*b.get_matrix()) {}
 
-	cv::Mat_<Precision> mat_; // the 2x2 matrix containing the transformation.
+	cv::Matx<Precision, 2, 2> mat_; // the 2x2 matrix containing the transformation.
 	
 	
 public:
 	
 	
 	/// Default constructor. Initialises the matrix to the identity (no rotation)
-	SO2() :mat_(cv::Mat_<Precision>::eye(2, 2))
+	SO2() :mat_(cv::Matx<Precision, 2, 2>::eye())
 	{}
 	
 	
@@ -54,6 +55,11 @@ public:
 		*this = rhs; 
 		coerce(); // skip for now...
 	}
+	
+	/// @overload
+	SO2(const cv::Matx<Precision, 2, 2> &rhs) : mat_(rhs) {  
+		coerce();
+	}
 
 	// Construct from an angle (Lie logarithm).
 	explicit SO2(const Precision angle) { *this = exp(angle); }
@@ -71,6 +77,14 @@ public:
 		return *this;
 	}
 	
+	/// @overload
+	template <typename P> 
+	SO2& operator =(const cv::Matx<P, 2, 2> &R){
+		mat_ = cv::Matx<Precision, 2, 2>(R);
+		coerce();
+		return *this;
+	}
+	
 	
 	// some helper functions...
 	cv::Vec<Precision, 2> colAt(int index) {
@@ -131,29 +145,29 @@ public:
 	/// Self right-multiply by another rotation SO2
 	template <typename P>
 	SO2& operator *=(const SO2<P> &right){
-		mat_ = mat_ * right.get_matrix();
+		mat_ = mat_ * cv::Matx<Precision, 2, 2>(right.get_matrix());
 		
 		return *this;
 	}
 
 	/// Right-multiply by another SO2
 	template <typename P>
-	SO2<typename MyOperatorOverloads::MultiplyType<Precision, P>::type>& operator *(const SO2<P> &right) const { 
+	SO2<typename MyOperatorOverloads::MultiplyType<Precision, P>::type> operator *(const SO2<P> &right) const { 
 		 
 	    typedef typename MyOperatorOverloads::MultiplyType<Precision, P>::type P0;
 	    
-	    return SO2<P0>( this->mat_ * right->get_matrix() ); 
+	    return SO2<P0>( cv::Matx<P0, 2, 2>(this->mat_) * cv::Matx<P0, 2, 2>(right.get_matrix()) ); 
 	}
 
 	/// Returns the SO2 as a Matrix<2>
-	const cv::Mat_<Precision>& get_matrix() const {return mat_;}
+	const cv::Matx<Precision, 2, 2>& get_matrix() const {return mat_;}
 	
-	cv::Mat_<Precision>& get_matrix() {return mat_;} // IMPORTANT OVERLOAD!!!!!!!!
+	cv::Matx<Precision, 2, 2>& get_matrix() {return mat_;} // IMPORTANT OVERLOAD!!!!!!!!
 
 	/// returns Lie generator matrix (skew symmetric matrix)
-	static cv::Mat_<Precision> generator() {
+	static cv::Matx<Precision, 2, 2> generator() {
 		
-		cv::Mat_<Precision> result(2,2);
+		cv::Matx<Precision, 2, 2> result;
 		result(0, 0) = 0; result(0, 1) = -1;
 		result(1, 0) = 1; result(1, 1) = 0;
 		
@@ -176,7 +190,7 @@ inline std::ostream& operator << (std::ostream &os, const RigidTransforms::SO2<P
 /// Read from SO2 to a stream 
 template <typename Precision>
 inline std::istream& operator>>(std::istream &is, RigidTransforms::SO2<Precision> &right) {
-	is >> right.mat_;
+	is >> right.mat_(0, 0) >> right.mat_(0, 1) >> right.mat_(1, 0) >> right.mat_(1, 1);
 	right.coerce(); // skip for now
 	
 	return is;
@@ -189,9 +203,10 @@ inline cv::Vec<typename MyOperatorOverloads::MultiplyType<P, PV>::type, 2> opera
   
   typedef typename MyOperatorOverloads::MultiplyType<P, PV>::type P0;
   
-  cv::Mat_<P0> temp = so2.get_matrix() * v; // a 2x1 matrix
+  const cv::Matx<P, 2, 2> &R = so2.get_matrix();
   
-  return cv::Vec<P0, 2>( temp(0, 0), temp(1, 0) );
+  return cv::Vec<P0, 2>( R(0, 0) * v[0] + R(0, 1) * v[1], 
+			 R(1, 0) * v[0] + R(1, 1) * v[1] );
 }
 
 /// Left-multiply by a Vector // this basically results in a vector u = R^T * v
@@ -201,23 +216,24 @@ inline cv::Vec<typename MyOperatorOverloads::MultiplyType<PV,P>::type, 2> operat
   
   typedef typename MyOperatorOverloads::MultiplyType<P, PV>::type P0;
   
-  cv::Mat_<P0> temp = v * so2.get_matrix(); // a 2x1 matrix if all went well...
+  const cv::Matx<P, 2, 2> &R = so2.get_matrix();
   
-  return cv::Vec<P0, 2>( temp(0,0), temp(1, 0) );
+  return cv::Vec<P0, 2>( R(0, 0) * v[0] + R(1, 0) * v[1], 
+			 R(0, 1) * v[0] + R(1, 1) * v[1] );
 }
 
 /// Right-multiply by a Matrix
 template <typename P, typename PM> 
 inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<P,PM>::type> operator *(const RigidTransforms::SO2<P> &so2, const cv::Mat_<PM> &M){
 	
-  return so2.get_matrix() * M;
+  return cv::Mat_<P>(so2.get_matrix()) * M;
 }
 
 /// Left-multiply by a Matrix
 template <typename PM, typename P>
 inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<PM,P>::type> operator *(const cv::Mat_<PM> M, const RigidTransforms::SO2<P> &so2) {
 	
-  return M * so2.get_matrix();
+  return M * cv::Mat_<P>(so2.get_matrix());
 }
 
 
@@ -34,6 +34,9 @@ template<class Precision> inline std::istream & operator >>(std::istream &, SE3<
 /// finite rotation vector, i.e. a three-dimensional vector whose direction is the axis of rotation
 /// and whose length is the angle of rotation in radians. Exponentiating this vector gives the matrix,
 /// and the logarithm of the matrix gives this vector.
+///
+/// The matrix is a fixed-size cv::Matx (not a cv::Mat_), so an SO3 lives on the stack: constructing, copying and
+/// exponentiating one never touches the allocator, and copies are deep (no shared data between copies).
 template <typename Precision = float>
 class SO3 {
   
@@ -45,7 +48,7 @@ private:
 	// that does this job as opposed to the SO3(SO3) constructor...
 	inline SO3(const SO3& so3, const Invert&) : mat_(so3.mat_.t()) {}
 	
-	cv::Mat_<Precision> mat_;
+	cv::Matx<Precision, 3, 3> mat_;
   
   
 public:
@@ -56,7 +59,7 @@ public:
 	//friend class SIM3<Precision>;
 
 	/// Default constructor. Initialises the matrix to the identity (no rotation)
-	SO3() : mat_( cv::Mat_<Precision>::eye(3, 3) ) {} 
+	SO3() : mat_( cv::Matx<Precision, 3, 3>::eye() ) {} 
 	
 	
 	/// Construct from the axis of rotation (and angle given by the magnitude).
@@ -65,7 +68,15 @@ public:
 	
 	/// Construct from a rotation matrix.
 	template <typename P>
-	SO3(const cv::Mat_<P> &r) : mat_(r) { }
+	SO3(const cv::Matx<P, 3, 3> &r) : mat_(r) { }
+	
+	/// Construct from a (3x3) rotation matrix in a cv::Mat_ (copied)
+	template <typename P>
+	SO3(const cv::Mat_<P> &r) { 
+	  for(int i=0; i<3; i++) 
+	    for(int j=0; j<3; j++) 
+	      mat_(i, j) = (Precision)r(i, j);
+	}
 	
 	/// creates an SO3 as a rotation that takes Vector a into the direction of Vector b
 	/// with the rotation axis along a ^ b. If |a ^ b| == 0, it creates the identity rotation.
@@ -80,13 +91,13 @@ public:
 			//check that the vectors are in the same direction if cross product is 0. If not,
 			//this means that the rotation is 180 degrees, which leads to an ambiguity in the rotation axis.
 			assert(a * b >= 0 && "Attempted to construct an SO3 from two collinear oposite vectors!");
-			mat_ = cv::Mat_<Precision>::eye(3,3);
+			mat_ = cv::Matx<Precision, 3, 3>::eye();
 			return;
 		}
 		
 		// make n a unit vector
 		n = cv::normalize(n);
-		cv::Mat_<Precision> R1(3,3);
+		cv::Matx<Precision, 3, 3> R1;
 		cv::Vec<P1, 3>  a_normalized = cv::normalize(a);
 		// 1. Put normalized a in the first column of the rotation matrux
 		R1(0, 0) = a_normalized[0]; R1(1, 0) = a_normalized[1]; R1(2, 0) = a_normalized[2];
@@ -123,11 +134,21 @@ public:
 	/// to make sure that the matrix is a valid rotation matrix.
 	template <typename P>
 	SO3& operator =(const cv::Mat_<P>  &r) {
-		mat_ = r;
+		for(int i=0; i<3; i++) 
+		  for(int j=0; j<3; j++) 
+		    mat_(i, j) = (Precision)r(i, j);
 		coerce(); // avoid this &^*$*$ for now
 		return *this;
 	}
 	
+	/// @overload
+	template <typename P>
+	SO3& operator =(const cv::Matx<P, 3, 3>  &r) {
+		mat_ = r;
+		coerce();
+		return *this;
+	}
+	
 	// some helper functions...
 	inline cv::Vec<Precision, 3> colAt(int index) {
 	  return cv::Vec<Precision, 3>(mat_(0, index), 
@@ -198,20 +219,22 @@ public:
 	template<typename P>
 	SO3<typename MyOperatorOverloads::MultiplyType<Precision, P>::type> operator *(const SO3<P> &right) const { 
 	  
-	    return SO3<>( this->mat_ * right.get_matrix() ); 
+	    typedef typename MyOperatorOverloads::MultiplyType<Precision, P>::type P0;
+	    
+	    return SO3<P0>( cv::Matx<P0, 3, 3>(this->mat_) * cv::Matx<P0, 3, 3>(right.get_matrix()) ); 
 	}
 
 	/// Returns the SO3 as a Matrix<3>
-	const cv::Mat_<Precision>& get_matrix() const {return mat_;}
+	const cv::Matx<Precision, 3, 3>& get_matrix() const {return mat_;}
 
-	cv::Mat_<Precision>& get_matrix() {return mat_;}
+	cv::Matx<Precision, 3, 3>& get_matrix() {return mat_;}
 	/// Returns the i-th generator.  The generators of a Lie group are the basis
 	/// for the space of the Lie algebra.  For %SO3, the generators are three
 	/// \f$3\times3\f$ matrices representing the three possible (linearised)
 	/// rotations.
-	inline static cv::Mat_<Precision> generator(int i) {
+	inline static cv::Matx<Precision, 3, 3> generator(int i) {
 	  
-		cv::Mat_<Precision> result = cv::Mat_<Precision>::zeros(3, 3);
+		cv::Matx<Precision, 3, 3> result = cv::Matx<Precision, 3, 3>::zeros();
 		result( (i+1)%3, (i+2)%3) = -1;
 		result( (i+2)%3, (i+1)%3) = 1;
 		return result;
@@ -256,7 +279,10 @@ inline std::ostream& operator << (std::ostream& os, const RigidTransforms::SO3<P
 template <typename Precision>
 inline std::istream& operator >>(std::istream& is, RigidTransforms::SO3<Precision>& so3) {
 	
-  is >> so3.mat_;
+  // row by row
+  for(int i=0; i<3; i++)
+    for(int j=0; j<3; j++)
+      is >> so3.mat_(i, j);
   so3.coerce(); 
   return is;
 }
@@ -276,7 +302,7 @@ inline std::istream& operator >>(std::istream& is, RigidTransforms::SO3<Precisio
 ///@param R Matrix to hold the return value.
 ///@relates SO3
 template <typename PV, typename Ps, typename P>
-inline static void rodrigues_so3_exp(const cv::Vec<PV, 3> &w,  const Ps A, const Ps B, cv::Mat_<P> &R) {
+inline static void rodrigues_so3_exp(const cv::Vec<PV, 3> &w,  const Ps A, const Ps B, cv::Matx<P, 3, 3> &R) {
     	
 	// This is basically Rodrigues' formula given the sin and cos ratios in the argument list
         // (which are provided by a separate fnction for some strange reason (see below)
@@ -459,7 +485,7 @@ inline cv::Vec<typename MyOperatorOverloads::MultiplyType<PV, P>::type, 3> opera
 template<typename P, typename PM> 
 inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<P, PM>::type> operator *(const RigidTransforms::SO3<P> &so3, const cv::Mat_<PM> &M) {
 	
-  return so3.get_matrix() * M;
+  return cv::Mat_<P>(so3.get_matrix()) * M;
 }
 
 /// Left-multiply by a matrix
@@ -467,7 +493,7 @@ inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<P, PM>::type> operato
 template<typename PM, typename P> 
 inline cv::Mat_<typename MyOperatorOverloads::MultiplyType<PM, P>::type> operator *(const cv::Mat_<PM> &M, const RigidTransforms::SO3<P> &so3) {
 	
-  return M * so3.get_matrix();
+  return M * cv::Mat_<P>(so3.get_matrix());
 }
 
 
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include "Persistence/GStringUtil.h"
 #include "Persistence/instances.h"
+#include "Profiling.h"
 
 
 using namespace std;
@@ -37,6 +38,7 @@ GLWindow2::GLWindow2(cv::Size2i irSize, string sTitle) : GLWindow(irSize, sTitle
   mirVideoSize = irSize;
   GUI.RegisterCommand("GLWindow.AddMenu", GUICommandCallBack, this);
   glSetFont("sans");
+  glBuildTextAtlas(); // rasterize the font once (the window's context is current by now)
   mvMCPoseUpdate = cv::Vec<float, 6>(0, 0, 0, 0, 0 , 0);
   mvLeftPoseUpdate = cv::Vec<float, 6>(0, 0, 0, 0, 0 , 0);
 };
@@ -142,6 +144,16 @@ void GLWindow2::SetupVideoRasterPosAndZoom()
   glPixelZoom(adZoom[0], -adZoom[1]);
 }
 
+// Upload the frame (asynchronously, through the texture's pixel buffer) and draw it over the video area: 
+// the quad spans -0.5 ... size - 0.5, so the texel centers land on integer image coordinates, as with SetupVideoOrtho.
+void GLWindow2::DrawVideoFrame(const cv::Mat &im)
+{
+  mVideoTexture.Upload(im);
+  // (over the size of the texture: an empty or unsupported frame blacks out the area of the last good one)
+  cv::Size2i irSize = mVideoTexture.Size();
+  mVideoTexture.Draw(-0.5, -0.5, (double)irSize.width - 0.5, (double)irSize.height - 0.5);
+}
+
 void GLWindow2::SetupViewport()
 {
   glViewport(0, 0, size().width, size().height);
@@ -153,12 +165,17 @@ void GLWindow2::PrintString(cv::Point2i irPos, std::string s)
   glPushMatrix();
   glTranslatef(irPos.x, irPos.y, 0.0);
   glScalef(8,-8,1);
-  GLXInterface::glDrawText(s, NICE, 1.6, 0.1);
+  // textured quads from the glyph atlas; the layout of an unchanged string (e.g., the caption) is cached
+  GLXInterface::glDrawText(s, ATLAS, 1.6, 0.1);
   glPopMatrix();
 }
 
 void GLWindow2::DrawCaption(string s)
 {
+  // Optionally, the rolling stage timings (median / 90th percentile, see Profiling.h) go under the caption
+  static pvar3_cached<int> gvnShowStats("GLWindow.ShowStats", 0, SILENT);
+  if(*gvnShowStats) s += (s.length() == 0 || s[s.length() - 1] == '\n' ? "" : "\n") + Profiling::Overlay();
+  
   if(s.length() == 0)
     return;
   
@@ -20,6 +20,7 @@
 
 
 #include "GCVD/GLWindow.h"
+#include "GCVD/GLVideoTexture.h"
 
 //#include "GLWindowMenu.h"
 
@@ -63,6 +64,10 @@ public:
   void SetupUnitOrtho();
   void SetupWindowOrtho();
   void SetupVideoRasterPosAndZoom();
+  
+  // Draws a video frame (grayscale or BGR) in the video ortho frame through a streamed texture 
+  // (call SetupVideoOrtho first). Takes the place of glDrawPixels at the raster position.
+  void DrawVideoFrame(const cv::Mat &im);
 
   // Text display functions:
   void PrintString(cv::Point2i irPos, std::string s);
@@ -84,6 +89,8 @@ protected:
 
   cv::Size2i mirVideoSize;   // The size of the source video material.
   
+  GLVideoTexture mVideoTexture; // The video frames are streamed into this texture
+  
 
   // Event handling routines:
   virtual void on_key_down(GLWindow&, int key);
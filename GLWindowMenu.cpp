@@ -21,6 +21,7 @@ GLWindowMenu::GLWindowMenu(string sName, string sTitle)
   GUI.RegisterCommand(msName+".AddMenuSlider", GUICommandCallBack, this);
   GUI.RegisterCommand(msName+".AddMenuMonitor", GUICommandCallBack, this);
   GUI.RegisterCommand(msName+".ShowMenu", GUICommandCallBack, this);
+  GUI.RegisterTypedCommand<string>(msName+".ShowMenu", ShowMenuCallBack, this);
   PV3.Register(mgvnMenuItemWidth, msName+".MenuItemWidth", 90, HIDDEN | SILENT);
   PV3.Register(mgvnMenuTextOffset, msName+".MenuTextOffset", 20, HIDDEN | SILENT);
   PV3.Register(mgvnEnabled, msName+".Enabled", 1, HIDDEN | SILENT);
@@ -44,6 +45,16 @@ void GLWindowMenu::GUICommandCallBack(void *ptr, string sCommand, string sParams
   ((GLWindowMenu*) ptr)->GUICommandHandler(sCommand, sParams);
 }
 
+void GLWindowMenu::ShowMenuCallBack(void* ptr, const string &sSubMenu)
+{
+  ((GLWindowMenu*) ptr)->ShowMenu(sSubMenu);
+}
+
+void GLWindowMenu::ShowMenu(const string &sSubMenu)
+{
+  msCurrentSubMenu = sSubMenu;
+}
+
 void GLWindowMenu::GUICommandHandler(string sCommand, string sParams)
 {
   vector<string> vs = ChopAndUnquoteString(sParams);  
@@ -60,6 +71,12 @@ void GLWindowMenu::GUICommandHandler(string sCommand, string sParams)
       m.sName = vs[1];
       m.sParam = UncommentString(vs[2]);
       m.sNextMenu = (vs.size()>3)?(vs[3]):("");
+      // Resolve "command params" once; lines that need the parser (brace expansion) are left to ParseLine
+      if(m.sParam.find('{') == string::npos) {
+	
+	string::size_type nSpace = m.sParam.find_first_of(" \t");
+	m.cmd = GUI.Resolve(m.sParam.substr(0, nSpace), nSpace == string::npos ? "" : m.sParam.substr(nSpace + 1));
+      }
       mmSubMenus[vs[0]].mvItems.push_back(m);
       return;
     }
@@ -283,31 +300,38 @@ bool GLWindowMenu::HandleClick(int nMouseButton, int state, int x, int y)
   switch(SelectedItem.type)
     {
     case Button:
-      GUI.ParseLine(SelectedItem.sParam);
+      // a registered command goes straight to its callbacks; anything else (e.g. an assignment) through the parser
+      if(SelectedItem.cmd.Valid())
+	SelectedItem.cmd();
+      else
+	GUI.ParseLine(SelectedItem.sParam);
       break;
     case Toggle:
-      *(SelectedItem.gvnIntValue)^=1;
+      // (through set(), so that cached readers of the variable see the change)
+      SelectedItem.gvnIntValue.set(*(SelectedItem.gvnIntValue) ^ 1);
       break;
     case Slider:
       {
+	int nValue = *(SelectedItem.gvnIntValue);
 	if(nMouseButton == GLWindow::BUTTON_WHEEL_UP)
 	  {
-	    *(SelectedItem.gvnIntValue)+=1;
-	    if(*(SelectedItem.gvnIntValue) > SelectedItem.max)
-	      *(SelectedItem.gvnIntValue) = SelectedItem.max;
+	    nValue += 1;
+	    if(nValue > SelectedItem.max)
+	      nValue = SelectedItem.max;
 	  }
 	else if(nMouseButton == GLWindow::BUTTON_WHEEL_DOWN)
 	  {
-	    *(SelectedItem.gvnIntValue)-=1;
-	    if(*(SelectedItem.gvnIntValue) < SelectedItem.min)
-	      *(SelectedItem.gvnIntValue) = SelectedItem.min;
+	    nValue -= 1;
+	    if(nValue < SelectedItem.min)
+	      nValue = SelectedItem.min;
 	  }
 	else
 	  {
 	    int nPos = *mgvnMenuItemWidth - ((mnWidth - x) % *mgvnMenuItemWidth);
 	    double dFrac = (double) nPos / *mgvnMenuItemWidth;
-	    *(SelectedItem.gvnIntValue) = (int)(dFrac * (1.0 + SelectedItem.max - SelectedItem.min)) + SelectedItem.min;
+	    nValue = (int)(dFrac * (1.0 + SelectedItem.max - SelectedItem.min)) + SelectedItem.min;
 	  };
+	SelectedItem.gvnIntValue.set(nValue);
       }
       break;
     case Monitor:
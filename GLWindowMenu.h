@@ -10,6 +10,7 @@
 #include <vector>
 #include <map>
 #include "Persistence/PVars.h"
+#include "Persistence/GUI.h"
 #include "GLWindow2.h"
 
 class GLWindowMenu
@@ -25,6 +26,10 @@ class GLWindowMenu
   void GUICommandHandler(std::string sCommand, std::string sParams);
   static void GUICommandCallBack(void* ptr, std::string sCommand, std::string sParams);
   
+  // <name>.ShowMenu as a typed command (for GUICommandHandle calls on every frame; no parsing, just an assignment)
+  void ShowMenu(const std::string &sSubMenu);
+  static void ShowMenuCallBack(void* ptr, const std::string &sSubMenu);
+  
   bool HandleClick(int button, int state, int x, int y);
 
   
@@ -38,6 +43,7 @@ class GLWindowMenu
     std::string sName;
     std::string sParam;
     std::string sNextMenu;
+    Persistence::GUICommandHandle cmd; // a button's command, resolved when the button is added
     Persistence::pvar_int gvnIntValue;  // Not used by all, but used by some (that's a shortcut for pvar2<int>...
     int min;
     int max;
@@ -0,0 +1,578 @@
+// *-* c++ *-*
+// Copyright 2008 Isis Innovation Limited
+
+// N-th implementation of a camera model
+// GK 2007
+// Evolved a half dozen times from the CVD-like model I was given by
+// TWD in 2000
+//
+// George: This used to be the ATANCamera, which used the ``FOV'' distortion model of
+// Deverneay and Faugeras, Straight lines have to be straight, 2001.
+// It is now a template on a camera model policy (see CameraModels.h), which provides the distortion
+// (and its derivatives) along with a compile-time number of parameters. The ATAN model is still the default
+// (typedef'ed as ATANCamera at the bottom of this file), but radial-tangential and equidistant fisheye models are also available.
+//
+// BEWARE: This camera model caches intermediate results in member variables
+// Some functions therefore depend on being called in order: i.e.
+// GetProjectionDerivs() uses data stored from the last Project() or UnProject()
+// THIS MEANS YOU MUST BE CAREFUL WITH MULTIPLE THREADS
+// Best bet is to give each thread its own version of the camera!
+//
+// Camera parameters are stored in a GVar, but changing the gvar has no effect
+// until the next call to RefreshParams() or SetImageSize().
+//
+// Pixel conventions are as follows:
+// For Project() and Unproject(),
+// round pixel values - i.e. (0.0, 0.0) - refer to pixel centers
+// I.e. the top left pixel in the image covers is centered on (0,0)
+// and covers the area (-.5, -.5) to (.5, .5)
+//
+// Be aware that this is not the same as what opengl uses but makes sense
+// for acessing pixels using ImageRef, especially ir_rounded.
+//
+// What is the UFB?
+// This is for projecting the visible image area
+// to a unit square coordinate system, with the top-left at 0,0,
+// and the bottom-right at 1,1
+// This is useful for rendering into textures! The top-left pixel is NOT
+// centered at 0,0, rather the top-left corner of the top-left pixel is at
+// 0,0!!! This is the way OpenGL thinks of pixel coords.
+// There's the Linear and the Distorting version -
+// For the linear version, can use
+// glMatrixMode(GL_PROJECTION); glLoadIdentity();
+// glMultMatrix(Camera.MakeUFBLinearFrustumMatrix(near,far));
+// To render un-distorted geometry with full frame coverage.
+//
+
+#ifndef __GENERIC_CAMERA_H
+#define __GENERIC_CAMERA_H
+
+
+#define DEFAULT_IMG_HEIGHT 480
+#define DEFAULT_IMG_WIDTH 640
+
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "Persistence/PVars.h"
+#include "Persistence/instances.h"
+
+#include "CameraModels.h"
+
+#include "OpenCV.h"
+
+
+template<class CameraModel> class CameraCalibrator;
+class CalibImage;
+
+// The parameters are:
+// 0 - normalized x focal length
+// 1 - normalized y focal length
+// 2 - normalized x offset
+// 3 - normalized y offset
+// 4 ... CameraModel::NumParams-1 - distortion parameters (model specific)
+
+template<class CameraModel>
+class GenericCamera {
+ public:
+
+  static const int NumParams = CameraModel::NumParams;
+  typedef cv::Vec<float, CameraModel::NumParams> ParamVector;
+
+  GenericCamera(std::string sName, const cv::Size2i imgsize = cv::Size2i(DEFAULT_IMG_WIDTH, DEFAULT_IMG_HEIGHT) );
+
+  // Image size get/set: updates the internal projection params to that target image size.
+  void SetImageSize(const cv::Vec2f &v2ImageSize);
+  void SetImageSize(const cv::Size2i &imSize);
+
+  cv::Vec2f GetImageSize() {return mvImageSize;};
+  void RefreshParams();
+
+  // Various projection functions
+  inline cv::Vec2f Project(const cv::Vec2f&); // Projects from camera z=1 plane to pixel coordinates, with radial distortion
+  inline cv::Vec2f UnProject(const cv::Vec2f&); // Inverse operation
+
+  cv::Vec2f UFBProject(const cv::Vec2f &camframe);
+  cv::Vec2f UFBUnProject(const cv::Vec2f &camframe);
+  inline cv::Vec2f UFBLinearProject(const cv::Vec2f &camframe);
+  inline cv::Vec2f UFBLinearUnProject(const cv::Vec2f &fbframe);
+
+  inline cv::Matx22f GetProjectionDerivs(); // 2x2 Projection jacobian
+  inline cv::Matx22f GetProjectionDerivs(const cv::Vec2f &v2Cam); // 2x2 Projection jacobian at v2Cam (no cached state)
+
+  // Batch version of Project() for a whole view, in SoA form (z=1 coordinates in pfX/pfY, pixels out in pfU/pfV).
+  // It does NOT touch the cached state of the last projection. If pbValid is given, the flags of the points
+  // beyond the valid radius are cleared (the rest are left as they were).
+  void ProjectBatch(const float *pfX, const float *pfY, int n, float *pfU, float *pfV, unsigned char *pbValid = NULL);
+
+  inline bool Invalid() {  return mbInvalid;}
+  inline double LargestRadiusInImage() {  return mdLargestRadius; }
+  inline double OnePixelDist() { return mdOnePixelDist; }
+
+  // The z=1 plane bounding box of what the camera can see
+  inline cv::Vec2f ImplaneTL() { return mvImplaneTL; }
+  inline cv::Vec2f ImplaneBR() { return mvImplaneBR; }
+
+  // OpenGL helper function
+  cv::Mat_<float> MakeUFBLinearFrustumMatrix(float near, float far); // Returns A 4x4 matrix
+
+  // Feedback for Camera Calibrator
+  double PixelAspectRatio() { return mvFocal[1] / mvFocal[0];}
+
+  // The name of the PVar that holds the parameters (e.g., "Camera.Parameters" for the ATAN model)
+  std::string ParamsName() const { return msName + CameraModel::ParamsSuffix(); }
+  const ParamVector& GetParams() { return *mpvvCameraParams; }
+
+
+ protected:
+  Persistence::pvar3<ParamVector> mpvvCameraParams; // The actual camera parameters
+
+
+  cv::Matx<float, 2, CameraModel::NumParams> GetCameraParameterDerivs(); // 2 x NumParams
+  // The same for a whole view: the derivatives of pfU/pfV (as returned by ProjectBatch) wrt parameter i
+  // go to pfDU[i*n ... i*n + n-1] and pfDV[i*n ... i*n + n-1].
+  void GetCameraParameterDerivs(const float *pfX, const float *pfY, const float *pfU, const float *pfV, int n,
+				float *pfDU, float *pfDV);
+  void UpdateParams(const ParamVector &vUpdate);
+  void SetParams(const ParamVector &vParams);
+  void DisableRadialDistortion();
+  void EnableRadialDistortion();
+
+  // Cached from the last project/unproject:
+  cv::Vec2f mvLastCam;      // Last z=1 coord
+  cv::Vec2f mvLastIm;       // Last image/UFB coord
+  cv::Vec2f mvLastDistCam;  // Last distorted z=1 coord
+  double mdLastR;           // Last z=1 radius
+  bool mbInvalid;           // Was the last projection invalid?
+
+  // Cached from last RefreshParams:
+  float mdLargestRadius; // Largest R in the image
+  float mdMaxR;          // Largest R for which we consider projection valid
+  float mdOnePixelDist;  // z=1 distance covered by a single pixel offset (a rough estimate!)
+  bool mbDistortionEnabled; // Set to false by DisableRadialDistortion(); freezes the distortion derivatives
+  cv::Vec2f mvCenter;     // Pixel projection center
+  cv::Vec2f mvFocal;      // Pixel focal length
+  cv::Vec2f mvInvFocal;   // Inverse pixel focal length
+  cv::Vec2f mvImageSize;
+  cv::Vec2f mvUFBLinearFocal;
+  cv::Vec2f mvUFBLinearInvFocal;
+  cv::Vec2f mvUFBLinearCenter;
+  cv::Vec2f mvImplaneTL;
+  cv::Vec2f mvImplaneBR;
+
+  // The distortion model (caches its own coefficients in RefreshParams)
+  CameraModel mModel;
+
+  std::string msName;
+
+  template<class> friend class CameraCalibrator;   // friend declarations allow access to calibration jacobian and camera update function.
+  template<class> friend class CalibOptimizer;
+  friend class CalibImage;
+};
+
+
+template<class CameraModel>
+GenericCamera<CameraModel>::GenericCamera(std::string sName, const cv::Size2i imgsize  )
+{
+  // The camera name is used to find the camera's parameters in a GVar.
+  msName = sName;
+  mbDistortionEnabled = true;
+  // Need to do a "get" in order to put the tag in the list. value is loaded either from the file, or from the defaults
+  Persistence::PV3::get<ParamVector>(ParamsName(), CameraModel::DefaultParams(), Persistence::SILENT);
+  Persistence::PV3.Register(mpvvCameraParams, ParamsName(), CameraModel::DefaultParams(), Persistence::HIDDEN | Persistence::FATAL_IF_NOT_DEFINED);
+  // assingining default image size.
+  // But the Calibrator or GTAM should be assigning the correct dimensions upon initialization
+  mvImageSize[0] = imgsize.width;
+  mvImageSize[1] = imgsize.height;
+
+  RefreshParams();
+}
+
+
+template<class CameraModel>
+void GenericCamera<CameraModel>::SetImageSize(const cv::Vec2f &vImageSize)
+{
+  mvImageSize = vImageSize;
+  RefreshParams();
+};
+
+
+template<class CameraModel>
+void GenericCamera<CameraModel>::SetImageSize(const cv::Size2i &imSize)
+{
+  SetImageSize( cv::Vec2f(imSize.width, imSize.height) );
+};
+
+
+template<class CameraModel>
+void GenericCamera<CameraModel>::RefreshParams()
+{
+  // This updates internal member variables according to the current camera parameters,
+  // and the currently selected target image size.
+  //
+  const ParamVector &vParams = *mpvvCameraParams;
+
+  // First: Focal length and image center in pixel coordinates
+  mvFocal[0] = mvImageSize[0] * vParams[0];         // fx = p[0] * IMG_WIDTH
+  mvFocal[1] = mvImageSize[1] * vParams[1];         // fy = p[1] * IMG_HEIGHT
+  mvCenter[0] = mvImageSize[0] * vParams[2] - 0.5;  // cx = IMG_WIDTH * p[2]  (NOTE!!! the 0.5 is just an OpenGL related arbitrary offset;
+						    // it's sole purpose is to simply force border pixels into visible OpenGL canvas)
+  mvCenter[1] = mvImageSize[1] * vParams[3] - 0.5;  // cy = IMG_HEIGHT * p[3] (again, 0.5 is just an arbitrary offfset...)
+
+  // One over focal length
+  mvInvFocal[0] = 1.0 / mvFocal[0];   // inverse "horizontal: focal length: 1 / fx
+  mvInvFocal[1] = 1.0 / mvFocal[1];   // inverse "vertical" focal length: 1 / fy
+
+  // The distortion model caches its own coefficients
+  mModel.Refresh(vParams);
+
+  // We need to compute the largest radius in image.
+  // This is taken as the point in the two diagonals that lies the farthest from (cx, cy),
+  // which will obviously be one of the four distant image corners.
+  // Point is found using [0, 1]x[0, 1] image coordinate space since camera parameters are stored scaled by the dimensions of the image
+  // (hence there is no need to to work with pixels).
+  cv::Vec2f v2( std::max( vParams[2], 1.0f - vParams[2] ) / vParams[0],
+		std::max( vParams[3], 1.0f - vParams[3] ) / vParams[1] );
+  // Retrieve the undistorted radius of the point
+  // (for the ATAN model this is exactly tan(r*w) / (2 * tan(w/2)))
+  mdLargestRadius = cv::norm( mModel.Undistort(v2) );
+
+  // At what stage does the model become invalid? (GK)
+  // George: So Klein chooses 1.5 x <largest radius> to be the boundary of model validity
+  mdMaxR = 1.5 * mdLargestRadius; // (pretty arbitrary)
+
+  // work out world radius of one pixel (GK).
+  // (This only really makes sense for square-ish pixels) (GK).
+  // George: Klein is trying to obtain (roughly) the actual distance of 1 pixel in the normalized Euclidean world.
+  // So he takes the middle pixel and the pixel at +(1, 1) offset from the middle, he back-projects them
+  // onto the normalized Euclidean plane and takes the norm of the difference (divided by two).
+  {
+    cv::Vec2f v2Center = UnProject(0.5 * mvImageSize);
+    cv::Vec2f v2RootTwoAway = UnProject(0.5 * mvImageSize + cv::Vec2f(1, 1));
+    cv::Vec2f v2Diff = v2Center - v2RootTwoAway;
+    mdOnePixelDist = cv::norm(v2Diff) / sqrt(2.0);
+  }
+
+  // Work out the linear projection values for the UFB
+  {
+    // First: Find out how big the linear bounding rectangle must be
+    std::vector<cv::Vec2f > vv2Verts;
+    vv2Verts.push_back(UnProject(cv::Vec2f( -0.5, -0.5)));                              // Backproject Left-lower corner
+    vv2Verts.push_back(UnProject(cv::Vec2f( mvImageSize[0]-0.5, -0.5))); 		// Backproject Right lower corner to Euclidean norm. plane
+    vv2Verts.push_back(UnProject(cv::Vec2f( mvImageSize[0]-0.5, mvImageSize[1]-0.5)));  // Backproject Right-Upper corner to norm. Euclidean plabe.
+    vv2Verts.push_back(UnProject(cv::Vec2f( -0.5, mvImageSize[1]-0.5)));                // Backproject Left-Upper corner to norm. Euclidean plane.
+    cv::Vec2f v2Min = vv2Verts[0];
+    cv::Vec2f v2Max = vv2Verts[0];
+    // working out the two furthest points in the normalized Euclidean plane (most likely the 1st or 2nd diagonal)
+    for(int i=0; i<4; i++)
+      for(int j=0; j<2; j++) {
+
+	  if(vv2Verts[i][j] < v2Min[j]) v2Min[j] = vv2Verts[i][j];
+	  if(vv2Verts[i][j] > v2Max[j]) v2Max[j] = vv2Verts[i][j];
+	}
+    mvImplaneTL = v2Min; // Upper/Top-Left
+    mvImplaneBR = v2Max; // Bottom-Right
+
+    // Store projection parameters to fill this bounding box
+    cv::Vec2f v2Range = v2Max - v2Min;
+    mvUFBLinearInvFocal = v2Range;
+    mvUFBLinearFocal[0] = 1.0 / mvUFBLinearInvFocal[0];
+    mvUFBLinearFocal[1] = 1.0 / mvUFBLinearInvFocal[1];
+    mvUFBLinearCenter[0] = -1.0 * v2Min[0] * mvUFBLinearFocal[0];
+    mvUFBLinearCenter[1] = -1.0 * v2Min[1] * mvUFBLinearFocal[1];
+  }
+
+}
+
+// Project from the normalized EUCLIDEAN camera plane (z=1) to image pixels (distortion takes place in Euclidean coordinates)
+// while storing intermediate calculation results in member variables.
+// We MUST distort the Euclidean coordinates before we dump them on the image and then project on the image pinhole-style....
+template<class CameraModel>
+inline cv::Vec2f GenericCamera<CameraModel>::Project(const cv::Vec2f &vNormEuc) {
+  mvLastCam = vNormEuc;
+  // get the distance from the origin in the Euclidean projection plane n mdLastR
+  mdLastR = sqrt(mvLastCam[0] * mvLastCam[0] + mvLastCam[1] * mvLastCam[1]); // the undistorted radius of the normalized Euclidean coordinates
+  mbInvalid = (mdLastR > mdMaxR); // We cant have a radius beyond the maximum radius
+				  // (as estimated from image border back-projections/un-projections in refreshparams()
+  mvLastDistCam = mModel.Distort(mvLastCam); // Now get the distorted coordinates
+
+  // having the distorted normalized Euclidean coordinates, we can now project on the image (and chache the result in mvLastIm)...
+  mvLastIm[0] = mvCenter[0] + mvFocal[0] * mvLastDistCam[0];
+  mvLastIm[1] = mvCenter[1] + mvFocal[1] * mvLastDistCam[1];
+
+  return mvLastIm;
+}
+
+// Un-project from image pixel coords to the  normalized Euclidean (z=1) camera  plane
+// while storing intermediate calculation results in member variables
+template<class CameraModel>
+inline cv::Vec2f GenericCamera<CameraModel>::UnProject(const cv::Vec2f &v2Im)
+{
+  // store image location
+  mvLastIm = v2Im;
+  // Now unproject to a distorted Euclidean space
+  mvLastDistCam[0] = (mvLastIm[0] - mvCenter[0]) * mvInvFocal[0];
+  mvLastDistCam[1] = (mvLastIm[1] - mvCenter[1]) * mvInvFocal[1];
+  // Now, mvLastDistCam contains the DISTORTED Euclidean coordinates of the imaged point, so we undistort
+  mvLastCam = mModel.Undistort(mvLastDistCam);
+  mdLastR = sqrt(mvLastCam[0] * mvLastCam[0] + mvLastCam[1] * mvLastCam[1]);
+
+  // return undistorted normalized Euclidean coordinates
+  return mvLastCam;
+}
+
+// Utility function for easy drawing with OpenGL
+// C.f. comment in top of this file
+// George:  Creation of frustum matrix to indulge the idiosychracies of OpenGL,
+// which demand that the frsutum be mapped onto the unit cube centered at the origin.
+// GK wants Z+ is in front of the camera (Right-Handed frame)
+template<class CameraModel>
+cv::Mat_<float> GenericCamera<CameraModel>::MakeUFBLinearFrustumMatrix(float near, float far)
+{
+  cv::Mat_<float> m4 = cv::Mat_<float>::zeros(4,4);
+
+  double left = mvImplaneTL[0] * near;
+  double right = mvImplaneBR[0] * near;
+  double top = mvImplaneTL[1] * near;
+  double bottom = mvImplaneBR[1] * near;
+
+  // The openGhelL frustum manpage is A PACK OF LIES!!
+  // Two of the elements are NOT what the manpage says they should be.
+  // Anyway, below code makes a frustum projection matrix
+  // Which projects a RHS-coord frame with +z in front of the camera
+  // Which is what I usually want, instead of glFrustum's LHS, -z idea.
+  m4(0, 0) = (2 * near) / (right - left);
+  m4(1, 1) = (2 * near) / (top - bottom);
+
+  m4(0, 2) = (right + left) / (left - right);
+  m4(1, 2) = (top + bottom) / (bottom - top);
+  m4(2, 2) = (far + near) / (far - near);
+  m4(3, 2) = 1;
+
+  m4(2, 3) = 2*near*far / (near - far);
+
+  return m4;
+};
+
+
+// Compute the derivatives of the projection model wrt the NORMALIZED EUCLIDEAN COORINDATES of the point (i.e., [xe; ye; 1] = [ X/Z ; Y/Z; 1] )
+// in the form (d im1/d cam1, d im1/d cam2)
+//             (d im2/d cam1, d im2/d cam2)
+// This is simply diag(fx, fy) times the Jacobian of the distortion (which is provided by the model)
+// We are reusing the ready-made coordinates of the previous projection!
+template<class CameraModel>
+inline cv::Matx22f GenericCamera<CameraModel>::GetProjectionDerivs()
+{
+  cv::Matx22f m2Derivs = mModel.DistortDerivs(mvLastCam);
+
+  m2Derivs(0, 0) *= mvFocal[0];  m2Derivs(0, 1) *= mvFocal[0];
+  m2Derivs(1, 0) *= mvFocal[1];  m2Derivs(1, 1) *= mvFocal[1];
+
+  return m2Derivs;
+}
+
+// Same as above, but at a given point instead of the last projection
+template<class CameraModel>
+inline cv::Matx22f GenericCamera<CameraModel>::GetProjectionDerivs(const cv::Vec2f &v2Cam)
+{
+  cv::Matx22f m2Derivs = mModel.DistortDerivs(v2Cam);
+
+  m2Derivs(0, 0) *= mvFocal[0];  m2Derivs(0, 1) *= mvFocal[0];
+  m2Derivs(1, 0) *= mvFocal[1];  m2Derivs(1, 1) *= mvFocal[1];
+
+  return m2Derivs;
+}
+
+// Project a whole view at once. Everything the loop needs is copied into locals first:
+// the output (and the validity flags, which are chars) could otherwise alias the members,
+// and the compiler would have to reload the intrinsics and the model coefficients on every point.
+template<class CameraModel>
+void GenericCamera<CameraModel>::ProjectBatch(const float *pfX, const float *pfY, int n, float *pfU, float *pfV, unsigned char *pbValid)
+{
+  const CameraModel Model = mModel;
+  const float fcx = mvCenter[0], fcy = mvCenter[1];
+  const float ffx = mvFocal[0], ffy = mvFocal[1];
+  const float fMaxRSq = mdMaxR * mdMaxR;
+
+  for(int i=0; i<n; i++) {
+    const cv::Vec2f v2Dist = Model.Distort(cv::Vec2f(pfX[i], pfY[i]));
+    pfU[i] = fcx + ffx * v2Dist[0];
+    pfV[i] = fcy + ffy * v2Dist[1];
+  }
+  if(pbValid == NULL) return;
+  // same test as in Project() (mdLastR > mdMaxR), without the square root
+  for(int i=0; i<n; i++)
+    pbValid[i] &= (unsigned char) (pfX[i] * pfX[i] + pfY[i] * pfY[i] <= fMaxRSq);
+}
+
+template<class CameraModel>
+cv::Matx<float, 2, CameraModel::NumParams> GenericCamera<CameraModel>::GetCameraParameterDerivs()
+{
+  // Differentials wrt to the camera parameters
+  // Use these to calibrate the camera
+  // No need for this to be quick, so do them numerically
+
+  cv::Matx<float, 2, CameraModel::NumParams> m2NNumDerivs = cv::Matx<float, 2, CameraModel::NumParams>::zeros();
+  ParamVector vNNormal = *mpvvCameraParams;
+  cv::Vec2f v2Cam = mvLastCam;
+  cv::Vec2f v2Out = Project(v2Cam);
+  for(int i=0; i<CameraModel::NumParams; i++) {
+
+      // skip the computation of the distortion derivatives if distortion is disabled (they remain zero)
+      if(i >= 4 && (!mbDistortionEnabled || !mModel.Enabled()) ) continue;
+
+      // create a vector "vNUpdate" to perturb the i-th camera parameter
+      ParamVector vNUpdate = ParamVector::all(0);
+      vNUpdate[i] += 0.001;
+      // perturb the i-th camera parameter by 0.001.
+      UpdateParams(vNUpdate);
+      // Now project v2Can on the image again
+      cv::Vec2f v2Out_B = Project(v2Cam);
+      // get the difference of the new projection from the original and divide it by the perturbation step
+      // to get the approximation to the ith derivative
+      cv::Vec2f DparamsByDpi = (v2Out_B - v2Out) / 0.001;
+      // And store it in the Jacobian vector
+      m2NNumDerivs(0, i) = DparamsByDpi[0];
+      m2NNumDerivs(1, i) = DparamsByDpi[1];
+
+      *mpvvCameraParams = vNNormal;
+      RefreshParams();
+    }
+  // restoring the cached state of the original projection
+  Project(v2Cam);
+
+  return m2NNumDerivs;
+}
+
+// The numerical camera Jacobian of a whole view (same 0.001 steps as above).
+// The point of doing it per view is that every perturbation of the parameters costs two RefreshParams()
+// (which un-project a few image points; iteratively for the radial-tangential model), so these
+// are now paid NumParams times per view instead of NumParams times per grid corner.
+template<class CameraModel>
+void GenericCamera<CameraModel>::GetCameraParameterDerivs(const float *pfX, const float *pfY, const float *pfU, const float *pfV, int n,
+							  float *pfDU, float *pfDV)
+{
+  std::vector<float> vfU_B(n), vfV_B(n);
+  ParamVector vNNormal = *mpvvCameraParams;
+  for(int i=0; i<CameraModel::NumParams; i++) {
+
+      float *pfDUi = pfDU + i * n, *pfDVi = pfDV + i * n;
+      // the distortion derivatives stay zero if distortion is disabled
+      if(i >= 4 && (!mbDistortionEnabled || !mModel.Enabled()) ) {
+	std::fill(pfDUi, pfDUi + n, 0.0f);
+	std::fill(pfDVi, pfDVi + n, 0.0f);
+	continue;
+      }
+
+      ParamVector vNUpdate = ParamVector::all(0);
+      vNUpdate[i] += 0.001;
+      UpdateParams(vNUpdate);
+      if(n > 0) ProjectBatch(pfX, pfY, n, &vfU_B[0], &vfV_B[0]);
+      for(int k=0; k<n; k++) {
+	pfDUi[k] = (vfU_B[k] - pfU[k]) / 0.001f;
+	pfDVi[k] = (vfV_B[k] - pfV[k]) / 0.001f;
+      }
+
+      *mpvvCameraParams = vNNormal;
+      RefreshParams();
+    }
+}
+
+// Just perturb the vector of camera parameters by a vector "vUpdate"
+template<class CameraModel>
+void GenericCamera<CameraModel>::UpdateParams(const ParamVector &vUpdate)
+{
+  // Update the camera parameters; use this as part of camera calibration.
+  (*mpvvCameraParams) = (*mpvvCameraParams) + vUpdate;
+
+  RefreshParams();
+}
+
+// Overwrite the camera parameters (e.g., with a closed-form initial estimate)
+template<class CameraModel>
+void GenericCamera<CameraModel>::SetParams(const ParamVector &vParams)
+{
+  (*mpvvCameraParams) = vParams;
+
+  RefreshParams();
+}
+
+template<class CameraModel>
+void GenericCamera<CameraModel>::DisableRadialDistortion()
+{
+  // Set the distortion parameters to zero
+  // This disables distortion and also disables its differentials
+  CameraModel::ZeroDistortion(*mpvvCameraParams);
+  mbDistortionEnabled = false;
+  RefreshParams();
+}
+
+template<class CameraModel>
+void GenericCamera<CameraModel>::EnableRadialDistortion()
+{
+  // Lets the distortion differentials back in (the parameters themselves start from wherever they are)
+  mbDistortionEnabled = true;
+}
+
+
+/// Project a 2D point on the normalized EUclidean plane onto the OpenGL frustum near plane.
+/// In other words, instead of image coordinates, we use [-1, 1] x [-1, 1]
+// Here we simply need to use the normalized intrinsic parameters directly.
+// Other than that, this the exact same projection function with "Project"
+template<class CameraModel>
+cv::Vec2f GenericCamera<CameraModel>::UFBProject(const cv::Vec2f &vCam)
+{
+  // Project from camera z=1 plane to UFB, storing intermediate calc results.
+  mvLastCam = vCam;
+  mdLastR = cv::norm(vCam);
+  mbInvalid = (mdLastR > mdMaxR);
+  mvLastDistCam = mModel.Distort(mvLastCam);
+
+  mvLastIm[0] = (*mpvvCameraParams)[2]  + (*mpvvCameraParams)[0] * mvLastDistCam[0];
+  mvLastIm[1] = (*mpvvCameraParams)[3]  + (*mpvvCameraParams)[1] * mvLastDistCam[1];
+  return mvLastIm;
+}
+
+/// Unproject from the openGL "near" plane onto the normalized Euclidean plane.
+// This is exactly the same as "Unproject", only instead of image coordinates we have [-1, 1] x [-1, 1] on
+// the "near" plane of the openGL frustum (hence the use of normalized intrinsics).
+template<class CameraModel>
+cv::Vec2f GenericCamera<CameraModel>::UFBUnProject(const cv::Vec2f &v2Im)
+{
+  mvLastIm = v2Im;
+  mvLastDistCam[0] = (mvLastIm[0] - (*mpvvCameraParams)[2]) / (*mpvvCameraParams)[0];
+  mvLastDistCam[1] = (mvLastIm[1] - (*mpvvCameraParams)[3]) / (*mpvvCameraParams)[1];
+  mvLastCam = mModel.Undistort(mvLastDistCam);
+  mdLastR = cv::norm(mvLastCam);
+  return mvLastCam;
+}
+
+// Some inline projection functions:
+template<class CameraModel>
+inline cv::Vec2f GenericCamera<CameraModel>::UFBLinearProject(const cv::Vec2f &camframe)
+{
+  cv::Vec2f v2Res;
+  v2Res[0] = camframe[0] * mvUFBLinearFocal[0] + mvUFBLinearCenter[0];
+  v2Res[1] = camframe[1] * mvUFBLinearFocal[1] + mvUFBLinearCenter[1];
+  return v2Res;
+}
+
+template<class CameraModel>
+inline cv::Vec2f GenericCamera<CameraModel>::UFBLinearUnProject(const cv::Vec2f &fbframe)
+{
+  cv::Vec2f v2Res;
+  v2Res[0] = (fbframe[0] - mvUFBLinearCenter[0]) * mvUFBLinearInvFocal[0];
+  v2Res[1] = (fbframe[1] - mvUFBLinearCenter[1]) * mvUFBLinearInvFocal[1];
+  return v2Res;
+}
+
+
+// The three models we calibrate for
+typedef GenericCamera<ATANModel> ATANCamera;
+typedef GenericCamera<RadTanModel> RadTanCamera;
+typedef GenericCamera<FisheyeModel> FisheyeCamera;
+
+
+#endif
@@ -99,6 +99,47 @@ namespace Persistence
 		return I().parseArguments(argc, argv, start, prefix, execKeyword);
 	}
 
+	void GUI::RegisterTypedCallback(std::string sCommandName, const TypedCallbackInfoStruct& s)
+	{
+		I().RegisterTypedCommand(sCommandName, s);
+	}
+
+	GUICommandHandle GUI::Resolve(std::string sCommandName, std::string sParams)
+	{
+		return I().Resolve(sCommandName, sParams);
+	}
+
+
+	// ***************** Command handles ********************
+
+	GUICommandHandle::GUICommandHandle() : mnVersion(0), mpCallbacks(NULL), mpTypedCallbacks(NULL)
+	{
+	}
+
+	void GUICommandHandle::Refresh() const
+	{
+		GUI::I().Refresh(*this);
+	}
+
+	bool GUICommandHandle::Valid() const
+	{
+		Refresh();
+		return (mpCallbacks && !mpCallbacks->empty()) || (mpTypedCallbacks && !mpTypedCallbacks->empty());
+	}
+
+	void GUICommandHandle::operator()() const
+	{
+		InvokeWithParams(msParams);
+	}
+
+	void GUICommandHandle::InvokeWithParams(const std::string& sParams) const
+	{
+		Refresh();
+		// indices rather than iterators: a callback may unregister commands
+		for(unsigned int i=0; mpCallbacks && i < mpCallbacks->size(); i++)
+		  (*mpCallbacks)[i].cbp((*mpCallbacks)[i].thisptr, msCommand, sParams);
+	}
+
 
 
 
@@ -156,6 +197,8 @@ namespace Persistence
   void GUI_impl::UnRegisterCommand(string sCommandName)
   {
     mmCallBackMap.erase(sCommandName);
+    mmTypedCallBackMap.erase(sCommandName);
+    mnRegistrationVersion++;
   };
 
   // unregister all commands from the same GUI object
@@ -163,6 +206,8 @@ namespace Persistence
   {
     for(map<string, CallbackVector>::iterator i=mmCallBackMap.begin(); i!=mmCallBackMap.end(); i++)
       UnRegisterCommand(i->first, thisptr);
+    for(map<string, TypedCallbackVector>::iterator i=mmTypedCallBackMap.begin(); i!=mmTypedCallBackMap.end(); i++)
+      UnRegisterCommand(i->first, thisptr);
   };
   
   // unrtegister command from a specific GUI (thisptr)
@@ -171,6 +216,12 @@ namespace Persistence
     CallbackVector &cbv = mmCallBackMap[sCommandName];
     for(int i = static_cast<int>(cbv.size()) - 1; i>=0; i--)
       if(cbv[i].thisptr == thisptr) cbv.erase(cbv.begin() + i);
+    
+    map<string, TypedCallbackVector>::iterator t = mmTypedCallBackMap.find(sCommandName);
+    if(t != mmTypedCallBackMap.end())
+      for(int i = static_cast<int>(t->second.size()) - 1; i>=0; i--)
+	if(t->second[i].thisptr == thisptr) t->second.erase(t->second.begin() + i);
+    mnRegistrationVersion++;
   };
 
   // Ok, this is how we register a "GUI command" by entering the callback 
@@ -200,8 +251,43 @@ namespace Persistence
 
       // ok, callback not in the map. Insert it.
     if(!bAlreadyThere) cbv->push_back(s);
+    mnRegistrationVersion++;
   };
 
+  // Typed callbacks live in their own map; handles invoked with an argument of the same type call them directly
+  void GUI_impl::RegisterTypedCommand(string sCommandName, const TypedCallbackInfoStruct& s)
+  {
+    if(builtins.count(sCommandName))
+      {
+	cerr << "!!GUI_impl::RegisterTypedCommand: Tried to register reserved keyword " << sCommandName << "." << endl;
+	return;
+      }
+    mmTypedCallBackMap[sCommandName].push_back(s);
+    mnRegistrationVersion++;
+  }
+
+  // All the string work of a command line, done once: the (uncommented) command name and its parameters
+  GUICommandHandle GUI_impl::Resolve(string sCommandName, string sParams)
+  {
+    GUICommandHandle h;
+    h.msCommand = UncommentString(sCommandName);
+    h.msParams = sParams;
+    Refresh(h);
+    return h;
+  }
+
+  // The callback vectors are map nodes, which stay put until their command is unregistered (which bumps the version)
+  void GUI_impl::Refresh(const GUICommandHandle& h)
+  {
+    if(h.mnVersion == mnRegistrationVersion) return;
+    
+    map<string, CallbackVector>::const_iterator i = mmCallBackMap.find(h.msCommand);
+    h.mpCallbacks = i == mmCallBackMap.end() ? NULL : &i->second;
+    map<string, TypedCallbackVector>::const_iterator t = mmTypedCallBackMap.find(h.msCommand);
+    h.mpTypedCallbacks = t == mmTypedCallBackMap.end() ? NULL : &t->second;
+    h.mnVersion = mnRegistrationVersion;
+  }
+
 
   // Checks (by name) and executes callbacks returns true; return false otherwise...
   bool GUI_impl::CallCallbacks(string sCommand, string sParams)
@@ -737,6 +823,7 @@ namespace Persistence
 
   GUI_impl::GUI_impl()
   {
+    mnRegistrationVersion = 1; // (default constructed handles are at 0)
     do_builtins();
 	lang=0;
   }
@@ -7,6 +7,8 @@
 #include <vector>
 #include <iostream>
 #include <set>
+#include <functional>
+#include <typeinfo>
 
 namespace Persistence
 {
@@ -25,11 +27,71 @@ namespace Persistence
 
 	typedef std::vector<CallbackInfoStruct> CallbackVector;
 
+	// A typed callback: receives its argument as a T (the type is recorded so that invocations can be matched to it),
+	// so that the command target does no string parsing at all. See GUI::RegisterTypedCommand.
+	typedef struct
+	{
+	  std::function<void(const void*)> proc; // calls the registered function with *(const T*)
+	  void* thisptr;
+	  const std::type_info* type;
+	} TypedCallbackInfoStruct;
+
+	typedef std::vector<TypedCallbackInfoStruct> TypedCallbackVector;
+
+
+	class GUI_impl;
+
+	// A command resolved once (see GUI::Resolve), for calls on the hot path:
+	// Invoking the handle calls the command's callbacks directly with the parameters given at resolution
+	// (no uncommenting, no brace expansion, no splitting, no map lookups). The typed form, handle(arg), calls the typed
+	// callbacks registered for the type of arg, and only falls back to the string callbacks (with arg serialized)
+	// if there are none. If commands are (un)registered in the meantime, the handle looks the command up again on its next use.
+	class GUICommandHandle
+	{
+		public:
+			GUICommandHandle();
+
+			/// True if the command has any callbacks (string or typed)
+			bool Valid() const;
+			
+			/// Call the string callbacks with the parameters bound at resolution
+			void operator()() const;
+			
+			/// Call the typed callbacks for T with arg (or the string callbacks with arg serialized if there are none for T)
+			template<class T> void operator()(const T& arg) const
+			{
+				Refresh();
+				bool bTyped = false;
+				// indices rather than iterators: a callback may unregister commands
+				for(unsigned int i=0; mpTypedCallbacks && i < mpTypedCallbacks->size(); i++)
+				  if(*(*mpTypedCallbacks)[i].type == typeid(T)) {
+				    
+				    (*mpTypedCallbacks)[i].proc(&arg);
+				    bTyped = true;
+				  }
+				if(!bTyped)
+				  InvokeWithParams(Serialize::to_string(arg, false));
+			}
+			
+			const std::string& Command() const { return msCommand; }
+
+		private:
+			friend class GUI_impl;
+			void Refresh() const;
+			void InvokeWithParams(const std::string& sParams) const;
+
+			std::string msCommand;
+			std::string msParams;
+			mutable unsigned int mnVersion; // registration version the pointers below were taken at
+			mutable const CallbackVector* mpCallbacks;
+			mutable const TypedCallbackVector* mpTypedCallbacks;
+	};
+
 
 	// GUI_impl is essentially a class with all the GUI operation,
 	// While the GUI class can be actually spawned in many different threads.
 	// So, each many GUI instantiations can potentially share a single GUI_impl object. 
-	class GUI_impl;
+	// (declared above)
 
 	
 	class GUI
@@ -48,6 +110,18 @@ namespace Persistence
 			void UnRegisterCommand(std::string sCommandName, void* thisptr);
 			/// Unregister command by name regardless of GUI object
 			void UnRegisterCommand(std::string sCommandName);
+			/// Register a typed callback for a command: handles invoked with a T call it directly.
+			/// (String invocations, e.g. from ParseLine or the console, still go to the string callbacks only.)
+			template<class T> void RegisterTypedCommand(std::string sCommandName, void (*callback)(void* thisptr, const T& arg), void* thisptr=NULL)
+			{
+				TypedCallbackInfoStruct s;
+				s.proc = [callback, thisptr](const void* pArg) { callback(thisptr, *static_cast<const T*>(pArg)); };
+				s.thisptr = thisptr;
+				s.type = &typeid(T);
+				RegisterTypedCallback(sCommandName, s);
+			}
+			/// Resolve a command (and its parameters) once, for repeated invocation without parsing
+			GUICommandHandle Resolve(std::string sCommandName, std::string sParams = "");
 			// Thisd is the function that parses lines in configuration files - Awsome work by Rosten!
 			void ParseLine(std::string s, bool bSilentFailure = false);
 			// Parse a configuration file stream, line-by-line
@@ -76,6 +150,9 @@ namespace Persistence
 			/// @arg execKeyword keyword to use to trigger execution of the file given as parameter with LoadFile
 			/// @return
 			int parseArguments( const int argc, char * argv[], int start = 1, const std::string prefix = "--", const std::string execKeyword = "exec" );
+			
+		private:
+			void RegisterTypedCallback(std::string sCommandName, const TypedCallbackInfoStruct& s);
 	};
 
 }
@@ -50,6 +50,11 @@ namespace Persistence
 			bool CallCallbacks(std::string sCommand, std::string sParams);
 			void SetupReadlineCompletion();
 			
+			void RegisterTypedCommand(std::string sCommandName, const TypedCallbackInfoStruct& s);
+			GUICommandHandle Resolve(std::string sCommandName, std::string sParams);
+			// Points the handle to the current callbacks of its command
+			void Refresh(const GUICommandHandle& h);
+			
 
 			/// Start a thread which parses user input from the console.
 			/// Uses libreadline if configured, or just plain old iostream readline
@@ -89,6 +94,8 @@ namespace Persistence
 			GUI_language* lang;
 
 			std::map<std::string, CallbackVector > mmCallBackMap;
+			std::map<std::string, TypedCallbackVector > mmTypedCallBackMap;
+			unsigned int mnRegistrationVersion; // bumped on every (un)registration, so that handles know when to look up again
 			std::set<std::string> builtins;
 			std::map<std::string, std::vector<std::string> > mmQueues;
 
@@ -33,6 +33,7 @@ namespace Persistence
 
 	string PV3::get_var(string name)
 	{
+		lock_guard<mutex> lock(registry_mutex());
 		if(registered_type_and_trait.count(name))
 			return registered_type_and_trait[name].first->get_as_string(name, 0);
 		else if(unmatched_tags.count(name))
@@ -43,6 +44,7 @@ namespace Persistence
 
 	bool PV3::set_var(string name, string val, bool silent)
 	{
+		lock_guard<mutex> lock(registry_mutex());
 		if(registered_type_and_trait.count(name))
 		{
 			int e = registered_type_and_trait[name].first->set_from_string(name, val);
@@ -60,6 +62,7 @@ namespace Persistence
         void PV3::print_var_list(ostream &o, string pattern, bool show_all)
 	{
 	        bool no_pattern = (pattern=="");
+	        lock_guard<mutex> lock(registry_mutex());
 
 	        if(show_all) o << "//Registered persistent variables:" << endl;
 		
@@ -91,6 +94,7 @@ namespace Persistence
 	
 	vector<string> PV3::tag_list()
 	{
+		lock_guard<mutex> lock(registry_mutex());
 		vector<string> v;
 		for(map<string, std::pair<BaseMap*, int> >::iterator i=registered_type_and_trait.begin(); i != registered_type_and_trait.end(); i++)
 			v.push_back(i->first);
@@ -8,6 +8,9 @@
 #include <vector>
 #include <iostream>
 #include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
 
 #include "default.h"
 #include "type_name.h"
@@ -50,6 +53,7 @@ class BaseMap
 
 template<class T> class pvar2 // correspondes to gvar2
 {
+	protected:
 	ValueHolder<T>* data;
 	
 	friend class PV3;
@@ -80,6 +84,18 @@ template<class T> class pvar2 // correspondes to gvar2
 		{
 			return data!=NULL;
 		}
+		
+		// Assign through the holder, so that the change shows in the version counter 
+		// (assigning through operator*() changes the value "silently")
+		void set(const T& t)
+		{
+			data->set(t);
+		}
+		
+		unsigned int Version() const
+		{
+			return data->version.load(std::memory_order_acquire);
+		}
 
 	
 };
@@ -113,6 +129,61 @@ template<> class pvar3<std::string>: public pvar2<std::string>
 	inline pvar3(){};
 };
 
+// A pvar3 for hot paths (per frame or per pixel reads). It keeps its own copy of the value and re-reads the 
+// registered one only when its version counter has moved, so a read costs an atomic load and a compare
+// (no map lookups, no locks, and no torn values if another thread, e.g. the console, sets the variable meanwhile).
+// Changed() says (once per change) that there is a new value, so that whatever depends on it can be rebuilt only then.
+// Plain (trivially copyable) types only, and one object per reading thread (the cached copy is not shared).
+template<class T> class pvar3_cached: public pvar3<T>
+{
+	static_assert(std::is_trivially_copyable<T>::value, "pvar3_cached copies the value without locks; use pvar3 for this type");
+	
+	mutable T mCached;
+	mutable unsigned int mnVersion; // the version of mCached (odd, i.e. never valid, before the first read)
+	unsigned int mnSeenVersion;     // the version last reported by Changed()
+	
+	void Refresh(unsigned int v) const
+	{
+		for(;;) {
+		  if(v & 1) { // a set() is under way; it is a plain assignment, so it won't be long
+		    v = this->data->version.load(std::memory_order_acquire);
+		    continue;
+		  }
+		  T t = this->data->get();
+		  std::atomic_thread_fence(std::memory_order_acquire);
+		  unsigned int v2 = this->data->version.load(std::memory_order_relaxed);
+		  if(v2 == v) {
+		    mCached = t;
+		    mnVersion = v;
+		    return;
+		  }
+		  v = v2; // changed while copying; go again
+		}
+	}
+	
+	public:
+	pvar3_cached(const std::string &name, const T &default_val = T(), int flags = 0) 
+	  : pvar3<T>(name, default_val, flags), mCached(default_val), mnVersion(1), mnSeenVersion(1) {}
+	
+	const T& value() const
+	{
+		unsigned int v = this->data->version.load(std::memory_order_acquire);
+		if(v != mnVersion) Refresh(v);
+		return mCached;
+	}
+	
+	const T& operator*() const { return value(); }
+	
+	// True on the first call and then after each change of the value (through set(), the console or a config file)
+	bool Changed()
+	{
+		value();
+		if(mnVersion == mnSeenVersion) return false;
+		mnSeenVersion = mnVersion;
+		return true;
+	}
+};
+
 class PV3
 {
 	private:
@@ -256,10 +327,20 @@ class PV3
 		static std::map<std::string, std::string>		unmatched_tags;
 		static std::map<std::string, std::pair<BaseMap*, int> >	registered_type_and_trait;
 		static std::list<BaseMap*>				maps;
+		
+		// The maps above are looked up and inserted into by whoever registers a variable (detection workers too)
+		// and by the console thread, so all of that goes through this lock. The values themselves are not locked
+		// (see ValueHolder and pvar3_cached).
+		static std::mutex& registry_mutex()
+		{
+			static std::mutex m;
+			return m;
+		}
 
 		
 		template<class T> static ValueHolder<T>* get_by_val(const std::string& name, const T& default_val, int flags) {
 	
+		  std::lock_guard<std::mutex> lock(registry_mutex());
 		  ValueHolder<T>* d = attempt_get<T>(name);
 		  if(d)
 		    return d;
@@ -269,6 +350,7 @@ class PV3
 		
 		template<class T> static ValueHolder<T>* get_by_str(const std::string &name, const std::string &default_val, int flags) {
 	
+		  std::lock_guard<std::mutex> lock(registry_mutex());
 		  ValueHolder<T>* d = attempt_get<T>(name);
 		  if(d) return d;
 		  else {
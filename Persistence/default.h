@@ -6,6 +6,7 @@
 #define PER_DEFAULT_H
 
 #include <memory> 
+#include <atomic>
 #include "../OpenCV.h"
 
 namespace Persistence
@@ -140,11 +141,16 @@ template<typename P, int C>  struct DefaultValue<CvMatrixWrapper<P, -1, C> > {
 
 // If I am not mistaken the ValueHolder should work for openCV Vector templates, 
 // BUT(!!!!): For OpenCV matrices we MUST use the CvMatrixWrapper struct!!!!!!!!
+//
+// Every holder carries a version counter which set() bumps (by 2, going odd while the value is being written),
+// so that cached readers (pvar3_cached in PVars.h) can tell cheaply whether the value changed, and copy it
+// without locks (seqlock style). Writes through the references returned by get()/ptr() do NOT bump it.
 template<class C, int PainInTheNeck = IsAwkward<C>::is> struct ValueHolder {
   
 	typedef typename DefaultValue<C>::Type T;
 	
 	T val;
+	std::atomic<unsigned int> version; // even: stable, odd: a set() is under way
 	
 	T& get() 
 	{ 
@@ -156,11 +162,17 @@ template<class C, int PainInTheNeck = IsAwkward<C>::is> struct ValueHolder {
 		return val; 
 	}
 
-	ValueHolder(const T& c) :val(c) {}
+	ValueHolder(const T& c) :val(c), version(0) {}
+	
+	ValueHolder(const ValueHolder& c) :val(c.val), version(c.version.load()) {}
 
 	void set(const T& c)
 	{
+		unsigned int v = version.load(std::memory_order_relaxed);
+		version.store(v + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
 		val = c;
+		version.store(v + 2, std::memory_order_release);
 	}
 
 	T* ptr() { return &val; }
@@ -173,6 +185,7 @@ template<class C> struct ValueHolder<C, 1>
 	typedef typename DefaultValue<C>::Type T;
 	
 	std::unique_ptr<T> val; // pointer to the object (instead of a standard variable)
+	std::atomic<unsigned int> version; // see above (no lock-free copies of these though; they are not plain data)
 
 	T& get()
 	{ 
@@ -183,18 +196,19 @@ template<class C> struct ValueHolder<C, 1>
 		return *val; 
 	}
 
-	ValueHolder() : val( new T(DefaultValue<C>::val() )) 
+	ValueHolder() : val( new T(DefaultValue<C>::val() )), version(0) 
 	{}
 
-	ValueHolder(const ValueHolder& c) :val( new T(c.get()) )
+	ValueHolder(const ValueHolder& c) :val( new T(c.get()) ), version(c.version.load())
 	{}
 
-	ValueHolder(const T& c) :val(new T(c) )
+	ValueHolder(const T& c) :val(new T(c) ), version(0)
 	{}
 
 	void set(const T& c)
 	{
 		val = std::unique_ptr<T>(new T(c));
+		version.fetch_add(2, std::memory_order_release);
 	}
 
 	T* ptr()
@@ -0,0 +1,273 @@
+// George Terzakis 2016 - University of Portsmouth
+
+#include "Profiling.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+namespace Profiling {
+
+  // The values of one stage in one thread. Only the owner thread writes a value and then moves nCount on
+  // (release); a reader takes nCount (acquire) and reads the values before it. A value may be overwritten while
+  // it is being read (if the owner laps the ring meanwhile), but it is still a value of the stage.
+  struct StageRing
+  {
+    atomic<uint64_t> nCount;      // values ever recorded
+    atomic<uint64_t> nResetAt;    // nCount at the last Reset() (written by the readers)
+    atomic<uint64_t> anValues[WINDOW];
+  };
+
+  struct TraceRecord
+  {
+    uint64_t nTime;    // ns (steady clock)
+    uint64_t nValue;   // end time for timers, the value for counters
+    int nStage;
+  };
+
+  // Everything a thread records. These are never freed: a thread that is gone leaves its numbers behind
+  // (so the statistics do not lose the work of short-lived threads), at the cost of one buffer per thread ever started.
+  struct ThreadBuffers
+  {
+    int nThreadId;
+    StageRing aRings[MAX_STAGES];
+
+    // The trace: the owner thread starts over when it sees that a new trace has started (generation)
+    atomic<uint32_t> nTraceGeneration;
+    atomic<uint32_t> nTraceSize;
+    atomic<uint64_t> nTraceDropped;
+    TraceRecord *pTrace;  // TRACE_CAPACITY records, allocated by the owner on its first trace event
+  };
+
+  static mutex gRegistryMutex;             // stage and thread registration only (once per stage and thread)
+  static const Stage* gapStages[MAX_STAGES];
+  static atomic<int> gnStages(0);
+  static vector<ThreadBuffers*> gvpThreads;
+
+  static atomic<bool> gbTracing(false);
+  static atomic<uint32_t> gnTraceGeneration(0);
+  static atomic<uint64_t> gnTraceStartNs(0);
+
+  static thread_local ThreadBuffers *tlpBuffers = NULL;
+
+  static ThreadBuffers& MyBuffers()
+  {
+    if(tlpBuffers == NULL) {
+      ThreadBuffers *pBuffers = new ThreadBuffers;
+      for(int i=0; i<MAX_STAGES; i++) {
+	pBuffers->aRings[i].nCount = 0;
+	pBuffers->aRings[i].nResetAt = 0;
+      }
+      pBuffers->nTraceGeneration = 0;
+      pBuffers->nTraceSize = 0;
+      pBuffers->nTraceDropped = 0;
+      pBuffers->pTrace = NULL;
+      lock_guard<mutex> lock(gRegistryMutex);
+      pBuffers->nThreadId = gvpThreads.size() + 1;
+      gvpThreads.push_back(pBuffers);
+      tlpBuffers = pBuffers;
+    }
+    return *tlpBuffers;
+  }
+
+  // A copy of the list of threads (they are only ever added)
+  static vector<ThreadBuffers*> AllThreads()
+  {
+    lock_guard<mutex> lock(gRegistryMutex);
+    return gvpThreads;
+  }
+
+
+  Stage::Stage(const char *szName, StageKind eKind) : mszName(szName), meKind(eKind), mnIndex(-1)
+  {
+    lock_guard<mutex> lock(gRegistryMutex);
+    int n = gnStages.load();
+    if(n >= MAX_STAGES) {
+      cout << "! Profiling: too many stages; " << szName << " will not be recorded (raise MAX_STAGES)." << endl;
+      return;
+    }
+    mnIndex = n;
+    gapStages[n] = this;
+    gnStages.store(n + 1, memory_order_release);
+  }
+
+  static void Record(const Stage &stage, uint64_t nTime, uint64_t nValue);
+
+  void Stage::Add(uint64_t nValue) const
+  {
+    if(mnIndex < 0) return;
+    StageRing &ring = MyBuffers().aRings[mnIndex];
+    uint64_t nCount = ring.nCount.load(memory_order_relaxed);
+    ring.anValues[nCount % WINDOW].store(nValue, memory_order_relaxed);
+    ring.nCount.store(nCount + 1, memory_order_release);
+
+    // (timers log their intervals themselves, see ScopedTimer)
+    if(meKind == COUNTER && Tracing()) Record(*this, NowNs(), nValue);
+  }
+
+
+  bool Tracing() { return gbTracing.load(memory_order_relaxed); }
+
+  void TraceEvent(const Stage &stage, uint64_t nStartNs, uint64_t nEndNs)
+  {
+    Record(stage, nStartNs, nEndNs);
+  }
+
+  static void Record(const Stage &stage, uint64_t nTime, uint64_t nValue)
+  {
+    if(stage.Index() < 0) return;
+    ThreadBuffers &buffers = MyBuffers();
+    uint32_t nGeneration = gnTraceGeneration.load(memory_order_acquire);
+    if(buffers.nTraceGeneration.load(memory_order_relaxed) != nGeneration) {
+      if(buffers.pTrace == NULL) buffers.pTrace = new TraceRecord[TRACE_CAPACITY];
+      buffers.nTraceSize.store(0, memory_order_relaxed);
+      buffers.nTraceDropped.store(0, memory_order_relaxed);
+      buffers.nTraceGeneration.store(nGeneration, memory_order_release);
+    }
+    uint32_t nSize = buffers.nTraceSize.load(memory_order_relaxed);
+    if(nSize >= (uint32_t) TRACE_CAPACITY) {
+      buffers.nTraceDropped.store(buffers.nTraceDropped.load(memory_order_relaxed) + 1, memory_order_relaxed);
+      return;
+    }
+    TraceRecord &rec = buffers.pTrace[nSize];
+    rec.nTime = nTime;
+    rec.nValue = nValue;
+    rec.nStage = stage.Index();
+    buffers.nTraceSize.store(nSize + 1, memory_order_release);
+  }
+
+
+  // The values of stage n (all threads) since the last reset, within the window
+  static void CollectValues(int n, vector<uint64_t> &vValues)
+  {
+    vValues.clear();
+    vector<ThreadBuffers*> vpThreads = AllThreads();
+    for(unsigned int t=0; t<vpThreads.size(); t++) {
+      StageRing &ring = vpThreads[t]->aRings[n];
+      uint64_t nCount = ring.nCount.load(memory_order_acquire);
+      uint64_t nResetAt = ring.nResetAt.load(memory_order_relaxed);
+      uint64_t nValues = nCount > nResetAt ? std::min(nCount - nResetAt, (uint64_t) WINDOW) : 0;
+      for(uint64_t i=0; i<nValues; i++)
+	vValues.push_back(ring.anValues[(nCount - 1 - i) % WINDOW].load(memory_order_relaxed));
+    }
+    sort(vValues.begin(), vValues.end());
+  }
+
+  static double Percentile(const vector<uint64_t> &vSorted, double dFraction)
+  {
+    size_t i = std::min(vSorted.size() - 1, (size_t) (dFraction * vSorted.size()));
+    return vSorted[i];
+  }
+
+  std::string Report()
+  {
+    ostringstream ost;
+    ost << left << setw(28) << "Stage" << right << setw(8) << "n" << setw(10) << "mean" << setw(10) << "p50"
+	<< setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << "   (ms, or counts)" << endl;
+    ost << fixed;
+    vector<uint64_t> vValues;
+    int nStages = gnStages.load(memory_order_acquire);
+    for(int n=0; n<nStages; n++) {
+      CollectValues(n, vValues);
+      if(vValues.empty()) continue;
+      double dScale = gapStages[n]->Kind() == TIMER ? 1e-6 : 1.0;
+      double dSum = 0;
+      for(unsigned int i=0; i<vValues.size(); i++) dSum += vValues[i];
+      ost << left << setw(28) << gapStages[n]->Name() << right << setw(8) << vValues.size() << setprecision(3)
+	  << setw(10) << dScale * dSum / vValues.size()
+	  << setw(10) << dScale * Percentile(vValues, 0.5)
+	  << setw(10) << dScale * Percentile(vValues, 0.9)
+	  << setw(10) << dScale * Percentile(vValues, 0.99)
+	  << setw(10) << dScale * vValues.back() << endl;
+    }
+    return ost.str();
+  }
+
+  std::string Overlay()
+  {
+    ostringstream ost;
+    ost << fixed << setprecision(2);
+    vector<uint64_t> vValues;
+    int nStages = gnStages.load(memory_order_acquire), nOnLine = 0;
+    for(int n=0; n<nStages; n++) {
+      if(gapStages[n]->Kind() != TIMER) continue;
+      CollectValues(n, vValues);
+      if(vValues.empty()) continue;
+      // two stages per line
+      ost << (nOnLine == 0 ? "" : "    ") << gapStages[n]->Name() << " " << 1e-6 * Percentile(vValues, 0.5)
+	  << "/" << 1e-6 * Percentile(vValues, 0.9) << "ms";
+      if(++nOnLine == 2) { ost << endl; nOnLine = 0; }
+    }
+    if(nOnLine != 0) ost << endl;
+    return ost.str();
+  }
+
+  void Reset()
+  {
+    vector<ThreadBuffers*> vpThreads = AllThreads();
+    for(unsigned int t=0; t<vpThreads.size(); t++)
+      for(int n=0; n<MAX_STAGES; n++)
+	vpThreads[t]->aRings[n].nResetAt.store(vpThreads[t]->aRings[n].nCount.load(memory_order_acquire), memory_order_relaxed);
+  }
+
+
+  void StartTrace()
+  {
+    gnTraceStartNs = NowNs();
+    gnTraceGeneration.fetch_add(1, memory_order_acq_rel);
+    gbTracing = true;
+    cout << "Profiling: tracing (up to " << TRACE_CAPACITY << " events per thread)." << endl;
+  }
+
+  void StopTrace()
+  {
+    gbTracing = false;
+  }
+
+  bool DumpTrace(const std::string &sFileName)
+  {
+    ofstream ofs(sFileName.c_str());
+    if(!ofs.good()) {
+      cout << "! Could not open " << sFileName << " for writing." << endl;
+      return false;
+    }
+    // Chrome trace events: complete events ("X") for the timers and counter events ("C"), in microseconds
+    uint32_t nGeneration = gnTraceGeneration.load(memory_order_acquire);
+    uint64_t nStartNs = gnTraceStartNs.load();
+    vector<ThreadBuffers*> vpThreads = AllThreads();
+    uint64_t nEvents = 0, nDropped = 0;
+    ofs << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << fixed << setprecision(3);
+    for(unsigned int t=0; t<vpThreads.size(); t++) {
+      ThreadBuffers &buffers = *vpThreads[t];
+      if(buffers.nTraceGeneration.load(memory_order_acquire) != nGeneration || nGeneration == 0) continue;
+      uint32_t nSize = buffers.nTraceSize.load(memory_order_acquire);
+      nDropped += buffers.nTraceDropped.load(memory_order_relaxed);
+      for(uint32_t i=0; i<nSize; i++) {
+	const TraceRecord &rec = buffers.pTrace[i];
+	const Stage &stage = *gapStages[rec.nStage];
+	ofs << (nEvents++ == 0 ? "\n" : ",\n") << "{\"name\": \"" << stage.Name() << "\", \"cat\": \"gcalibrator\", \"pid\": 1, \"tid\": "
+	    << buffers.nThreadId << ", \"ts\": " << 1e-3 * (double) (int64_t) (rec.nTime - nStartNs);
+	if(stage.Kind() == TIMER) ofs << ", \"ph\": \"X\", \"dur\": " << 1e-3 * (rec.nValue - rec.nTime) << "}";
+	else ofs << ", \"ph\": \"C\", \"args\": {\"value\": " << rec.nValue << "}}";
+      }
+    }
+    ofs << "\n]}\n";
+    ofs.close();
+    if(ofs.fail()) {
+      cout << "! Failed writing " << sFileName << endl;
+      return false;
+    }
+    cout << "Profiling: " << nEvents << " trace events written to " << sFileName;
+    if(nDropped > 0) cout << " (" << nDropped << " dropped: the trace buffers were full)";
+    cout << endl;
+    return true;
+  }
+
+} // namespace Profiling
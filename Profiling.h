@@ -0,0 +1,106 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+//
+// Per-stage timers and counters, always compiled in.
+//
+// A stage is a named static object, declared next to the code it measures:
+//
+//     static Profiling::Stage gStageBlur("MakeFromImage.Blur");
+//     { Profiling::ScopedTimer timer(gStageBlur); ... }
+//
+//     static Profiling::Stage gStageCandidates("MakeFromImage.Candidates", Profiling::COUNTER);
+//     gStageCandidates.Add(mvCorners.size());
+//
+// Every thread records into its own buffers (nothing is shared on the recording side, so there are no locks and no
+// atomic read-modify-writes): for each stage, the last WINDOW values (durations in nanoseconds, or counts) in a ring.
+// Anyone can read the rings at any time, which gives the rolling statistics (percentiles over the last WINDOW values
+// of every thread) of Report() and Overlay().
+//
+// While tracing is on (StartTrace), the timers also log every interval as a Chrome trace event (per thread,
+// up to TRACE_CAPACITY events), and DumpTrace writes them in the JSON format of chrome://tracing and Perfetto.
+
+#ifndef __PROFILING_H
+#define __PROFILING_H
+
+#include <string>
+#include <chrono>
+#include <stdint.h>
+
+
+namespace Profiling {
+
+  const int MAX_STAGES = 64;          // stages of the whole program
+  const int WINDOW = 256;             // values per stage (and thread) in the rolling statistics
+  const int TRACE_CAPACITY = 1 << 18; // trace events per thread (the rest are dropped, and counted)
+
+  enum StageKind { TIMER = 0, COUNTER = 1 };
+
+  class Stage
+  {
+  public:
+    // Stages are registered once (thread-safe) and never go away; szName must outlive the stage (a literal)
+    Stage(const char *szName, StageKind eKind = TIMER);
+
+    const char* Name() const { return mszName; }
+    StageKind Kind() const { return meKind; }
+    int Index() const { return mnIndex; }
+
+    // Records one value (a count for counters, nanoseconds for timers) in the calling thread's ring
+    void Add(uint64_t nValue) const;
+
+  private:
+    const char *mszName;
+    StageKind meKind;
+    int mnIndex;    // -1 if there were more than MAX_STAGES (the stage then records nothing)
+  };
+
+  inline uint64_t NowNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Is anybody tracing? (the timers only look at this)
+  bool Tracing();
+  void TraceEvent(const Stage &stage, uint64_t nStartNs, uint64_t nEndNs);
+
+  // Times its own lifetime (or the intervals between Next() calls) into a stage
+  class ScopedTimer
+  {
+  public:
+    explicit ScopedTimer(const Stage &stage) : mpStage(&stage), mnStart(NowNs()) {}
+    ~ScopedTimer() { Stop(); }
+
+    // Ends the current stage and starts timing the next one
+    void Next(const Stage &stage) { Stop(); mpStage = &stage; mnStart = NowNs(); }
+
+  private:
+    void Stop()
+    {
+      uint64_t nEnd = NowNs();
+      mpStage->Add(nEnd - mnStart);
+      if(Tracing()) TraceEvent(*mpStage, mnStart, nEnd);
+    }
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+
+    const Stage *mpStage;
+    uint64_t mnStart;
+  };
+
+  // The statistics of all the stages that recorded anything since the last Reset(), one line each:
+  // number of values, mean, median, 90th and 99th percentiles and maximum over the window (milliseconds for timers)
+  std::string Report();
+  // A shorter version (timers only: median and 90th percentile) for the caption of the window
+  std::string Overlay();
+  // Starts the statistics over (the values recorded so far are ignored from now on)
+  void Reset();
+
+  // Tracing: StartTrace forgets the events of the previous trace. DumpTrace writes out everything logged since
+  // StartTrace (whether tracing is still on or not), and returns false if the file could not be written.
+  void StartTrace();
+  void StopTrace();
+  bool DumpTrace(const std::string &sFileName);
+
+} // namespace Profiling
+
+#endif
@@ -1,34 +1,78 @@
-
 #include "VideoSource.h"
 
 #include "Persistence/instances.h"
+#include "Profiling.h"
 
 
 #include <iostream>
 #include <sstream>
+#include <cstdlib>
 
 using namespace std;
 using namespace cv;
+using namespace Persistence;
 
 
 
-// For the time being, I am implementing webcam live capture.... All being well, more will follow...
+VideoSource* VideoSource::Create()
+{
+  string sInput = PV3::get("VideoSource.Input", string(""), SILENT);
+
+  // A camera
+  if(sInput.empty() || sInput.compare(0, 7, "camera:") == 0) {
+    int nDevice = sInput.empty() ? -1 : atoi(sInput.c_str() + 7);
+    LiveVideoSource *pSource = new LiveVideoSource(nDevice);
+    if(!pSource->IsOpen()) {
+      cout << "! Cannot open capture device " << nDevice << "." << endl;
+      delete pSource;
+      return NULL;
+    }
+    return pSource;
+  }
 
+  // A recording
+  string sPacing = PV3::get("VideoSource.Pacing", string("original"), SILENT);
+  double dFPS = PV3::get("VideoSource.FPS", 30.0, SILENT);
+  int nLoop = PV3::get("VideoSource.Loop", 0, SILENT);
+  int nQueueSize = PV3::get("VideoSource.QueueSize", 8, SILENT);
+
+  ReplayVideoSource::Pacing ePacing;
+  if(sPacing == "fastest") ePacing = ReplayVideoSource::PACE_FASTEST;
+  else if(sPacing == "original") ePacing = ReplayVideoSource::PACE_ORIGINAL;
+  else if(sPacing == "fps") ePacing = ReplayVideoSource::PACE_FIXED_FPS;
+  else {
+    cout << "! Unknown VideoSource.Pacing " << sPacing << " (fastest, original or fps)." << endl;
+    return NULL;
+  }
+  if(dFPS <= 0) {
+    cout << "! VideoSource.FPS must be positive." << endl;
+    return NULL;
+  }
 
+  ReplayVideoSource *pSource = new ReplayVideoSource(sInput, ePacing, dFPS, nLoop != 0, std::max(nQueueSize, 1));
+  if(!pSource->IsOpen()) {
+    delete pSource;
+    return NULL;
+  }
+  return pSource;
+}
 
-VideoSource::VideoSource()
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                        Live capture
+////////////////////////////////////////////////////////////////////////////////
+
+LiveVideoSource::LiveVideoSource(int nDevice)
 {
 
   std::cout << "  Initiating capture device (whatever it is)..." << std::endl;
 
-  
-  pcap = new VideoCapture(-1); // by device number
-  
-  
-  if(!pcap->isOpened()) {
-    cerr << "Cannot open default capture device. Exiting... " << endl;
-    exit(-1);
-  }
+
+  pcap = new VideoCapture(nDevice); // by device number
+
+
+  if(!pcap->isOpened()) return;
 
   std::cout << "  Now capturing...." << std::endl;
   // obtaining the capture size
@@ -38,20 +82,25 @@ VideoSource::VideoSource()
   cout << " Screen size (width , height) : " << width << " , " <<height <<endl;
 };
 
-cv::Size2i VideoSource::getSize()
-{ 
+LiveVideoSource::~LiveVideoSource()
+{
+  delete pcap;
+}
+
+cv::Size2i LiveVideoSource::getSize()
+{
   return mirSize;
 };
 
 
 
-void VideoSource::GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB)
+bool LiveVideoSource::GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB)
 {
   if ( !pcap->grab() ) {
-    cout << " Could not even grab the first frame! exiting..." << endl;
-    exit(-1);
+    cout << "! Could not grab a frame from the capture device." << endl;
+    return false;
   }
-    
+
   cv::Mat capFrame;
   pcap->retrieve(capFrame);
   /*cv::namedWindow("framed");
@@ -63,7 +112,140 @@ void VideoSource::GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB)
   imBW.create(imRGB.rows, imRGB.cols);
 
   cv::cvtColor(imRGB, imBW, cv::COLOR_BGR2GRAY); // conversion from BGR (OpenCV default) to grayscale
-  
+
+  return true;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//                        Replay
+////////////////////////////////////////////////////////////////////////////////
+
+ReplayVideoSource::ReplayVideoSource(const string &sInput, Pacing ePacing, double dFPS, bool bLoop, int nQueueSize) :
+  msInput(sInput), mePacing(ePacing), mdFPS(dFPS), mbLoop(bLoop), mbOpen(false),
+  mnNextIndex(0), mdLastTimestamp(0), mdLoopOffset(0), mnQueueSize(nQueueSize), mbEnded(false), mbStop(false),
+  mbClockStarted(false), mdFirstTimestamp(0), mnFirstIndex(0)
+{
+  cout << "  Replaying " << sInput << " ..." << endl;
+  if(!mCapture.open(sInput)) {
+    cout << "! Cannot open " << sInput << " for replay." << endl;
+    return;
+  }
+  // The first frame is read here: it gives the size, and there had better be one
+  Frame first;
+  if(!ReadFrame(first)) {
+    cout << "! " << sInput << " has no frames." << endl;
+    return;
+  }
+  mirSize = cv::Size2i(first.imRGB.cols, first.imRGB.rows);
+  cout << " Screen size (width , height) : " << mirSize.width << " , " << mirSize.height << endl;
+  mqFrames.push_back(first);
+  mbOpen = true;
+
+  mPrefetchThread = std::thread(&ReplayVideoSource::PrefetchLoop, this);
+}
+
+ReplayVideoSource::~ReplayVideoSource()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mbStop = true;
+  }
+  mcvNotFull.notify_all();
+  if(mPrefetchThread.joinable()) mPrefetchThread.join();
+}
+
+
+bool ReplayVideoSource::ReadFrame(Frame &frame)
+{
+  cv::Mat imDecoded;
+  if(!mCapture.read(imDecoded) || imDecoded.empty()) {
+    if(!mbLoop || mnNextIndex == 0) return false;
+    // Start over (reopening works for image sequences too); time goes on from the end of the last loop
+    mdLoopOffset = mdLastTimestamp + 1.0 / mdFPS;
+    if(!mCapture.open(msInput) || !mCapture.read(imDecoded) || imDecoded.empty()) return false;
+  }
+
+  if(imDecoded.channels() == 1) {
+    imDecoded.copyTo(frame.imBW);
+    cv::cvtColor(imDecoded, frame.imRGB, cv::COLOR_GRAY2BGR);
+  }
+  else {
+    frame.imRGB = imDecoded;
+    cv::cvtColor(imDecoded, frame.imBW, cv::COLOR_BGR2GRAY);
+  }
+
+  // Video files have timestamps; image sequences (and some containers) give 0, so the frames are then 1 / FPS apart
+  double dStreamTime = mCapture.get(CV_CAP_PROP_POS_MSEC) / 1000.0;
+  double dTimestamp = mdLoopOffset + dStreamTime;
+  if(mnNextIndex > 0 && !(dTimestamp > mdLastTimestamp)) dTimestamp = mdLastTimestamp + 1.0 / mdFPS;
+  frame.dTimestamp = dTimestamp;
+  frame.nIndex = mnNextIndex++;
+  mdLastTimestamp = dTimestamp;
+  return true;
 }
 
 
+void ReplayVideoSource::PrefetchLoop()
+{
+  static Profiling::Stage gStageDecode("Replay.Decode");
+
+  while(true) {
+    Frame frame;
+    bool bRead;
+    {
+      Profiling::ScopedTimer timer(gStageDecode);
+      bRead = ReadFrame(frame);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(!bRead) {
+      mbEnded = true;
+      mcvNotEmpty.notify_all();
+      return;
+    }
+    mcvNotFull.wait(lock, [this]() { return mbStop || mqFrames.size() < mnQueueSize; });
+    if(mbStop) return;
+    mqFrames.push_back(frame);
+    mcvNotEmpty.notify_one();
+  }
+}
+
+
+bool ReplayVideoSource::GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB)
+{
+  // (the time spent waiting for the decoder: should be ~0, unless decoding is the slowest stage)
+  static Profiling::Stage gStageWait("Replay.Wait");
+
+  Frame frame;
+  {
+    Profiling::ScopedTimer timer(gStageWait);
+    std::unique_lock<std::mutex> lock(mMutex);
+    mcvNotEmpty.wait(lock, [this]() { return mbEnded || !mqFrames.empty(); });
+    if(mqFrames.empty()) {
+      cout << "  End of " << msInput << "." << endl;
+      return false;
+    }
+    frame = mqFrames.front();
+    mqFrames.pop_front();
+  }
+  mcvNotFull.notify_one();
+
+  // Pacing: the first frame starts the clock, and the others are due at their time from it
+  if(mePacing != PACE_FASTEST) {
+    std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+    if(!mbClockStarted) {
+      mbClockStarted = true;
+      mtStart = tNow;
+      mdFirstTimestamp = frame.dTimestamp;
+      mnFirstIndex = frame.nIndex;
+    }
+    double dDue = mePacing == PACE_ORIGINAL ? frame.dTimestamp - mdFirstTimestamp : (frame.nIndex - mnFirstIndex) / mdFPS;
+    std::this_thread::sleep_until(mtStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dDue)));
+  }
+
+  imRGB = frame.imRGB;
+  imBW = frame.imBW;
+  return true;
+}
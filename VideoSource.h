@@ -2,33 +2,132 @@
 // Copyright 2008 Isis Innovation Limited
 //
 // VideoSource.h
-// Declares the VideoSource class
-// 
-// This is a very simple class to provide video input; this can be
-// replaced with whatever form of video input that is needed.  It
-// should open the video input on construction, and provide two
-// function calls after construction: Size() must return the video
-// format as an ImageRef, and GetAndFillFrameBWandRGB should wait for
-// a new frame and then overwrite the passed-as-reference images with
-// GreyScale and Colour versions of the new frame.
+// Declares the VideoSource interface and its backends
+//
+// This is a very simple interface to provide video input; it can be
+// implemented with whatever form of video input that is needed.  A
+// source should open the video input on construction, and provide two
+// function calls after construction: getSize() must return the video
+// format, and GetAndFillFrameBWandRGB should wait for a new frame and
+// then overwrite the passed-as-reference images with GreyScale and
+// Colour versions of the new frame (or return false if there are no
+// more frames: the end of a recording, or a failed device).
+//
+// VideoSource::Create() makes the source that the VideoSource.Input PVar asks for:
+//   ""  or "camera:<n>"  LiveVideoSource: capture device n (by default, whichever the system has)
+//   anything else        ReplayVideoSource: a recording, i.e., a video file or an image sequence
+//                        (a printf pattern such as frames/img_%04d.png, as cv::VideoCapture takes it)
+
+#ifndef __VIDEO_SOURCE_H
+#define __VIDEO_SOURCE_H
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include "OpenCV.h"
 
 using namespace cv;
 
-struct VideoSourceData;
-
 class VideoSource
 {
  public:
-  VideoSource();
-  
-  void GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB);
-  
+  virtual ~VideoSource() {}
+
+  virtual bool GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB) = 0;
+
+  virtual cv::Size2i getSize() = 0;
+
+  // The source of VideoSource.Input (see above); prints what went wrong and returns NULL if it cannot be opened.
+  static VideoSource* Create();
+};
+
+
+// Live capture from a camera
+class LiveVideoSource : public VideoSource
+{
+ public:
+  LiveVideoSource(int nDevice);
+  ~LiveVideoSource();
+
+  bool IsOpen() { return pcap->isOpened(); }
+
+  bool GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB);
+
   cv::Size2i getSize();
-  
+
  private:
   cv::VideoCapture *pcap;
-  
+
   cv::Size2i mirSize;
 };
+
+
+// Replay of a recording. The frames are decoded (and converted to grayscale) ahead of time on a prefetch thread,
+// into a queue of a few frames, so the consumer only waits for decoding if it is faster than the decoder.
+// No frame is ever dropped: when the queue is full, the prefetch thread waits.
+// The frames are handed out at the pace of VideoSource.Pacing:
+//   fastest   as soon as they are asked for (throughput measurements)
+//   original  at the timestamps of the recording (latency measurements; image sequences have no timestamps,
+//             so their frames are VideoSource.FPS apart)
+//   fps       at VideoSource.FPS frames per second
+// With VideoSource.Loop = 1 the recording starts over at the end, otherwise GetAndFillFrameBWandRGB returns false.
+class ReplayVideoSource : public VideoSource
+{
+ public:
+  enum Pacing { PACE_FASTEST = 0, PACE_ORIGINAL = 1, PACE_FIXED_FPS = 2 };
+
+  ReplayVideoSource(const std::string &sInput, Pacing ePacing, double dFPS, bool bLoop, int nQueueSize);
+  ~ReplayVideoSource();
+
+  bool IsOpen() { return mbOpen; }
+
+  bool GetAndFillFrameBWandRGB(cv::Mat_<uchar> &imBW, cv::Mat &imRGB);
+
+  cv::Size2i getSize() { return mirSize; }
+
+ private:
+  struct Frame
+  {
+    cv::Mat imRGB;
+    cv::Mat_<uchar> imBW;
+    double dTimestamp;  // seconds, from the start of the recording (and going on across loops)
+    int nIndex;
+  };
+
+  bool ReadFrame(Frame &frame);   // the next frame of the recording (prefetch thread, and the constructor)
+  void PrefetchLoop();
+
+  std::string msInput;
+  Pacing mePacing;
+  double mdFPS;
+  bool mbLoop;
+  bool mbOpen;
+  cv::Size2i mirSize;
+
+  // Decoding (only the prefetch thread touches these, once it runs)
+  cv::VideoCapture mCapture;
+  int mnNextIndex;
+  double mdLastTimestamp;
+  double mdLoopOffset;   // the duration of the loops so far
+
+  // The queue
+  std::deque<Frame> mqFrames;
+  unsigned int mnQueueSize;
+  bool mbEnded;          // the prefetch thread has no more frames
+  bool mbStop;           // the source is going away
+  std::mutex mMutex;
+  std::condition_variable mcvNotEmpty, mcvNotFull;
+  std::thread mPrefetchThread;
+
+  // Pacing (the consumer's)
+  bool mbClockStarted;
+  std::chrono::steady_clock::time_point mtStart;
+  double mdFirstTimestamp;
+  int mnFirstIndex;
+};
+
+#endif
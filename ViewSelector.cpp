@@ -0,0 +1,153 @@
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+
+#include "ViewSelector.h"
+
+#include <cmath>
+#include "Persistence/instances.h"
+
+
+using namespace std;
+using namespace Persistence;
+using namespace RigidTransforms;
+
+
+ViewSelector::ViewSelector()
+{
+  PV3::Register(mpvnMaxViews, "CameraCalibrator.MaxViews", 20, SILENT);
+  PV3::Register(mpvnGridCols, "CameraCalibrator.CoverageGridCols", 8, SILENT);
+  PV3::Register(mpvnGridRows, "CameraCalibrator.CoverageGridRows", 6, SILENT);
+  PV3::Register(mpvdMinScore, "CameraCalibrator.MinViewScore", 0.25, SILENT);
+  PV3::Register(mpvdCoverageWeight, "CameraCalibrator.CoverageWeight", 1.0, SILENT);
+  PV3::Register(mpvdDiversityWeight, "CameraCalibrator.DiversityWeight", 1.0, SILENT);
+  PV3::Register(mpvdInfoGainWeight, "CameraCalibrator.InfoGainWeight", 0.2, SILENT);
+  PV3::Register(mpvdDiversityAngle, "CameraCalibrator.DiversityAngle", 0.35, SILENT); // roughly 20 degrees
+
+  Reset();
+}
+
+
+void ViewSelector::Reset()
+{
+  mimOccupancy = cv::Mat_<int>::zeros(*mpvnGridRows, *mpvnGridCols);
+  mvKeptRotations.clear();
+  mCameraInformation.release();
+}
+
+
+double ViewSelector::Coverage()
+{
+  if(mimOccupancy.total() == 0) return 0;
+
+  return cv::countNonZero(mimOccupancy) / (double) mimOccupancy.total();
+}
+
+
+cv::Mat_<uchar> ViewSelector::OccupiedCells(CalibImage &View)
+{
+  cv::Mat_<uchar> imCells = cv::Mat_<uchar>::zeros(mimOccupancy.rows, mimOccupancy.cols);
+
+  const vector<CalibGridCorner> &vCorners = View.GetGridCorners();
+  for(unsigned int i=0; i<vCorners.size(); i++) {
+
+    int c = (int) (vCorners[i].Params.v2Pos[0] * imCells.cols / View.mim.cols);
+    int r = (int) (vCorners[i].Params.v2Pos[1] * imCells.rows / View.mim.rows);
+    if(c < 0 || r < 0 || c >= imCells.cols || r >= imCells.rows) continue;
+
+    imCells(r, c) = 1;
+  }
+
+  return imCells;
+}
+
+
+// log det of a symmetric positive definite matrix from its eigenvalues
+static double LogDet(const cv::Mat_<double> &M)
+{
+  cv::Mat_<double> vEigenValues;
+  cv::eigen(M, vEigenValues);
+
+  double dLogDet = 0;
+  for(int i=0; i<vEigenValues.rows; i++)
+    dLogDet += log( std::max(vEigenValues(i, 0), 1e-300) );
+
+  return dLogDet;
+}
+
+
+template<class CameraModel>
+ViewScore ViewSelector::Score(CalibImage &View, GenericCamera<CameraModel> &Camera)
+{
+  const int N = CameraModel::NumParams;
+  ViewScore score;
+
+  // The grid size may have been changed from the console; start over in that case.
+  if(mimOccupancy.rows != *mpvnGridRows || mimOccupancy.cols != *mpvnGridCols) Reset();
+
+  // 1. Coverage : cells covered by this view and no other
+  cv::Mat_<uchar> imCells = OccupiedCells(View);
+  int nNewCells = 0;
+  for(int r=0; r<imCells.rows; r++)
+    for(int c=0; c<imCells.cols; c++)
+      if(imCells(r, c) && mimOccupancy(r, c) == 0) nNewCells++;
+  score.dCoverage = nNewCells / (double) imCells.total();
+
+  // 2. Diversity : the smallest angle between the rotation of the view and the rotations of the kept views
+  const SO3<> &R = View.mse3CamFromWorld.get_rotation();
+  score.dDiversity = M_PI;
+  for(unsigned int i=0; i<mvKeptRotations.size(); i++) {
+
+    double dAngle = cv::norm( (R * mvKeptRotations[i].inverse()).ln() );
+    if(dAngle < score.dDiversity) score.dDiversity = dAngle;
+  }
+
+  // 3. Information gain : 0.5 * (log det(L + S) - log det(L)) where L is the information of the kept views
+  //    and S the reduced information of the candidate. A unit prior keeps L invertible in the beginning.
+  cv::Mat_<double> mL = mCameraInformation.empty() ? cv::Mat_<double>::eye(N, N) : mCameraInformation.clone();
+  cv::Mat_<double> mS = cv::Mat(View.CameraInformation(Camera));
+  cv::Mat_<double> mLS = mL + mS;
+  score.dInfoGain = 0.5 * (LogDet(mLS) - LogDet(mL)) / N;
+
+  score.dTotal = *mpvdCoverageWeight * score.dCoverage +
+		 *mpvdDiversityWeight * std::min(score.dDiversity / *mpvdDiversityAngle, 1.0) +
+		 *mpvdInfoGainWeight * score.dInfoGain;
+
+  return score;
+}
+
+
+template<class CameraModel>
+void ViewSelector::Add(CalibImage &View, GenericCamera<CameraModel> &Camera)
+{
+  const int N = CameraModel::NumParams;
+
+  if(mimOccupancy.rows != *mpvnGridRows || mimOccupancy.cols != *mpvnGridCols) Reset();
+
+  cv::Mat_<uchar> imCells = OccupiedCells(View);
+  for(int r=0; r<imCells.rows; r++)
+    for(int c=0; c<imCells.cols; c++)
+      mimOccupancy(r, c) += imCells(r, c);
+
+  mvKeptRotations.push_back(View.mse3CamFromWorld.get_rotation());
+
+  if(mCameraInformation.empty()) mCameraInformation = cv::Mat_<double>::eye(N, N);
+  mCameraInformation += cv::Mat(View.CameraInformation(Camera));
+}
+
+
+bool ViewSelector::Accept(const ViewScore &Score, int nKept)
+{
+  if(BudgetExhausted(nKept)) return false;
+
+  return Score.dTotal >= *mpvdMinScore;
+}
+
+
+// Explicit instantiations for the camera models (see CameraModels.h)
+template ViewScore ViewSelector::Score<ATANModel>(CalibImage &View, ATANCamera &Camera);
+template ViewScore ViewSelector::Score<RadTanModel>(CalibImage &View, RadTanCamera &Camera);
+template ViewScore ViewSelector::Score<FisheyeModel>(CalibImage &View, FisheyeCamera &Camera);
+
+template void ViewSelector::Add<ATANModel>(CalibImage &View, ATANCamera &Camera);
+template void ViewSelector::Add<RadTanModel>(CalibImage &View, RadTanCamera &Camera);
+template void ViewSelector::Add<FisheyeModel>(CalibImage &View, FisheyeCamera &Camera);
@@ -0,0 +1,88 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+// Based on PTAM by Klein and Murray
+//
+// Automatic selection of calibration views.
+//
+// Every successfully "made" CalibImage (with an initial pose from GuessInitialPose) can be scored
+// against the views already kept by the calibrator. The score combines three things:
+//
+//  a) Image-plane coverage: The image is split in a coarse occupancy grid and we count the cells
+//     that the grid corners of the view occupy and which no kept view has touched yet.
+//  b) Pose diversity: The smallest rotation angle between the view and the kept views
+//     (a view which is nearly identical to a kept one teaches the optimizer nothing new).
+//  c) Information gain: How much the view increases the log-determinant of the information
+//     on the camera parameters (the pose of each view is marginalized out via the Schur complement).
+//
+// The calibrator keeps a view only if the weighted sum exceeds a threshold and the view budget is not exhausted,
+// so the optimizer problem stays small.
+
+#ifndef __VIEW_SELECTOR_H
+#define __VIEW_SELECTOR_H
+
+#include <vector>
+
+#include "CalibImage.h"
+#include "GenericCamera.h"
+#include "GCVD/SO3.h"
+#include "Persistence/PVars.h"
+
+#include "OpenCV.h"
+
+
+struct ViewScore
+{
+  double dCoverage;   // Fraction of the occupancy grid cells that the view covers for the first time
+  double dDiversity;  // Smallest rotation angle (radians) between the view and the kept views
+  double dInfoGain;   // Increase of 0.5 * log det of the camera parameter information, per parameter
+  double dTotal;      // The weighted sum of the above (diversity is normalized first)
+
+  ViewScore() : dCoverage(0), dDiversity(0), dInfoGain(0), dTotal(0) {}
+};
+
+
+class ViewSelector
+{
+public:
+
+  ViewSelector();
+
+  // Forget all kept views
+  void Reset();
+
+  // Score a candidate view (which must already have an initial pose) against the kept views
+  template<class CameraModel> ViewScore Score(CalibImage &View, GenericCamera<CameraModel> &Camera);
+
+  // Register a view as kept (call this for the views the calibrator actually keeps - including manual grabs)
+  template<class CameraModel> void Add(CalibImage &View, GenericCamera<CameraModel> &Camera);
+
+  // Whether a view with this score should be kept, given the number of views we already have.
+  bool Accept(const ViewScore &Score, int nKept);
+
+  bool BudgetExhausted(int nKept) { return nKept >= *mpvnMaxViews; }
+  int Budget() { return *mpvnMaxViews; }
+
+  // Fraction of the occupancy grid covered by the kept views
+  double Coverage();
+
+protected:
+
+  // Marks the occupancy grid cells touched by the grid corners of the view
+  cv::Mat_<uchar> OccupiedCells(CalibImage &View);
+
+  cv::Mat_<int> mimOccupancy;                       // How many kept views touch each cell
+  std::vector<RigidTransforms::SO3<> > mvKeptRotations; // The rotations of the kept views
+  cv::Mat_<double> mCameraInformation;               // Accumulated (reduced) information on the camera parameters
+
+  Persistence::pvar3<int> mpvnMaxViews;         // The view budget
+  Persistence::pvar3<int> mpvnGridCols;         // Occupancy grid columns
+  Persistence::pvar3<int> mpvnGridRows;         // Occupancy grid rows
+  Persistence::pvar3<double> mpvdMinScore;      // Threshold on the total score
+  Persistence::pvar3<double> mpvdCoverageWeight;
+  Persistence::pvar3<double> mpvdDiversityWeight;
+  Persistence::pvar3<double> mpvdInfoGainWeight;
+  Persistence::pvar3<double> mpvdDiversityAngle; // The angle (radians) at which a view counts as "fully" diverse
+};
+
+
+#endif
@@ -0,0 +1,218 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// Benchmark of the lazy (expression template) vector operators of GCVD/Operators.h on the initial angle search
+// of the calibration corners (GuessInitialAngles in CalibImage.cpp): 3142 angles x 10 strip pairs x 4 bilinear
+// samples per corner. The "eager" search is the previous version, where every + - and scalar * of the sample
+// positions and of the four interpolated values materializes a cv::Vec. The "lazy" one is the current
+// CalibImage.cpp code. Both run on synthetic checkerboard corners at known angles and must agree.
+//
+// The file also carries the compile-time checks of the expression types (sizes and element types),
+// and checks the lazy SE3::adjoint / trinvadjoint of a matrix against the vector versions.
+//
+// Usage: angle_bench [corners = 20] [repetitions = 5]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "../GCVD/image_interpolate.h"
+#include "../GCVD/SE3.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+using namespace CvUtils;
+
+
+//////////////////////////////////////////////////////////////////////////////////
+//                 Compile-time checks of the expression types
+//////////////////////////////////////////////////////////////////////////////////
+// (Mismatched sizes, e.g. lazy(cv::Vec3f()) + cv::Vec2f(), or lazy(cv::Matx23d()) * cv::Matx23d(),
+// do not compile: they stop at the static_asserts of the nodes.)
+namespace {
+
+  using MyOperatorOverloads::VExprLeaf;
+
+  typedef decltype(lazy(cv::Vec3f()) + cv::Vec3d() - cv::Vec3f() * 2) MixedChain;
+  static_assert(MixedChain::size == 3, "a vector chain keeps the size of its operands");
+  static_assert(std::is_same<MixedChain::value_type, double>::value, "float + double is double (as with the eager operators)");
+
+  typedef decltype(-(lazy(cv::Vec4f()) * 0.5f) / 2.0f) ScaledChain;
+  static_assert(ScaledChain::size == 4 && std::is_same<ScaledChain::value_type, float>::value, "float stays float");
+
+  typedef decltype(lazy(cv::Matx<double, 2, 3>()) * cv::Matx<double, 3, 4>()) Product;
+  static_assert(Product::rows == 2 && Product::cols == 4, "(2x3) * (3x4) is 2x4");
+
+  typedef decltype(lazy(cv::Matx<double, 2, 3>()) * cv::Matx<double, 3, 4>() * transpose(lazy(cv::Matx<double, 5, 4>()))) ProductChain;
+  static_assert(ProductChain::rows == 2 && ProductChain::cols == 5, "(2x4) * (4x5) is 2x5");
+
+  typedef decltype(transpose(lazy(cv::Matx<float, 2, 3>()) + cv::Matx<float, 2, 3>()) * cv::Vec2f()) MatrixVector;
+  static_assert(MatrixVector::size == 3 && std::is_same<MatrixVector::value_type, float>::value, "(3x2) * 2-vector is a 3-vector");
+
+  static_assert(std::is_same<decltype(lazy(cv::Vec2d()).eval()), cv::Vec2d>::value, "eval() gives back a cv::Vec");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////
+//                 The angle search, before and after
+//////////////////////////////////////////////////////////////////////////////////
+
+// The previous version (eager cv::Vec operators)
+static cv::Vec2f GuessInitialAnglesEager(cv::Mat_<uchar> &im, cv::Point2i irCenter)
+{
+  image_interpolate<Interpolate::Bilinear, uchar> imInterp(im);
+  double dBestAngle = 0;
+  double dBestGradMag = 0;
+  double dGradAtBest = 0;
+  cv::Vec2d irCenterv(irCenter.x, irCenter.y);
+  for(double dAngle = 0.0; dAngle < M_PI; dAngle += 0.001) {
+
+      cv::Vec2d v2Dirn( cos(dAngle)     ,      sin(dAngle) );
+      cv::Vec2d v2Perp( v2Dirn[1]       ,      -v2Dirn[0]  );
+
+      double response = 0;
+      for (int k = 0; k < 10; k++) {
+      cv::Vec4d dG4 =    imInterp[irCenterv + (k + 1.0) * v2Dirn + k * sin(M_PI * 10.0 / 180.0)  * v2Perp] -
+			 imInterp[irCenterv + (k + 1.0) * v2Dirn - k * sin(M_PI * 10.0 / 180.0)  * v2Perp] +
+			 imInterp[irCenterv - (k + 1.0) * v2Dirn - k * sin(M_PI * 10.0 / 180.0)  * v2Perp] -
+			 imInterp[irCenterv - (k + 1.0) * v2Dirn + k * sin(M_PI * 10.0 / 180.0)  * v2Perp];
+
+      response += dG4[0];
+      }
+
+      if(fabs(response) > dBestGradMag) {
+	  dBestGradMag = fabs(response);
+	  dGradAtBest = response;
+	  dBestAngle = dAngle;
+	}
+    }
+
+  return cv::Vec2f(dGradAtBest < 0 ? dBestAngle : dBestAngle - M_PI / 2.0,
+		   dGradAtBest < 0 ? dBestAngle + M_PI / 2.0 : dBestAngle );
+}
+
+// The current version (as in CalibImage.cpp)
+static cv::Vec2f GuessInitialAnglesLazy(cv::Mat_<uchar> &im, cv::Point2i irCenter)
+{
+  image_interpolate<Interpolate::Bilinear, uchar> imInterp(im);
+  double dBestAngle = 0;
+  double dBestGradMag = 0;
+  double dGradAtBest = 0;
+  cv::Vec2d irCenterv(irCenter.x, irCenter.y);
+  const double dSinConeAngle = sin(M_PI * 10.0 / 180.0);
+  for(double dAngle = 0.0; dAngle < M_PI; dAngle += 0.001) {
+
+      cv::Vec2d v2Dirn( cos(dAngle)     ,      sin(dAngle) );
+      cv::Vec2d v2Perp( v2Dirn[1]       ,      -v2Dirn[0]  );
+
+      double response = 0;
+      for (int k = 0; k < 10; k++) {
+      const cv::Vec2d v2Along = lazy(v2Dirn) * (k + 1.0);
+      const cv::Vec2d v2Across = lazy(v2Perp) * (k * dSinConeAngle);
+      response += ( lazy(imInterp[(lazy(irCenterv) + v2Along + v2Across).eval()]) -
+		    lazy(imInterp[(lazy(irCenterv) + v2Along - v2Across).eval()]) +
+		    lazy(imInterp[(lazy(irCenterv) - v2Along - v2Across).eval()]) -
+		    lazy(imInterp[(lazy(irCenterv) - v2Along + v2Across).eval()]) )[0];
+      }
+
+      if(fabs(response) > dBestGradMag) {
+	  dBestGradMag = fabs(response);
+	  dGradAtBest = response;
+	  dBestAngle = dAngle;
+	}
+    }
+
+  return cv::Vec2f(dGradAtBest < 0 ? dBestAngle : dBestAngle - M_PI / 2.0,
+		   dGradAtBest < 0 ? dBestAngle + M_PI / 2.0 : dBestAngle );
+}
+
+
+// A 64 x 64 checkerboard corner at the center of the image, rotated by dAngle (4x4 supersampled)
+static cv::Mat_<uchar> MakeCorner(double dAngle)
+{
+  const int nSize = 64;
+  cv::Mat_<uchar> im(nSize, nSize);
+  const double c = cos(dAngle), s = sin(dAngle);
+  for(int r=0; r<nSize; r++)
+    for(int col=0; col<nSize; col++) {
+      int nWhite = 0;
+      for(int sr=0; sr<4; sr++)
+	for(int sc=0; sc<4; sc++) {
+	  double x = col + (sc + 0.5) / 4.0 - 0.5 - nSize / 2, y = r + (sr + 0.5) / 4.0 - 0.5 - nSize / 2;
+	  double u = c * x + s * y, v = -s * x + c * y;
+	  nWhite += (u * v > 0);
+	}
+      im(r, col) = (uchar) (30 + 200 * nWhite / 16);
+    }
+  return im;
+}
+
+
+typedef chrono::high_resolution_clock Clock;
+
+static double Seconds(Clock::time_point t0, Clock::time_point t1) { return chrono::duration<double>(t1 - t0).count(); }
+
+
+int main(int argc, char** argv)
+{
+  int nCorners = argc > 1 ? atoi(argv[1]) : 20;
+  int nReps = argc > 2 ? atoi(argv[2]) : 5;
+
+  vector<cv::Mat_<uchar> > vImages(nCorners);
+  for(int i=0; i<nCorners; i++) vImages[i] = MakeCorner(M_PI / 2.0 * i / nCorners);
+  const cv::Point2i irCenter(32, 32);
+
+  double dEager = 1e30, dLazy = 1e30;
+  double dMaxDiff = 0;
+  vector<cv::Vec2f> vEager(nCorners), vLazy(nCorners);
+  for(int r=0; r<nReps; r++) {
+
+    Clock::time_point t0 = Clock::now();
+    for(int i=0; i<nCorners; i++) vEager[i] = GuessInitialAnglesEager(vImages[i], irCenter);
+    Clock::time_point t1 = Clock::now();
+    for(int i=0; i<nCorners; i++) vLazy[i] = GuessInitialAnglesLazy(vImages[i], irCenter);
+    Clock::time_point t2 = Clock::now();
+
+    dEager = std::min(dEager, Seconds(t0, t1));
+    dLazy = std::min(dLazy, Seconds(t1, t2));
+  }
+  for(int i=0; i<nCorners; i++)
+    dMaxDiff = std::max(dMaxDiff, (double) (fabs(vEager[i][0] - vLazy[i][0]) + fabs(vEager[i][1] - vLazy[i][1])));
+
+  // SE3 adjoint of a matrix (lazy A * M * A') against the adjoint of its columns and then its rows
+  cv::RNG rng(0x5eed);
+  cv::Vec<double, 6> mu;
+  cv::Matx<double, 6, 6> M;
+  for(int i=0; i<6; i++) mu[i] = rng.uniform(-1.0, 1.0);
+  for(int i=0; i<36; i++) M.val[i] = rng.uniform(-1.0, 1.0);
+  RigidTransforms::SE3<double> se3 = RigidTransforms::SE3<double>::exp(mu);
+  cv::Matx<double, 6, 6> Adj = se3.adjoint(M), TrInvAdj = se3.trinvadjoint(M);
+  cv::Matx<double, 6, 6> AdjCols, TrInvAdjCols;
+  for(int c=0; c<6; c++) {
+    cv::Vec<double, 6> col, tcol;
+    for(int r=0; r<6; r++) col[r] = M(r, c);
+    col = se3.adjoint(col); tcol = se3.trinvadjoint(cv::Vec<double, 6>(M(0, c), M(1, c), M(2, c), M(3, c), M(4, c), M(5, c)));
+    for(int r=0; r<6; r++) { AdjCols(r, c) = col[r]; TrInvAdjCols(r, c) = tcol[r]; }
+  }
+  double dAdjDiff = 0;
+  for(int r=0; r<6; r++) {
+    cv::Vec<double, 6> row, trow;
+    for(int c=0; c<6; c++) { row[c] = AdjCols(r, c); trow[c] = TrInvAdjCols(r, c); }
+    row = se3.adjoint(row); trow = se3.trinvadjoint(trow);
+    for(int c=0; c<6; c++)
+      dAdjDiff = std::max(dAdjDiff, std::max(fabs(row[c] - Adj(r, c)), fabs(trow[c] - TrInvAdj(r, c))));
+  }
+
+  cout << "GuessInitialAngles (" << nCorners << " corners, best of " << nReps << ")" << endl;
+  cout << fixed << setprecision(3);
+  cout << setw(20) << "eager (ms/corner)" << setw(10) << dEager / nCorners * 1e3 << endl;
+  cout << setw(20) << "lazy (ms/corner)" << setw(10) << dLazy / nCorners * 1e3
+       << setw(10) << dEager / dLazy << "x" << endl;
+  cout << "max difference between the angles: " << scientific << dMaxDiff << endl;
+  cout << "max difference of the SE3 matrix adjoints: " << dAdjDiff << endl;
+
+  return (dMaxDiff < 1e-6 && dAdjDiff < 1e-9) ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// Throughput benchmark of the FAST-N detectors: the generated decision trees (fast_corner_detect_plain_N)
+// against the SIMD segment test engine (fast_corner_detect_simd<N>), for N = 7 ... 12 and a few image sizes.
+// Every run also checks that the two produce exactly the same corners.
+//
+// Usage: fast_bench [barrier = 20] [repetitions = 20]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../FAST/prototypes.h"
+#include "../FAST/fast_corner_simd.h"
+#include "fast_test_image.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+using namespace FAST;
+
+
+typedef void (*DetectFn)(const cv::Mat_<uchar>&, vector<cv::Point2i>&, int);
+
+struct Detector
+{
+  int N;
+  DetectFn Plain;
+  DetectFn Simd;
+};
+
+
+// best-of-n wall time in seconds
+static double TimeDetector(DetectFn fn, const cv::Mat_<uchar> &im, int nBarrier, int nReps, vector<cv::Point2i> &vCorners)
+{
+  double dBest = 1e30;
+  for(int i=0; i<nReps; i++) {
+
+    vCorners.clear();
+    chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+    fn(im, vCorners, nBarrier);
+    chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+    dBest = std::min(dBest, chrono::duration<double>(t1 - t0).count());
+  }
+  return dBest;
+}
+
+
+int main(int argc, char** argv)
+{
+  int nBarrier = argc > 1 ? atoi(argv[1]) : 20;
+  int nReps = argc > 2 ? atoi(argv[2]) : 20;
+
+  Detector aDetectors[] = {
+    { 7, fast_corner_detect_plain_7, fast_corner_detect_simd<7> },
+    { 8, fast_corner_detect_plain_8, fast_corner_detect_simd<8> },
+    { 9, fast_corner_detect_plain_9, fast_corner_detect_simd<9> },
+    { 10, fast_corner_detect_plain_10, fast_corner_detect_simd<10> },
+    { 11, fast_corner_detect_plain_11, fast_corner_detect_simd<11> },
+    { 12, fast_corner_detect_plain_12, fast_corner_detect_simd<12> }
+  };
+  cv::Size aSizes[] = { cv::Size(320, 240), cv::Size(640, 480), cv::Size(1280, 720), cv::Size(1920, 1080) };
+
+  cout << "FAST throughput (barrier " << nBarrier << ", best of " << nReps << ", engine: " << fast_simd_instruction_set() << ")" << endl;
+  cout << setw(4) << "N" << setw(12) << "size" << setw(10) << "corners"
+       << setw(14) << "tree Mpix/s" << setw(14) << "simd Mpix/s" << setw(10) << "speedup" << setw(8) << "exact" << endl;
+
+  bool bAllExact = true;
+  for(unsigned int s=0; s<sizeof(aSizes) / sizeof(aSizes[0]); s++) {
+
+    cv::Mat_<uchar> im = MakeTestImage(aSizes[s].width, aSizes[s].height);
+    double dMpix = im.total() * 1e-6;
+
+    for(unsigned int d=0; d<sizeof(aDetectors) / sizeof(aDetectors[0]); d++) {
+
+      vector<cv::Point2i> vPlain, vSimd;
+      double dPlain = TimeDetector(aDetectors[d].Plain, im, nBarrier, nReps, vPlain);
+      double dSimd = TimeDetector(aDetectors[d].Simd, im, nBarrier, nReps, vSimd);
+      bool bExact = vPlain == vSimd;
+      bAllExact = bAllExact && bExact;
+
+      ostringstream ostSize;
+      ostSize << aSizes[s].width << "x" << aSizes[s].height;
+      cout << setw(4) << aDetectors[d].N << setw(12) << ostSize.str() << setw(10) << vSimd.size()
+	   << setw(14) << fixed << setprecision(1) << dMpix / dPlain
+	   << setw(14) << dMpix / dSimd
+	   << setw(10) << setprecision(2) << dPlain / dSimd
+	   << setw(8) << (bExact ? "yes" : "NO") << endl;
+    }
+  }
+
+  return bAllExact ? 0 : 1;
+}
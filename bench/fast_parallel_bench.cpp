@@ -0,0 +1,106 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// Scaling benchmark of the tiled FAST detection (fast_corner_detect_nonmax_parallel) for 1 ... 32 threads,
+// against the serial detect + nonmax pass. Every run also checks that the result is identical to the serial one.
+//
+// Usage: fast_parallel_bench [N = 9] [barrier = 20] [repetitions = 10]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "../FAST/fast_corner.h"
+#include "../FAST/fast_corner_simd.h"
+#include "../FAST/fast_corner_parallel.h"
+#include "fast_test_image.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+using namespace FAST;
+
+
+typedef vector<pair<cv::Point2i, int> > CornerList;
+
+
+template<int N>
+static void Serial(const cv::Mat_<uchar> &im, CornerList &vMax, int nBarrier)
+{
+  vector<cv::Point2i> vCorners;
+  fast_corner_detect_simd<N>(im, vCorners, nBarrier);
+  fast_nonmax_with_scores(im, vCorners, nBarrier, vMax);
+}
+
+
+template<int N>
+static int Run(int nBarrier, int nReps)
+{
+  cv::Size aSizes[] = { cv::Size(640, 480), cv::Size(1920, 1080), cv::Size(3840, 2160) };
+  int anThreads[] = { 1, 2, 4, 8, 16, 32 };
+  bool bAllExact = true;
+
+  cout << "Tiled FAST-" << N << " + nonmax (barrier " << nBarrier << ", best of " << nReps << ", engine: " << fast_simd_instruction_set()
+       << ", " << thread::hardware_concurrency() << " hardware threads)" << endl;
+  cout << setw(12) << "size" << setw(9) << "threads" << setw(12) << "ms" << setw(10) << "speedup" << setw(10) << "corners" << setw(8) << "exact" << endl;
+
+  for(unsigned int s=0; s<sizeof(aSizes) / sizeof(aSizes[0]); s++) {
+
+    cv::Mat_<uchar> im = MakeTestImage(aSizes[s].width, aSizes[s].height);
+    ostringstream ostSize;
+    ostSize << aSizes[s].width << "x" << aSizes[s].height;
+
+    CornerList vSerial;
+    double dSerial = 1e30;
+    for(int i=0; i<nReps; i++) {
+
+      chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+      Serial<N>(im, vSerial, nBarrier);
+      dSerial = std::min(dSerial, chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count());
+    }
+    cout << setw(12) << ostSize.str() << setw(9) << "serial" << setw(12) << fixed << setprecision(3) << dSerial * 1e3
+	 << setw(10) << setprecision(2) << 1.0 << setw(10) << vSerial.size() << setw(8) << "-" << endl;
+
+    for(unsigned int t=0; t<sizeof(anThreads) / sizeof(anThreads[0]); t++) {
+
+      CornerList vParallel;
+      double dBest = 1e30;
+      for(int i=0; i<nReps; i++) {
+
+	chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+	fast_corner_detect_nonmax_parallel<N>(im, vParallel, nBarrier, anThreads[t]);
+	dBest = std::min(dBest, chrono::duration<double>(chrono::high_resolution_clock::now() - t0).count());
+      }
+      bool bExact = vParallel == vSerial;
+      bAllExact = bAllExact && bExact;
+
+      cout << setw(12) << ostSize.str() << setw(9) << anThreads[t] << setw(12) << setprecision(3) << dBest * 1e3
+	   << setw(10) << setprecision(2) << dSerial / dBest << setw(10) << vParallel.size() << setw(8) << (bExact ? "yes" : "NO") << endl;
+    }
+  }
+
+  return bAllExact ? 0 : 1;
+}
+
+
+int main(int argc, char** argv)
+{
+  int nN = argc > 1 ? atoi(argv[1]) : 9;
+  int nBarrier = argc > 2 ? atoi(argv[2]) : 20;
+  int nReps = argc > 3 ? atoi(argv[3]) : 10;
+
+  switch(nN) {
+    case 7: return Run<7>(nBarrier, nReps);
+    case 8: return Run<8>(nBarrier, nReps);
+    case 9: return Run<9>(nBarrier, nReps);
+    case 10: return Run<10>(nBarrier, nReps);
+    case 11: return Run<11>(nBarrier, nReps);
+    case 12: return Run<12>(nBarrier, nReps);
+    default:
+      cout << "N must be 7 ... 12" << endl;
+      return 1;
+  }
+}
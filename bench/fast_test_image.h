@@ -0,0 +1,31 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+//
+// The test image of the FAST benchmarks (fast_bench, fast_parallel_bench): checkerboard-like, with some texture
+// and noise, so that both the early-rejection and the full arc test paths get exercised.
+// It is seeded, so every benchmark (and every run) sees the same image for the same size.
+
+#ifndef __FAST_TEST_IMAGE_H
+#define __FAST_TEST_IMAGE_H
+
+#include <algorithm>
+
+#include "../OpenCV.h"
+
+
+inline cv::Mat_<uchar> MakeTestImage(int nWidth, int nHeight)
+{
+  cv::Mat_<uchar> im(nHeight, nWidth);
+  cv::RNG rng(0x5eed);
+  for(int r=0; r<nHeight; r++)
+    for(int c=0; c<nWidth; c++) {
+
+      int nSquare = ((r / 40) + (c / 40)) % 2;
+      int nTexture = ((r * 7 + c * 13) % 23 == 0) ? 60 : 0;
+      int v = (nSquare ? 200 : 50) + nTexture + (int) rng.gaussian(6.0);
+      im(r, c) = (uchar) std::min(255, std::max(0, v));
+    }
+  return im;
+}
+
+#endif
@@ -0,0 +1,312 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// The performance suite of the calibrator: every stage of the pipeline timed on synthetic images of the
+// calibration pattern (see synthetic_board.h), so that the numbers are the same from one run to the next
+// (the scene is seeded) and do not depend on a camera being plugged in.
+//
+//   ScanCorners           the full-frame IsCorner scan of MakeFromImage (on the blurred image)
+//   GuessInitialAngles    the initial angle search, one corner
+//   IterateOnImage        one Gauss-Newton iteration of the corner patch, one corner
+//   MakeFromImage         the whole detection of a view (blur, candidates, grid growing)
+//   GuessInitialPose      the homography pose estimate of a detected view
+//   OptimizeOneStep/N     one step of the optimization over N views (10, 50, 200)
+//   fast_corner_detect_plain_N  the generated FAST decision trees (N = 7 ... 12; the reference)
+//   fast_corner_detect_simd<N>  the SIMD segment test engine (N = 4 ... 12) that fast_corner_detect_N goes through
+//
+// Each benchmark is repeated until it has run for at least the minimum time (growing the iterations),
+// and the mean time of one iteration is reported. The results can also be written as JSON, in the layout of
+// Google Benchmark (so the usual comparison scripts work on them) with the settings of the scene in "context".
+//
+// Usage: gcalibrator_bench [options]
+//   --benchmark_filter=<text>      only the benchmarks whose name contains <text>
+//   --benchmark_min_time=<secs>    minimum time per benchmark (default: 0.5)
+//   --benchmark_out=<file.json>    also write the results as JSON
+//   --size=<width>x<height>        image size (default: 640x480)
+//   --blur=<pixels> --noise=<gray levels>   of the synthetic images (default: 1 and 2)
+//   --seed=<n>                     of the poses and the noise (default: 1)
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include "../CalibImage.h"
+#include "../CalibOptimizer.h"
+#include "../CameraModels.h"
+#include "../FAST/fast_corner.h"
+#include "../FAST/fast_corner_simd.h"
+#include "../FAST/prototypes.h"
+#include "../GCVD/GLBatch.h"
+
+#include "synthetic_board.h"
+#include "silence.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+using namespace SyntheticBoard;
+
+
+typedef chrono::high_resolution_clock Clock;
+
+struct BenchResult
+{
+  string sName;
+  long nIterations;
+  double dRealNs;       // per iteration
+  double dCpuNs;
+  double dItemsPerIteration; // 0: no items_per_second
+};
+
+static vector<BenchResult> gvResults;
+static string gsFilter;
+static double gdMinTime = 0.5;
+
+// Runs fn (nIterations times per call) until the minimum time is reached, and reports the mean
+template<class F>
+static void Benchmark(const string &sName, F fn, double dItemsPerIteration = 0)
+{
+  if(!gsFilter.empty() && sName.find(gsFilter) == string::npos) return;
+
+  long nIterations = 1;
+  double dReal = 0, dCpu = 0;
+  while(true) {
+    Clock::time_point t0 = Clock::now();
+    clock_t c0 = clock();
+    {
+      // (the batch is emptied after each iteration, as a detection worker does after each frame: it keeps its
+      // capacity, so the drawing costs what it does in the calibrator, rather than growing over all the iterations)
+      Silence silence;
+      for(long i=0; i<nIterations; i++) { fn(); GLXInterface::glBatch().Clear(); }
+    }
+    dCpu = (double) (clock() - c0) / CLOCKS_PER_SEC;
+    dReal = chrono::duration<double>(Clock::now() - t0).count();
+    if(dReal >= gdMinTime || nIterations >= (1L << 30)) break;
+    // aim a bit beyond the minimum time (but never more than 10 times the iterations)
+    double dScale = dReal > 0 ? 1.4 * gdMinTime / dReal : 10;
+    nIterations = std::max(nIterations + 1, (long) (nIterations * std::min(dScale, 10.0)));
+  }
+
+  BenchResult res;
+  res.sName = sName;
+  res.nIterations = nIterations;
+  res.dRealNs = dReal * 1e9 / nIterations;
+  res.dCpuNs = dCpu * 1e9 / nIterations;
+  res.dItemsPerIteration = dItemsPerIteration;
+  gvResults.push_back(res);
+
+  cout << left << setw(32) << sName << right << setw(16) << fixed << setprecision(0) << res.dRealNs << " ns"
+       << setw(16) << res.dCpuNs << " ns" << setw(12) << nIterations;
+  if(dItemsPerIteration > 0) cout << setw(14) << setprecision(3) << dItemsPerIteration / (res.dRealNs * 1e-9) / 1e6 << " M/s";
+  cout << endl;
+}
+
+
+static string JsonEscape(const string &s)
+{
+  string sOut;
+  for(unsigned int i=0; i<s.size(); i++) {
+    if(s[i] == '"' || s[i] == '\\') sOut += '\\';
+    sOut += s[i];
+  }
+  return sOut;
+}
+
+static bool WriteJson(const string &sFileName, const vector<pair<string, string> > &vContext)
+{
+  ofstream ofs(sFileName.c_str());
+  if(!ofs.good()) {
+    cout << "! Could not open " << sFileName << " for writing." << endl;
+    return false;
+  }
+  time_t tNow = time(NULL);
+  char szDate[64];
+  strftime(szDate, sizeof(szDate), "%Y-%m-%dT%H:%M:%S", localtime(&tNow));
+
+  ofs << "{\n  \"context\": {\n    \"date\": \"" << szDate << "\",\n"
+      << "    \"executable\": \"gcalibrator_bench\",\n"
+      << "    \"num_cpus\": " << cv::getNumberOfCPUs();
+  for(unsigned int i=0; i<vContext.size(); i++)
+    ofs << ",\n    \"" << JsonEscape(vContext[i].first) << "\": \"" << JsonEscape(vContext[i].second) << "\"";
+  ofs << "\n  },\n  \"benchmarks\": [";
+  for(unsigned int i=0; i<gvResults.size(); i++) {
+    const BenchResult &res = gvResults[i];
+    ofs << (i == 0 ? "\n" : ",\n") << "    {\n"
+	<< "      \"name\": \"" << JsonEscape(res.sName) << "\",\n"
+	<< "      \"run_type\": \"iteration\",\n"
+	<< "      \"iterations\": " << res.nIterations << ",\n"
+	<< setprecision(10) << "      \"real_time\": " << res.dRealNs << ",\n"
+	<< "      \"cpu_time\": " << res.dCpuNs << ",\n"
+	<< "      \"time_unit\": \"ns\"";
+    if(res.dItemsPerIteration > 0) ofs << ",\n      \"items_per_second\": " << res.dItemsPerIteration / (res.dRealNs * 1e-9);
+    ofs << "\n    }";
+  }
+  ofs << "\n  ]\n}\n";
+  return ofs.good();
+}
+
+
+// The FAST detectors, one benchmark each
+typedef void (*FastDetector)(const cv::Mat_<uchar>&, std::vector<cv::Point2i>&, int);
+
+static void BenchmarkFast(const string &sName, FastDetector detect, const cv::Mat_<uchar> &im, int nBarrier)
+{
+  vector<cv::Point2i> vCorners;
+  Benchmark(sName, [&]() { vCorners.clear(); detect(im, vCorners, nBarrier); }, im.rows * im.cols);
+}
+
+
+static bool ParseOption(const string &sArg, const string &sName, string &sValue)
+{
+  if(sArg.compare(0, sName.size() + 1, sName + "=") != 0) return false;
+  sValue = sArg.substr(sName.size() + 1);
+  return true;
+}
+
+
+int main(int argc, char** argv)
+{
+  cv::Size2i imSize(640, 480);
+  RenderSettings settings;
+  int nSeed = 1;
+  string sJsonFile;
+
+  for(int i=1; i<argc; i++) {
+    string sArg = argv[i], sValue;
+    if(ParseOption(sArg, "--benchmark_filter", sValue)) gsFilter = sValue;
+    else if(ParseOption(sArg, "--benchmark_min_time", sValue)) gdMinTime = atof(sValue.c_str());
+    else if(ParseOption(sArg, "--benchmark_out", sValue)) sJsonFile = sValue;
+    else if(ParseOption(sArg, "--size", sValue)) {
+      if(sscanf(sValue.c_str(), "%dx%d", &imSize.width, &imSize.height) != 2) {
+	cout << "! Bad image size " << sValue << endl;
+	return 1;
+      }
+    }
+    else if(ParseOption(sArg, "--blur", sValue)) settings.dBlurSigma = atof(sValue.c_str());
+    else if(ParseOption(sArg, "--noise", sValue)) settings.dNoiseSigma = atof(sValue.c_str());
+    else if(ParseOption(sArg, "--seed", sValue)) nSeed = atoi(sValue.c_str());
+    else {
+      cout << "Usage: gcalibrator_bench [--benchmark_filter=text] [--benchmark_min_time=secs] [--benchmark_out=file.json]" << endl
+	   << "                         [--size=WxH] [--blur=pixels] [--noise=levels] [--seed=n]" << endl;
+      return 1;
+    }
+  }
+
+  // The scene: the default ATAN camera, and a set of views of the board from random poses.
+  // (Cameras register their parameters as PVars, so they are made here, on the main thread.)
+  GenericCamera<ATANModel> Camera("BenchCamera", imSize);
+  BoardRenderer<ATANModel> Renderer(Camera);
+  cv::RNG rng(nSeed);
+
+  const int nDistinctViews = 20;
+  // (a square is about 40 pixels across at 640x480 from 15 squares away)
+  const double dDistScale = imSize.width / 640.0;
+  vector<cv::Mat_<uchar> > vImages;
+  vector<CalibImage> vViews;
+  cout << "Rendering and detecting " << nDistinctViews << " views ..." << endl;
+  for(int nTries = 0; (int) vViews.size() < nDistinctViews && nTries < 10 * nDistinctViews; nTries++) {
+    RigidTransforms::SE3<> se3 = RandomPose(rng, 12.0 / dDistScale, 20.0 / dDistScale, 1.5, 0.5);
+    cv::Mat_<uchar> im = Renderer.Render(se3, settings, rng);
+    CalibImage ci;
+    cv::Mat cim;
+    bool bFound;
+    {
+      Silence silence;
+      bFound = ci.MakeFromImage(im, cim);
+      if(bFound) ci.GuessInitialPose(Camera);
+    }
+    if(!bFound) continue;
+    vImages.push_back(im);
+    vViews.push_back(ci);
+  }
+  if(vViews.empty()) {
+    cout << "! The grid was not found in any of the synthetic views." << endl;
+    return 1;
+  }
+  cout << vViews.size() << " views, " << vViews[0].GetGridCorners().size() << " grid corners in the first one." << endl << endl;
+
+  cout << left << setw(32) << "Benchmark" << right << setw(19) << "Time" << setw(19) << "CPU" << setw(12) << "Iterations" << endl;
+  cout << string(82, '-') << endl;
+
+  // The first view is the one the single-image benchmarks work on
+  cv::Mat_<uchar> &im = vImages[0];
+  // (blurred as MakeFromImage does it, with the defaults of CameraCalibrator.BlurSigma and MeanGate)
+  cv::Mat_<uchar> imBlurred;
+  cv::Mat BlurKernel = cv::getGaussianKernel(7, 2.0, CV_32F);
+  cv::sepFilter2D(im, imBlurred, -1, BlurKernel, BlurKernel);
+  const int nMeanGate = 20;
+
+  // 1. The corner candidate scan
+  vector<cv::Point2i> vCandidates;
+  Benchmark("ScanCorners", [&]() { vCandidates.clear(); ScanCornerCandidates(imBlurred, nMeanGate, vCandidates); },
+	    (imBlurred.rows - 10) * (imBlurred.cols - 10));
+
+  // 2. and 3. The corner patch steps, on a grid corner of the view
+  const CalibGridCorner &gc = vViews[0].GetGridCorners()[0];
+  cv::Point2i irCorner(cvRound(gc.Params.v2Pos[0]), cvRound(gc.Params.v2Pos[1]));
+  volatile float fSink = 0;  // (so that the results are not optimized away)
+  Benchmark("GuessInitialAngles", [&]() { fSink = GuessInitialAngles(im, irCorner)[0]; });
+
+  CalibCornerPatch Patch(20);                              // CameraCalibrator.CornerPatchPixelSize
+  CalibCornerPatch::Params StartParams;
+  StartParams.v2Pos = cv::Vec2f(irCorner.x, irCorner.y);
+  StartParams.v2Angles = GuessInitialAngles(im, irCorner);
+  StartParams.dGain = 80.0;
+  StartParams.dMean = 120.0;
+  Benchmark("IterateOnImage", [&]() { CalibCornerPatch::Params Params = StartParams; Patch.IterateOnImage(Params, im); });
+
+  // 4. and 5. The whole detection and the pose guess
+  Benchmark("MakeFromImage", [&]() { CalibImage ci; cv::Mat cim; ci.MakeFromImage(im, cim); });
+  CalibImage ciPose = vViews[0];
+  Benchmark("GuessInitialPose", [&]() { ciPose.GuessInitialPose(Camera); });
+
+  // 6. Optimization steps (the views are repeated to make up the larger counts)
+  const int anViewCounts[] = {10, 50, 200};
+  for(int n : anViewCounts) {
+    vector<CalibImage> vOptViews;
+    for(int i=0; i<n; i++) vOptViews.push_back(vViews[i % vViews.size()]);
+    ostringstream ost;
+    ost << "OptimizeOneStep/" << n;
+    double dRMS;
+    Benchmark(ost.str(), [&]() { CalibOptimizer<ATANModel>::OptimizeOneStep(vOptViews, Camera, false, ROBUST_NONE, 1.0, dRMS); });
+  }
+
+  // 7. FAST, on the raw image (with the barrier of CameraCalibrator.FastBarrier): the trees against the SIMD engine
+  const int nBarrier = 10;
+  BenchmarkFast("fast_corner_detect_plain_7", FAST::fast_corner_detect_plain_7, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_plain_8", FAST::fast_corner_detect_plain_8, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_plain_9", FAST::fast_corner_detect_plain_9, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_plain_10", FAST::fast_corner_detect_plain_10, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_plain_11", FAST::fast_corner_detect_plain_11, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_plain_12", FAST::fast_corner_detect_plain_12, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<4>", FAST::fast_corner_detect_simd<4>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<5>", FAST::fast_corner_detect_simd<5>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<6>", FAST::fast_corner_detect_simd<6>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<7>", FAST::fast_corner_detect_simd<7>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<8>", FAST::fast_corner_detect_simd<8>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<9>", FAST::fast_corner_detect_simd<9>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<10>", FAST::fast_corner_detect_simd<10>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<11>", FAST::fast_corner_detect_simd<11>, im, nBarrier);
+  BenchmarkFast("fast_corner_detect_simd<12>", FAST::fast_corner_detect_simd<12>, im, nBarrier);
+
+  if(!sJsonFile.empty()) {
+    ostringstream ostSize, ostSettings;
+    ostSize << imSize.width << "x" << imSize.height;
+    ostSettings << "blur " << settings.dBlurSigma << ", noise " << settings.dNoiseSigma << ", seed " << nSeed;
+    vector<pair<string, string> > vContext;
+    vContext.push_back(make_pair("image_size", ostSize.str()));
+    vContext.push_back(make_pair("scene", ostSettings.str()));
+    vContext.push_back(make_pair("views", to_string(vViews.size())));
+    if(!WriteJson(sJsonFile, vContext)) return 1;
+    cout << endl << "Results written to " << sJsonFile << endl;
+  }
+
+  return 0;
+}
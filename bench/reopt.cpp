@@ -0,0 +1,302 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// Offline re-optimization of saved calibration sessions (see CalibSession.h), for tuning the optimization
+// without recapturing. Every combination of session x camera model x robust kernel x view subset is a run:
+// its views are loaded from the session, the camera starts from the parameters and poses saved in the session
+// (or, if the model differs or -fresh is given, from the closed-form estimate and fresh pose guesses, as the live
+// calibrator does), and CalibOptimizer steps are taken until the RMS error stops changing, exactly as in the
+// live "Optimize" mode. The runs are spread over a pool of threads and end up in one comparison table.
+//
+// Usage: gcalibrator_reopt [options] session.gcs [more sessions]
+//   -m ATAN,RadTan,Fisheye           camera models (default: the model each session was saved with)
+//   -k none,huber,cauchy             robust kernels (default: none)
+//   -w <pixels>                      width of the robust kernels (default: 1)
+//   -v all,first:N,every:K,random:N  view subsets (default: all); random:N:<seed> for another draw
+//   -n <steps>                       most optimization steps per run (default: 2000)
+//   -j <threads>                     (default: one per core)
+//   -nodist                          no distortion (CameraCalibrator.NoDistortion)
+//   -fresh                           ignore the parameters and poses saved in the sessions
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include "../CalibSession.h"
+#include "../CalibOptimizer.h"
+#include "../CameraModels.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+
+
+typedef chrono::high_resolution_clock Clock;
+
+static double Seconds(Clock::time_point t0, Clock::time_point t1) { return chrono::duration<double>(t1 - t0).count(); }
+
+
+// A run: the settings, the results, and (in ModelRun) the views and the camera it works on.
+struct Run
+{
+  string sSession;
+  string sModel;
+  string sSubset;
+  RobustKernel eKernel;
+
+  int nViews;
+  int nSteps;
+  bool bConverged;
+  double dRMS;          // pixels
+  double dSeconds;
+  string sParams;
+
+  Run() : eKernel(ROBUST_NONE), nViews(0), nSteps(0), bConverged(false), dRMS(-1), dSeconds(0) {}
+  virtual ~Run() {}
+  virtual void Optimize(int nMaxSteps, double dKernelWidth, bool bDisableDistortion) = 0;
+};
+
+template<class CameraModel>
+struct ModelRun : public Run
+{
+  GenericCamera<CameraModel> Camera;
+  vector<CalibImage> vCalibImgs;   // (copies: CalibImage::Project works in buffers of the view)
+
+  ModelRun(const string &sCameraName, const cv::Size2i &imSize) : Camera(sCameraName, imSize) {}
+
+  // Runs on a worker thread. Everything it touches belongs to this run.
+  void Optimize(int nMaxSteps, double dKernelWidth, bool bDisableDistortion)
+  {
+    Clock::time_point t0 = Clock::now();
+    double dLastRMS = 0;
+    for(nSteps = 0; nSteps < nMaxSteps && !bConverged; nSteps++) {
+
+      if(!CalibOptimizer<CameraModel>::OptimizeOneStep(vCalibImgs, Camera, bDisableDistortion, eKernel, dKernelWidth, dRMS))
+	break;
+      // The same test as CameraCalibrator::Run()
+      bConverged = fabs(dLastRMS - dRMS) < 1e-4 * dRMS;
+      dLastRMS = dRMS;
+    }
+    dSeconds = Seconds(t0, Clock::now());
+
+    ostringstream ost;
+    ost << setprecision(5);
+    const typename GenericCamera<CameraModel>::ParamVector &vParams = Camera.GetParams();
+    for(int i=0; i<CameraModel::NumParams; i++) ost << (i ? " " : "") << vParams[i];
+    sParams = ost.str();
+  }
+};
+
+
+// Sets up a run of the views vViews of a session. This registers the camera's PVar, so it runs on the main thread.
+template<class CameraModel>
+static Run* MakeModelRun(int nRun, const CalibSessionFile &Session, const vector<int> &vViews, bool bFresh)
+{
+  const CalibSession::SessionHeader &H = Session.Header();
+  string sSavedModel(H.acCameraModel, strnlen(H.acCameraModel, sizeof(H.acCameraModel)));
+  bool bFromSession = !bFresh && sSavedModel == CameraModel::Name() && H.nCameraParams == (uint32_t) CameraModel::NumParams;
+
+  // The camera picks its parameters up from its PVar when it is made (as the live one does from camera.cfg)
+  ostringstream ostName;
+  ostName << "Reopt" << nRun;
+  typename GenericCamera<CameraModel>::ParamVector vParams = CameraModel::DefaultParams();
+  if(bFromSession)
+    for(int i=0; i<CameraModel::NumParams; i++) vParams[i] = H.afCameraParams[i];
+  Persistence::PV3::get<typename GenericCamera<CameraModel>::ParamVector>(ostName.str() + CameraModel::ParamsSuffix(), vParams, Persistence::SILENT);
+
+  ModelRun<CameraModel> *pRun = new ModelRun<CameraModel>(ostName.str(), cv::Size2i(H.nImageWidth, H.nImageHeight));
+  pRun->sModel = CameraModel::Name();
+  pRun->nViews = vViews.size();
+  pRun->vCalibImgs.resize(vViews.size());
+  for(unsigned int i=0; i<vViews.size(); i++) Session.MakeCalibImage(vViews[i], pRun->vCalibImgs[i]);
+
+  if(!bFromSession) {
+    CalibOptimizer<CameraModel>::InitializeIntrinsics(pRun->vCalibImgs, pRun->Camera);
+    for(unsigned int i=0; i<pRun->vCalibImgs.size(); i++) pRun->vCalibImgs[i].GuessInitialPose(pRun->Camera);
+  }
+  return pRun;
+}
+
+static Run* MakeRun(const string &sModel, int nRun, const CalibSessionFile &Session, const vector<int> &vViews, bool bFresh)
+{
+  if(sModel == ATANModel::Name()) return MakeModelRun<ATANModel>(nRun, Session, vViews, bFresh);
+  if(sModel == RadTanModel::Name()) return MakeModelRun<RadTanModel>(nRun, Session, vViews, bFresh);
+  if(sModel == FisheyeModel::Name()) return MakeModelRun<FisheyeModel>(nRun, Session, vViews, bFresh);
+  return NULL;
+}
+
+
+static vector<string> SplitList(const string &sList)
+{
+  vector<string> vItems;
+  istringstream ist(sList);
+  string sItem;
+  while(getline(ist, sItem, ','))
+    if(!sItem.empty()) vItems.push_back(sItem);
+  return vItems;
+}
+
+// The views of a subset ("all", "first:N", "every:K", "random:N" or "random:N:seed"), in increasing order.
+static bool ParseSubset(const string &sSubset, int nTotal, vector<int> &vViews)
+{
+  vector<string> vFields;
+  istringstream ist(sSubset);
+  string sField;
+  while(getline(ist, sField, ':')) vFields.push_back(sField);
+  if(vFields.empty()) return false;
+
+  vViews.clear();
+  int nArg = vFields.size() > 1 ? atoi(vFields[1].c_str()) : 0;
+  if(vFields[0] == "all" && vFields.size() == 1)
+    for(int i=0; i<nTotal; i++) vViews.push_back(i);
+  else if(vFields[0] == "first" && vFields.size() == 2 && nArg > 0)
+    for(int i=0; i<std::min(nArg, nTotal); i++) vViews.push_back(i);
+  else if(vFields[0] == "every" && vFields.size() == 2 && nArg > 0)
+    for(int i=0; i<nTotal; i+=nArg) vViews.push_back(i);
+  else if(vFields[0] == "random" && (vFields.size() == 2 || vFields.size() == 3) && nArg > 0) {
+    vector<int> vAll(nTotal);
+    for(int i=0; i<nTotal; i++) vAll[i] = i;
+    cv::RNG rng(vFields.size() == 3 ? (uint64_t) atoll(vFields[2].c_str()) : (uint64_t) 0x5eed);
+    for(int i=nTotal-1; i>0; i--) std::swap(vAll[i], vAll[rng.uniform(0, i + 1)]); // Fisher-Yates
+    vViews.assign(vAll.begin(), vAll.begin() + std::min(nArg, nTotal));
+    sort(vViews.begin(), vViews.end());
+  }
+  else return false;
+
+  return !vViews.empty();
+}
+
+static bool ParseKernel(const string &sKernel, RobustKernel &eKernel)
+{
+  const RobustKernel aeKernels[] = { ROBUST_NONE, ROBUST_HUBER, ROBUST_CAUCHY };
+  for(int i=0; i<3; i++)
+    if(sKernel == RobustKernelName(aeKernels[i])) { eKernel = aeKernels[i]; return true; }
+  return false;
+}
+
+
+int main(int argc, char** argv)
+{
+  vector<string> vSessionNames;
+  vector<string> vModels;                    // empty: the model of each session
+  vector<string> vKernels(1, "none");
+  vector<string> vSubsets(1, "all");
+  double dKernelWidth = 1.0;
+  int nMaxSteps = 2000;
+  int nThreads = std::max(1u, thread::hardware_concurrency());
+  bool bDisableDistortion = false, bFresh = false;
+
+  for(int i=1; i<argc; i++) {
+    string sArg = argv[i];
+    bool bHasValue = i + 1 < argc;
+    if(sArg == "-m" && bHasValue) vModels = SplitList(argv[++i]);
+    else if(sArg == "-k" && bHasValue) vKernels = SplitList(argv[++i]);
+    else if(sArg == "-v" && bHasValue) vSubsets = SplitList(argv[++i]);
+    else if(sArg == "-w" && bHasValue) dKernelWidth = atof(argv[++i]);
+    else if(sArg == "-n" && bHasValue) nMaxSteps = atoi(argv[++i]);
+    else if(sArg == "-j" && bHasValue) nThreads = std::max(1, atoi(argv[++i]));
+    else if(sArg == "-nodist") bDisableDistortion = true;
+    else if(sArg == "-fresh") bFresh = true;
+    else if(sArg[0] == '-') {
+      cout << "! Unknown option " << sArg << endl;
+      return 1;
+    }
+    else vSessionNames.push_back(sArg);
+  }
+  if(vSessionNames.empty()) {
+    cout << "Usage: gcalibrator_reopt [-m models] [-k kernels] [-w width] [-v subsets] [-n steps] [-j threads] [-nodist] [-fresh] session.gcs ..." << endl;
+    return 1;
+  }
+
+  vector<RobustKernel> veKernels(vKernels.size());
+  for(unsigned int k=0; k<vKernels.size(); k++)
+    if(!ParseKernel(vKernels[k], veKernels[k])) {
+      cout << "! Unknown robust kernel " << vKernels[k] << endl;
+      return 1;
+    }
+
+  // Set up all the runs first (on this thread)
+  vector<shared_ptr<CalibSessionFile> > vpSessions;   // (the views of the runs keep pointing into these)
+  vector<shared_ptr<Run> > vpRuns;
+  for(unsigned int s=0; s<vSessionNames.size(); s++) {
+
+    shared_ptr<CalibSessionFile> pSession(new CalibSessionFile);
+    if(!pSession->Open(vSessionNames[s])) continue;
+    vpSessions.push_back(pSession);
+    const CalibSession::SessionHeader &H = pSession->Header();
+
+    vector<string> vSessionModels = vModels;
+    if(vSessionModels.empty()) vSessionModels.push_back(string(H.acCameraModel, strnlen(H.acCameraModel, sizeof(H.acCameraModel))));
+
+    for(unsigned int m=0; m<vSessionModels.size(); m++)
+      for(unsigned int k=0; k<veKernels.size(); k++)
+	for(unsigned int v=0; v<vSubsets.size(); v++) {
+
+	  vector<int> vViews;
+	  if(!ParseSubset(vSubsets[v], pSession->NumViews(), vViews)) {
+	    cout << "! Bad view subset " << vSubsets[v] << " for " << vSessionNames[s] << endl;
+	    continue;
+	  }
+	  Run *pRun = MakeRun(vSessionModels[m], vpRuns.size(), *pSession, vViews, bFresh);
+	  if(pRun == NULL) {
+	    cout << "! Unknown camera model " << vSessionModels[m] << endl;
+	    continue;
+	  }
+	  pRun->sSession = vSessionNames[s];
+	  pRun->sSubset = vSubsets[v];
+	  pRun->eKernel = veKernels[k];
+	  vpRuns.push_back(shared_ptr<Run>(pRun));
+	}
+  }
+  if(vpRuns.empty()) return 1;
+
+  // Runs are handed out through a shared counter, so faster threads pick up more of them
+  int nRuns = vpRuns.size();
+  atomic<int> nNextRun(0);
+  auto worker = [&]()
+  {
+    for(int r = nNextRun++; r < nRuns; r = nNextRun++)
+      vpRuns[r]->Optimize(nMaxSteps, dKernelWidth, bDisableDistortion);
+  };
+  Clock::time_point t0 = Clock::now();
+  vector<thread> vPool;
+  for(int i=1; i < std::min(nThreads, nRuns); i++)
+    vPool.push_back(thread(worker));
+  worker();
+  for(unsigned int i=0; i<vPool.size(); i++)
+    vPool[i].join();
+  double dWall = Seconds(t0, Clock::now());
+
+  // The comparison table
+  double dTotal = 0;
+  bool bAllRan = true;
+  cout << endl;
+  cout << left << setw(24) << "session" << setw(9) << "model" << setw(8) << "kernel" << setw(14) << "views"
+       << right << setw(7) << "steps" << setw(6) << "conv" << setw(10) << "RMS (px)" << setw(11) << "time (ms)"
+       << "  parameters" << endl;
+  for(int r=0; r<nRuns; r++) {
+    const Run &R = *vpRuns[r];
+    ostringstream ostViews;
+    ostViews << R.sSubset << " (" << R.nViews << ")";
+    cout << left << setw(24) << R.sSession.substr(0, 23) << setw(9) << R.sModel << setw(8) << RobustKernelName(R.eKernel)
+	 << setw(14) << ostViews.str()
+	 << right << setw(7) << R.nSteps << setw(6) << (R.bConverged ? "yes" : "no")
+	 << fixed << setprecision(4) << setw(10) << R.dRMS << setprecision(1) << setw(11) << R.dSeconds * 1e3
+	 << "  " << R.sParams << endl;
+    dTotal += R.dSeconds;
+    bAllRan = bAllRan && R.dRMS >= 0;
+  }
+  cout << nRuns << " runs on " << std::min(nThreads, nRuns) << " threads: " << setprecision(2) << dWall << " s ("
+       << dTotal << " s of optimization)" << endl;
+
+  return bAllRan ? 0 : 1;
+}
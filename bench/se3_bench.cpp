@@ -0,0 +1,181 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// Benchmark of the fixed-size (cv::Matx) SE3 against the previous cv::Mat_-backed rotation storage,
+// on the two things the calibrator does with poses in every optimization step:
+//  1. exp + compose: a pose update per view (SE3<>::exp(mu) * pose), as in OptimizeOneStep
+//  2. transform: the grid points of a view into the camera frame (pose * v3), as in Project/Draw3DGrid,
+//     one at a time and with the batch SE3::transform (array of points and separate coordinate arrays).
+// Every run also checks that the old and new paths agree.
+//
+// Usage: se3_bench [points per view = 100] [views = 30] [repetitions = 200]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "../GCVD/SE3.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+
+
+// The previous storage: the rotation in a (heap allocated) cv::Mat_, written by the same Rodrigues formula.
+struct MatSE3
+{
+  cv::Mat_<float> R;
+  cv::Vec3f t;
+
+  MatSE3() : R(cv::Mat_<float>::eye(3, 3)), t(0, 0, 0) {}
+
+  static MatSE3 exp(const cv::Vec<float, 6> &mu)
+  {
+    MatSE3 result;
+    const cv::Vec3f w(mu[3], mu[4], mu[5]);
+    const cv::Vec3f trans(mu[0], mu[1], mu[2]);
+    const float theta_sq = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+    const float theta = sqrt(theta_sq);
+    const cv::Vec3f cross = w ^ trans;
+    float A, B, C;
+    if(theta_sq < 1e-8) {
+      A = 1.0 - theta_sq / 6.0; B = 0.5; C = 1.0 / 6.0;
+    }
+    else {
+      A = sin(theta) / theta;
+      B = (1 - cos(theta)) / theta_sq;
+      C = (1 - A) / theta_sq;
+    }
+    result.t = trans + B * cross + C * (w ^ cross);
+
+    cv::Mat_<float> &Rm = result.R;
+    Rm(0, 0) = 1.0 - B * (w[1] * w[1] + w[2] * w[2]);
+    Rm(1, 1) = 1.0 - B * (w[0] * w[0] + w[2] * w[2]);
+    Rm(2, 2) = 1.0 - B * (w[0] * w[0] + w[1] * w[1]);
+    Rm(0, 1) = B * w[0] * w[1] - A * w[2]; Rm(1, 0) = B * w[0] * w[1] + A * w[2];
+    Rm(0, 2) = B * w[0] * w[2] + A * w[1]; Rm(2, 0) = B * w[0] * w[2] - A * w[1];
+    Rm(1, 2) = B * w[1] * w[2] - A * w[0]; Rm(2, 1) = B * w[1] * w[2] + A * w[0];
+    return result;
+  }
+
+  cv::Vec3f operator *(const cv::Vec3f &v) const
+  {
+    return cv::Vec3f(R(0, 0) * v[0] + R(0, 1) * v[1] + R(0, 2) * v[2] + t[0],
+		     R(1, 0) * v[0] + R(1, 1) * v[1] + R(1, 2) * v[2] + t[1],
+		     R(2, 0) * v[0] + R(2, 1) * v[1] + R(2, 2) * v[2] + t[2]);
+  }
+
+  MatSE3 operator *(const MatSE3 &right) const
+  {
+    MatSE3 result;
+    result.R = R * right.R;
+    result.t = (*this) * right.t;
+    return result;
+  }
+};
+
+
+typedef chrono::high_resolution_clock Clock;
+
+static double Seconds(Clock::time_point t0, Clock::time_point t1) { return chrono::duration<double>(t1 - t0).count(); }
+
+
+int main(int argc, char** argv)
+{
+  int nPoints = argc > 1 ? atoi(argv[1]) : 100;
+  int nViews = argc > 2 ? atoi(argv[2]) : 30;
+  int nReps = argc > 3 ? atoi(argv[3]) : 200;
+
+  // poses, small updates and grid points (a 10 x (nPoints/10) board, 1 unit squares)
+  cv::RNG rng(0x5eed);
+  vector<cv::Vec<float, 6> > vUpdates(nViews), vStart(nViews);
+  for(int v=0; v<nViews; v++)
+    for(int i=0; i<6; i++) {
+      vStart[v][i] = (float) rng.uniform(-0.5, 0.5) + (i == 2 ? 5.0f : 0.0f);
+      vUpdates[v][i] = (float) rng.uniform(-1e-3, 1e-3);
+    }
+  vector<cv::Vec3f> vGrid(nPoints);
+  vector<float> vX(nPoints), vY(nPoints), vZ(nPoints);
+  for(int i=0; i<nPoints; i++) {
+    vGrid[i] = cv::Vec3f((float)(i % 10), (float)(i / 10), 0);
+    vX[i] = vGrid[i][0]; vY[i] = vGrid[i][1]; vZ[i] = vGrid[i][2];
+  }
+
+  vector<MatSE3> vMatPoses(nViews);
+  vector<RigidTransforms::SE3<> > vPoses(nViews);
+  for(int v=0; v<nViews; v++) {
+    vMatPoses[v] = MatSE3::exp(vStart[v]);
+    vPoses[v] = RigidTransforms::SE3<>::exp(vStart[v]);
+  }
+
+  // 1. exp + compose
+  double dMatCompose = 1e30, dCompose = 1e30;
+  for(int r=0; r<nReps; r++) {
+
+    Clock::time_point t0 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      vMatPoses[v] = MatSE3::exp(vUpdates[v]) * vMatPoses[v];
+    Clock::time_point t1 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      vPoses[v] = RigidTransforms::SE3<>::exp(vUpdates[v]) * vPoses[v];
+    Clock::time_point t2 = Clock::now();
+
+    dMatCompose = std::min(dMatCompose, Seconds(t0, t1));
+    dCompose = std::min(dCompose, Seconds(t1, t2));
+  }
+
+  // 2. transform all the points of all the views
+  vector<cv::Vec3f> vMatOut(nPoints), vOut(nPoints), vBatchOut(nPoints);
+  vector<float> vXo(nPoints), vYo(nPoints), vZo(nPoints);
+  double dMatTransform = 1e30, dTransform = 1e30, dBatch = 1e30, dBatchSoA = 1e30;
+  double dMaxDiff = 0;
+  for(int r=0; r<nReps; r++) {
+
+    Clock::time_point t0 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      for(int i=0; i<nPoints; i++)
+	vMatOut[i] = vMatPoses[v] * vGrid[i];
+    Clock::time_point t1 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      for(int i=0; i<nPoints; i++)
+	vOut[i] = vPoses[v] * vGrid[i];
+    Clock::time_point t2 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      vPoses[v].transform(&vGrid[0], &vBatchOut[0], nPoints);
+    Clock::time_point t3 = Clock::now();
+    for(int v=0; v<nViews; v++)
+      vPoses[v].transform(&vX[0], &vY[0], &vZ[0], &vXo[0], &vYo[0], &vZo[0], nPoints);
+    Clock::time_point t4 = Clock::now();
+
+    dMatTransform = std::min(dMatTransform, Seconds(t0, t1));
+    dTransform = std::min(dTransform, Seconds(t1, t2));
+    dBatch = std::min(dBatch, Seconds(t2, t3));
+    dBatchSoA = std::min(dBatchSoA, Seconds(t3, t4));
+  }
+  // (the buffers hold the last view's points by now)
+  for(int i=0; i<nPoints; i++)
+    for(int k=0; k<3; k++) {
+      dMaxDiff = std::max(dMaxDiff, (double) fabs(vMatOut[i][k] - vOut[i][k]));
+      dMaxDiff = std::max(dMaxDiff, (double) fabs(vOut[i][k] - vBatchOut[i][k]));
+    }
+  for(int i=0; i<nPoints; i++)
+    dMaxDiff = std::max(dMaxDiff, (double) (fabs(vOut[i][0] - vXo[i]) + fabs(vOut[i][1] - vYo[i]) + fabs(vOut[i][2] - vZo[i])));
+
+  double dPoints = (double) nPoints * nViews;
+  cout << "SE3 kernels (" << nViews << " views, " << nPoints << " points per view, best of " << nReps << ")" << endl;
+  cout << fixed << setprecision(2);
+  cout << setw(28) << "exp + compose (ns/view)" << setw(12) << "cv::Mat_" << setw(10) << dMatCompose / nViews * 1e9
+       << setw(12) << "cv::Matx" << setw(10) << dCompose / nViews * 1e9
+       << setw(10) << dMatCompose / dCompose << "x" << endl;
+  cout << setw(28) << "pose * v3 (ns/point)" << setw(12) << "cv::Mat_" << setw(10) << dMatTransform / dPoints * 1e9
+       << setw(12) << "cv::Matx" << setw(10) << dTransform / dPoints * 1e9
+       << setw(10) << dMatTransform / dTransform << "x" << endl;
+  cout << setw(28) << "transform (ns/point)" << setw(12) << "array" << setw(10) << dBatch / dPoints * 1e9
+       << setw(12) << "x[],y[],z[]" << setw(10) << dBatchSoA / dPoints * 1e9
+       << setw(10) << dMatTransform / dBatchSoA << "x" << endl;
+  cout << "max difference between the paths: " << scientific << dMaxDiff << endl;
+
+  return dMaxDiff < 1e-3 ? 0 : 1;
+}
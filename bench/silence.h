@@ -0,0 +1,31 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+//
+// The detection code talks a lot (on cout) and draws (into the GL batch of the thread, see GLBatch.h).
+// The command line tools in bench/ want none of that while they time or measure it:
+//
+//     { Silence silence; ci.MakeFromImage(im, cim); }
+//
+// Silence sends cout nowhere for its lifetime, and drops whatever was drawn when it ends.
+
+#ifndef __BENCH_SILENCE_H
+#define __BENCH_SILENCE_H
+
+#include <iostream>
+#include <streambuf>
+
+#include "../GCVD/GLBatch.h"
+
+
+struct NullBuffer : public std::streambuf { int overflow(int c) { return c; } };
+
+struct Silence
+{
+  std::streambuf *pOld;
+  Silence() : pOld(std::cout.rdbuf(Buffer())) {}
+  ~Silence() { std::cout.rdbuf(pOld); GLXInterface::glBatch().Clear(); }
+
+  static NullBuffer* Buffer() { static NullBuffer buffer; return &buffer; }
+};
+
+#endif
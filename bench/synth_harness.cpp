@@ -0,0 +1,227 @@
+// George Terzakis 2016 - University of Portsmouth
+//
+// The synthetic-scene harness: detection and calibration checked against ground truth.
+//
+// The board of calib_pattern.pdf is rendered (see synthetic_board.h) through an ATAN camera of known parameters,
+// from random poses, with blur, vignetting and noise. Every image then goes through the calibrator's own pipeline:
+// MakeFromImage, GuessInitialPose, the closed-form intrinsics and CalibOptimizer steps until the RMS error stops
+// changing (as in the live "Optimize" mode, on a camera that starts from the default parameters). Then:
+//
+//   - the corner RMS: the distance of every detected grid corner from the true projection of the board corner it
+//     belongs to (the nearest one; detected corners more than 2 pixels away from any are counted as stray),
+//   - the share of the visible corners that were detected, and of the views in which the grid was found,
+//   - the errors of the recovered intrinsics (pixels) and of the distortion parameter,
+//   - the time of every stage (the Profiling stages of the pipeline, and the harness' own).
+//
+// Everything is seeded, so a given build always sees the same scenes: the harness is the regression gate for
+// changes to the detection and optimization kernels. It exits with 1 if any of the limits (-max-*, -min-*) is not met.
+//
+// Usage: gcalibrator_synth [options]
+//   -c fx,fy,cx,cy,w      true camera parameters (CameraModel::DefaultParams order; default: 0.9,1.2,0.52,0.48,0.1)
+//   -s <width>x<height>   image size (default: 640x480)
+//   -n <views>            (default: 20)
+//   -blur <pixels> -noise <gray levels> -vignetting <fraction>   (defaults: 1, 2, 0.3)
+//   -seed <n>             of the poses and the noise (default: 1)
+//   -steps <n>            most optimization steps (default: 2000)
+//   -max-corner-rms <pixels>   (default: 0.2)
+//   -max-focal-error <pixels>  (default: 2)
+//   -max-center-error <pixels> (default: 3)
+//   -max-dist-error <value>    of the distortion parameter (default: 0.01)
+//   -min-found <fraction>      of the views in which the grid must be found (default: 0.8)
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#include "../CalibImage.h"
+#include "../CalibOptimizer.h"
+#include "../CameraModels.h"
+#include "../Profiling.h"
+#include "../GCVD/GLBatch.h"
+
+#include "synthetic_board.h"
+#include "silence.h"
+
+#include "../OpenCV.h"
+
+using namespace std;
+using namespace SyntheticBoard;
+
+
+typedef GenericCamera<ATANModel>::ParamVector ParamVector;
+
+// The harness' own stages (the pipeline has its own, see Profiling.h)
+static Profiling::Stage gStageRender("Synth.Render"), gStageDetect("Synth.Detect"), gStagePose("Synth.Pose"),
+			gStageCalibrate("Synth.Calibrate");
+
+// A camera picks its parameters up from its PVar when it is made, so the PVar is set first
+static void SetCameraParams(const string &sName, const ParamVector &vParams)
+{
+  Persistence::PV3::get<ParamVector>(sName + ATANModel::ParamsSuffix(), vParams, Persistence::SILENT);
+}
+
+static bool ParseParams(const string &sList, ParamVector &vParams)
+{
+  istringstream ist(sList);
+  string sItem;
+  int n = 0;
+  while(getline(ist, sItem, ',')) {
+    if(n == ATANModel::NumParams) return false;
+    vParams[n++] = atof(sItem.c_str());
+  }
+  return n == ATANModel::NumParams;
+}
+
+
+int main(int argc, char** argv)
+{
+  ParamVector vTrueParams(0.9, 1.2, 0.52, 0.48, 0.1);
+  cv::Size2i imSize(640, 480);
+  int nViews = 20, nSeed = 1, nMaxSteps = 2000;
+  RenderSettings settings;
+  settings.dVignetting = 0.3;
+  double dMaxCornerRMS = 0.2, dMaxFocalError = 2.0, dMaxCenterError = 3.0, dMaxDistError = 0.01, dMinFound = 0.8;
+
+  for(int i=1; i<argc; i++) {
+    string sArg = argv[i];
+    bool bHasValue = i + 1 < argc;
+    if(sArg == "-c" && bHasValue) {
+      if(!ParseParams(argv[++i], vTrueParams)) {
+	cout << "! Need " << ATANModel::NumParams << " camera parameters, comma separated." << endl;
+	return 1;
+      }
+    }
+    else if(sArg == "-s" && bHasValue) {
+      if(sscanf(argv[++i], "%dx%d", &imSize.width, &imSize.height) != 2) {
+	cout << "! Bad image size " << argv[i] << endl;
+	return 1;
+      }
+    }
+    else if(sArg == "-n" && bHasValue) nViews = atoi(argv[++i]);
+    else if(sArg == "-blur" && bHasValue) settings.dBlurSigma = atof(argv[++i]);
+    else if(sArg == "-noise" && bHasValue) settings.dNoiseSigma = atof(argv[++i]);
+    else if(sArg == "-vignetting" && bHasValue) settings.dVignetting = atof(argv[++i]);
+    else if(sArg == "-seed" && bHasValue) nSeed = atoi(argv[++i]);
+    else if(sArg == "-steps" && bHasValue) nMaxSteps = atoi(argv[++i]);
+    else if(sArg == "-max-corner-rms" && bHasValue) dMaxCornerRMS = atof(argv[++i]);
+    else if(sArg == "-max-focal-error" && bHasValue) dMaxFocalError = atof(argv[++i]);
+    else if(sArg == "-max-center-error" && bHasValue) dMaxCenterError = atof(argv[++i]);
+    else if(sArg == "-max-dist-error" && bHasValue) dMaxDistError = atof(argv[++i]);
+    else if(sArg == "-min-found" && bHasValue) dMinFound = atof(argv[++i]);
+    else {
+      cout << "Usage: gcalibrator_synth [-c fx,fy,cx,cy,w] [-s WxH] [-n views] [-blur px] [-noise levels] [-vignetting f] [-seed n]" << endl
+	   << "                         [-steps n] [-max-corner-rms px] [-max-focal-error px] [-max-center-error px]" << endl
+	   << "                         [-max-dist-error e] [-min-found f]" << endl;
+      return 1;
+    }
+  }
+
+  // The true camera renders, the other one gets calibrated (from the default parameters)
+  SetCameraParams("SynthTrue", vTrueParams);
+  SetCameraParams("SynthCalib", ATANModel::DefaultParams());
+  GenericCamera<ATANModel> TrueCamera("SynthTrue", imSize);
+  GenericCamera<ATANModel> Camera("SynthCalib", imSize);
+  BoardRenderer<ATANModel> Renderer(TrueCamera);
+  cv::RNG rng(nSeed);
+
+  // 1. Detection, view by view, against the true corners
+  vector<CalibImage> vCalibImgs;
+  int nVisible = 0, nMatched = 0, nStray = 0;
+  double dSumSquaredCornerError = 0;
+  // (a square is about 40 pixels across at 640x480 from 15 squares away)
+  const double dDistScale = imSize.width / 640.0;
+  for(int n=0; n<nViews; n++) {
+
+    RigidTransforms::SE3<> se3True = RandomPose(rng, 12.0 / dDistScale, 20.0 / dDistScale, 1.5, 0.5);
+    cv::Mat_<uchar> im;
+    {
+      Profiling::ScopedTimer timer(gStageRender);
+      im = Renderer.Render(se3True, settings, rng);
+    }
+
+    CalibImage ci;
+    bool bFound;
+    {
+      Silence silence;
+      Profiling::ScopedTimer timer(gStageDetect);
+      cv::Mat cim;
+      bFound = ci.MakeFromImage(im, cim);
+    }
+
+    // The corners that MakeFromImage could have found: the whole corner patch is inside the image
+    vector<cv::Vec2f> vTruePos;
+    vector<cv::Point2i> vTrueGrid;
+    Renderer.TrueCorners(TrueCamera, se3True, 10, vTruePos, vTrueGrid);
+    nVisible += vTruePos.size();
+    if(!bFound) continue;
+
+    const vector<CalibGridCorner> &vgc = ci.GetGridCorners();
+    for(unsigned int i=0; i<vgc.size(); i++) {
+      double dBest = 1e10;
+      for(unsigned int j=0; j<vTruePos.size(); j++)
+	dBest = std::min(dBest, (double) cv::norm(vgc[i].Params.v2Pos - vTruePos[j]));
+      if(dBest > 2.0) { nStray++; continue; }
+      nMatched++;
+      dSumSquaredCornerError += dBest * dBest;
+    }
+    vCalibImgs.push_back(ci);
+  }
+  int nFound = vCalibImgs.size();
+  double dCornerRMS = nMatched > 0 ? sqrt(dSumSquaredCornerError / nMatched) : -1;
+
+  // 2. Calibration, as in the live Optimize mode
+  double dRMS = -1;
+  int nSteps = 0;
+  bool bConverged = false;
+  if(nFound > 0) {
+    Silence silence;
+    {
+      Profiling::ScopedTimer timer(gStagePose);
+      CalibOptimizer<ATANModel>::InitializeIntrinsics(vCalibImgs, Camera);
+      for(int i=0; i<nFound; i++) vCalibImgs[i].GuessInitialPose(Camera);
+    }
+    Profiling::ScopedTimer timer(gStageCalibrate);
+    double dLastRMS = 0;
+    for(nSteps = 0; nSteps < nMaxSteps && !bConverged; nSteps++) {
+      if(!CalibOptimizer<ATANModel>::OptimizeOneStep(vCalibImgs, Camera, false, ROBUST_NONE, 1.0, dRMS)) break;
+      bConverged = fabs(dLastRMS - dRMS) < 1e-4 * dRMS;
+      dLastRMS = dRMS;
+    }
+  }
+
+  // 3. The report
+  const ParamVector &vParams = Camera.GetParams();
+  double dFxError = fabs(vParams[0] - vTrueParams[0]) * imSize.width, dFyError = fabs(vParams[1] - vTrueParams[1]) * imSize.height;
+  double dCxError = fabs(vParams[2] - vTrueParams[2]) * imSize.width, dCyError = fabs(vParams[3] - vTrueParams[3]) * imSize.height;
+  double dDistError = fabs(vParams[4] - vTrueParams[4]);
+
+  cout << fixed << setprecision(4);
+  cout << "Scene: " << imSize.width << "x" << imSize.height << ", " << nViews << " views, blur " << settings.dBlurSigma
+       << ", noise " << settings.dNoiseSigma << ", vignetting " << settings.dVignetting << ", seed " << nSeed << endl;
+  cout << "True parameters:      " << vTrueParams << endl;
+  cout << "Recovered parameters: " << vParams << endl << endl;
+  cout << "Grid found in " << nFound << " of " << nViews << " views" << endl;
+  cout << "Corners: " << nMatched << " of " << nVisible << " visible detected (" << setprecision(1)
+       << (nVisible > 0 ? 100.0 * nMatched / nVisible : 0) << "%), " << nStray << " stray" << endl;
+  cout << setprecision(4) << "Corner RMS vs truth: " << dCornerRMS << " pixels" << endl;
+  cout << "Reprojection RMS:    " << dRMS << " pixels after " << nSteps << " steps" << (bConverged ? "" : " (not converged)") << endl;
+  cout << "Intrinsics error (pixels): fx " << dFxError << ", fy " << dFyError << ", cx " << dCxError << ", cy " << dCyError
+       << "; distortion " << dDistError << endl << endl;
+  cout << Profiling::Report() << endl;
+
+  // 4. The gate
+  bool bPass = true;
+  if(nFound < dMinFound * nViews) { cout << "FAIL: the grid was found in too few views" << endl; bPass = false; }
+  if(dCornerRMS < 0 || dCornerRMS > dMaxCornerRMS) { cout << "FAIL: corner RMS above " << dMaxCornerRMS << endl; bPass = false; }
+  if(!(std::max(dFxError, dFyError) <= dMaxFocalError)) { cout << "FAIL: focal length error above " << dMaxFocalError << endl; bPass = false; }
+  if(!(std::max(dCxError, dCyError) <= dMaxCenterError)) { cout << "FAIL: principal point error above " << dMaxCenterError << endl; bPass = false; }
+  if(!(dDistError <= dMaxDistError)) { cout << "FAIL: distortion error above " << dMaxDistError << endl; bPass = false; }
+  cout << (bPass ? "PASS" : "FAILED") << endl;
+
+  return bPass ? 0 : 1;
+}
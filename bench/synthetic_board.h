@@ -0,0 +1,167 @@
+// -*- c++ -*-
+// George Terzakis 2016 - University of Portsmouth
+//
+// Synthetic images of the calibration pattern, for the benchmarks and the synthetic-scene harness.
+//
+// The board is the one of calib_pattern.pdf: 8 x 12 squares (20mm each) printed on an A4 page, here in the
+// world units of the calibrator (one square = 1 unit, corners at integer coordinates), lying in the z = 0 plane
+// with its top left corner at the origin. Around the board there is the white margin of the page,
+// and around the page a uniform background.
+//
+// Every pixel is supersampled (nSuperSample x nSuperSample rays, traced back from the image through the camera
+// model and intersected with the board plane), then the image is blurred and darkened towards the corners (optics)
+// and noise is added (sensor).
+// The ray directions do not depend on the pose, so they are unprojected once per renderer.
+
+#ifndef __SYNTHETIC_BOARD_H
+#define __SYNTHETIC_BOARD_H
+
+#include <vector>
+#include <cmath>
+
+#include "../GenericCamera.h"
+#include "../GCVD/SE3.h"
+
+#include "../OpenCV.h"
+
+
+namespace SyntheticBoard {
+
+  const int SQUARES_X = 8;       // calib_pattern.pdf
+  const int SQUARES_Y = 12;
+  // The page around the board (in squares): A4 is 10.5 x 14.85 squares of 2cm, and the board is printed
+  // 1.25 squares from the left and 1.43 from the bottom.
+  const double PAGE_LEFT = -1.25, PAGE_RIGHT = 9.25;
+  const double PAGE_TOP = -1.42, PAGE_BOTTOM = 13.43;
+
+  struct RenderSettings
+  {
+    double dBlurSigma;     // pixels (0: no blur)
+    double dNoiseSigma;    // gray levels (0: no noise)
+    double dVignetting;    // brightness lost at the image corners, falling off with the squared distance from the center (0: none)
+    float fBlack, fWhite;  // gray levels of the squares and the page
+    float fBackground;     // gray level outside the page
+
+    RenderSettings() : dBlurSigma(1.0), dNoiseSigma(2.0), dVignetting(0), fBlack(30), fWhite(220), fBackground(90) {}
+  };
+
+  // A pose that sees the board from the front, from dDistance squares away, with its center
+  // at (dOffsetX, dOffsetY) squares off the optical axis, and the board tilted by the rotation v3Tilt (axis x angle)
+  inline RigidTransforms::SE3<> LookAtBoard(double dDistance, double dOffsetX, double dOffsetY, const cv::Vec3f &v3Tilt)
+  {
+    RigidTransforms::SO3<> R(v3Tilt);
+    cv::Vec3f v3Center(SQUARES_X / 2.0, SQUARES_Y / 2.0, 0);
+    cv::Vec3f v3T = cv::Vec3f(dOffsetX, dOffsetY, dDistance) - R * v3Center;
+    return RigidTransforms::SE3<>(R, v3T);
+  }
+
+  // A random pose of the above: distance in [dMinDist, dMaxDist], offsets up to dMaxOffset
+  // and tilts of up to dMaxTilt radians about the x and y axes (any angle about z)
+  inline RigidTransforms::SE3<> RandomPose(cv::RNG &rng, double dMinDist, double dMaxDist, double dMaxOffset, double dMaxTilt)
+  {
+    cv::Vec3f v3Tilt(rng.uniform(-dMaxTilt, dMaxTilt), rng.uniform(-dMaxTilt, dMaxTilt), rng.uniform(-M_PI, M_PI));
+    return LookAtBoard(rng.uniform(dMinDist, dMaxDist), rng.uniform(-dMaxOffset, dMaxOffset), rng.uniform(-dMaxOffset, dMaxOffset), v3Tilt);
+  }
+
+
+  template<class CameraModel>
+  class BoardRenderer
+  {
+  public:
+    // The camera is used only here (to unproject the sample positions); the renderer keeps no reference to it
+    BoardRenderer(GenericCamera<CameraModel> &Camera, int nSuperSample = 3) : mnSuperSample(nSuperSample)
+    {
+      cv::Vec2f v2Size = Camera.GetImageSize();
+      mnWidth = v2Size[0]; mnHeight = v2Size[1];
+      mvRays.resize(mnWidth * mnHeight * mnSuperSample * mnSuperSample);
+      int i = 0;
+      for(int r=0; r<mnHeight; r++)
+	for(int c=0; c<mnWidth; c++)
+	  for(int sr=0; sr<mnSuperSample; sr++)
+	    for(int sc=0; sc<mnSuperSample; sc++)
+	      // (the samples are centered within the pixel, whose center is at the integer position)
+	      mvRays[i++] = Camera.UnProject(cv::Vec2f(c - 0.5 + (sc + 0.5) / mnSuperSample, r - 0.5 + (sr + 0.5) / mnSuperSample));
+    }
+
+    cv::Size2i ImageSize() const { return cv::Size2i(mnWidth, mnHeight); }
+
+    // The board as seen from se3CamFromWorld
+    cv::Mat_<uchar> Render(const RigidTransforms::SE3<> &se3CamFromWorld, const RenderSettings &settings, cv::RNG &rng) const
+    {
+      // X_cam = R X_world + t, so a ray lambda * (x, y, 1) hits z_world = 0 where lambda * (c3 . d) = c3 . t
+      // (c1, c2, c3 the columns of R), and the world point is R^T (lambda * d - t).
+      const cv::Matx33f &R = se3CamFromWorld.get_rotation().get_matrix();
+      const cv::Vec3f &t = se3CamFromWorld.get_translation();
+      const cv::Vec3f c1(R(0,0), R(1,0), R(2,0)), c2(R(0,1), R(1,1), R(2,1)), c3(R(0,2), R(1,2), R(2,2));
+      const float fC1t = c1.dot(t), fC2t = c2.dot(t), fC3t = c3.dot(t);
+
+      cv::Mat_<float> imf(mnHeight, mnWidth);
+      const int nSamples = mnSuperSample * mnSuperSample;
+      const cv::Vec2f *pRay = &mvRays[0];
+      for(int r=0; r<mnHeight; r++)
+	for(int c=0; c<mnWidth; c++) {
+	  float fSum = 0;
+	  for(int s=0; s<nSamples; s++, pRay++) {
+	    const cv::Vec2f &d = *pRay;
+	    float fDenom = c3[0] * d[0] + c3[1] * d[1] + c3[2];
+	    float fLambda = fC3t / fDenom;
+	    if(fDenom == 0 || fLambda <= 0) { fSum += settings.fBackground; continue; } // the plane is not in front of the camera here
+	    float fX = fLambda * (c1[0] * d[0] + c1[1] * d[1] + c1[2]) - fC1t;
+	    float fY = fLambda * (c2[0] * d[0] + c2[1] * d[1] + c2[2]) - fC2t;
+	    fSum += Shade(fX, fY, settings);
+	  }
+	  imf(r, c) = fSum / nSamples;
+	}
+
+      if(settings.dBlurSigma > 0)
+	cv::GaussianBlur(imf, imf, cv::Size(0, 0), settings.dBlurSigma);
+
+      cv::Mat_<uchar> im(mnHeight, mnWidth);
+      const float fCenterX = 0.5f * (mnWidth - 1), fCenterY = 0.5f * (mnHeight - 1);
+      const float fVignetting = settings.dVignetting / (fCenterX * fCenterX + fCenterY * fCenterY);
+      for(int r=0; r<mnHeight; r++)
+	for(int c=0; c<mnWidth; c++) {
+	  float fVal = imf(r, c);
+	  if(fVignetting > 0) fVal *= 1.0f - fVignetting * ((c - fCenterX) * (c - fCenterX) + (r - fCenterY) * (r - fCenterY));
+	  if(settings.dNoiseSigma > 0) fVal += rng.gaussian(settings.dNoiseSigma);
+	  im(r, c) = cv::saturate_cast<uchar>(fVal);
+	}
+      return im;
+    }
+
+    // The true image positions of the inner corners of the board (the ones that MakeFromImage looks for)
+    // that are in front of the camera and at least nBorder pixels inside the image. vGridPos gets their world coordinates.
+    void TrueCorners(GenericCamera<CameraModel> &Camera, const RigidTransforms::SE3<> &se3CamFromWorld, int nBorder,
+		     std::vector<cv::Vec2f> &vImagePos, std::vector<cv::Point2i> &vGridPos) const
+    {
+      vImagePos.clear(); vGridPos.clear();
+      for(int y=1; y<SQUARES_Y; y++)
+	for(int x=1; x<SQUARES_X; x++) {
+	  cv::Vec3f v3Cam = se3CamFromWorld * cv::Vec3f(x, y, 0);
+	  if(v3Cam[2] <= 0) continue;
+	  cv::Vec2f v2Pos = Camera.Project(cv::Vec2f(v3Cam[0] / v3Cam[2], v3Cam[1] / v3Cam[2]));
+	  if(Camera.Invalid()) continue;
+	  if(v2Pos[0] < nBorder || v2Pos[1] < nBorder || v2Pos[0] >= mnWidth - nBorder || v2Pos[1] >= mnHeight - nBorder) continue;
+	  vImagePos.push_back(v2Pos);
+	  vGridPos.push_back(cv::Point2i(x, y));
+	}
+    }
+
+  private:
+    static float Shade(float fX, float fY, const RenderSettings &settings)
+    {
+      if(fX >= 0 && fY >= 0 && fX < SQUARES_X && fY < SQUARES_Y)
+	return ((int) fX + (int) fY) % 2 == 0 ? settings.fBlack : settings.fWhite;
+      if(fX >= PAGE_LEFT && fY >= PAGE_TOP && fX < PAGE_RIGHT && fY < PAGE_BOTTOM)
+	return settings.fWhite;
+      return settings.fBackground;
+    }
+
+    int mnWidth, mnHeight;
+    int mnSuperSample;
+    std::vector<cv::Vec2f> mvRays;  // z=1 plane positions of all the samples, pixel by pixel
+  };
+
+} // namespace SyntheticBoard
+
+#endif